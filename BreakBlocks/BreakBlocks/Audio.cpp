@@ -0,0 +1,212 @@
+#include "Audio.h"
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#ifdef _WIN32
+#pragma comment(lib, "winmm.lib") // waveOut
+#endif
+
+// ============================================================
+// Audio
+// ============================================================
+
+// Sample at time t (seconds) of each sound; 'noise' is a per-sound stream
+float WaveBrickHit(float t, uint32_t&) { return (sinf(6.2831853f * 880.f * t) + 0.3f * sinf(6.2831853f * 1760.f * t)) * expf(-t * 60.f); }
+float WavePaddle(float t, uint32_t&) { return sinf(6.2831853f * 220.f * t) * expf(-t * 30.f); }
+float WavePowerUp(float t, uint32_t&) { return sinf(6.2831853f * (400.f + 2000.f * t) * t) * (1.f - t * 4.f); }
+float WaveBrickKill(float t, uint32_t& noise)
+{
+    noise ^= noise << 13;
+    noise ^= noise >> 17;
+    noise ^= noise << 5;
+    float n = (float)(noise >> 8) * (2.f / 16777216.f) - 1.f;
+    return (0.6f * n + 0.5f * sinf(6.2831853f * (300.f - 600.f * t) * t)) * expf(-t * 25.f);
+}
+
+struct SoundDef
+{
+    const char* name;
+    float seconds;
+    float gain;
+    float (*wave)(float t, uint32_t& noise);
+};
+
+static const SoundDef g_sounds[SOUND_COUNT] =
+{
+    { "brick hit",  0.05f, 0.25f, WaveBrickHit },
+    { "brick kill", 0.15f, 0.35f, WaveBrickKill },
+    { "paddle",     0.10f, 0.40f, WavePaddle },
+    { "power-up",   0.25f, 0.35f, WavePowerUp },
+};
+
+// The sample bank; everything else in a mixer starts out silent
+void InitAudioMixer(AudioMixer& m)
+{
+    for (int s = 0; s < SOUND_COUNT; ++s)
+    {
+        const SoundDef& def = g_sounds[s];
+        int length = ((int)(def.seconds * AUDIO_RATE) + 3) & ~3;
+        uint32_t noise = 0x2545F491u + s;
+        m.bank[s].assign(length, 0.f);
+        for (int i = 0; i < length; ++i)
+            m.bank[s][i] = def.gain * def.wave((float)i / AUDIO_RATE, noise);
+    }
+}
+
+// Simulation thread. Dropped (false), not waited for, if the mixer is a
+// whole queue behind.
+bool PushSound(SoundQueue& q, int sound, float pan)
+{
+    unsigned int head = q.head.load(std::memory_order_relaxed);
+    if (head - q.tail.load(std::memory_order_acquire) >= SOUND_QUEUE_SIZE) return false;
+
+    AudioCommand& c = q.commands[head & (SOUND_QUEUE_SIZE - 1)];
+    c.sound = sound;
+    c.pan = pan;
+    q.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+// Mixer. Starts the queued sounds, then mixes one block of 16-bit stereo
+// into 'out' (AUDIO_BLOCK frames).
+void MixAudio(AudioMixer& m, int16_t* out)
+{
+    unsigned int tail = m.queue.tail.load(std::memory_order_relaxed);
+    unsigned int head = m.queue.head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail)
+    {
+        const AudioCommand& c = m.queue.commands[tail & (SOUND_QUEUE_SIZE - 1)];
+        Voice* v = &m.voices[0];
+        for (int i = 0; i < AUDIO_VOICES && v->samples; ++i)
+            if (!m.voices[i].samples || m.voices[i].pos > v->pos) v = &m.voices[i];
+        v->samples = m.bank[c.sound].data();
+        v->length = (int)m.bank[c.sound].size();
+        v->pos = 0;
+        v->gainL = sqrtf(1.f - c.pan); // equal power
+        v->gainR = sqrtf(c.pan);
+        m.started++;
+    }
+    m.queue.tail.store(tail, std::memory_order_release);
+
+    memset(m.mixL, 0, sizeof(m.mixL));
+    memset(m.mixR, 0, sizeof(m.mixR));
+    for (int k = 0; k < AUDIO_VOICES; ++k)
+    {
+        Voice& v = m.voices[k];
+        if (!v.samples) continue;
+        int n = min(AUDIO_BLOCK, v.length - v.pos);
+        const float* s = v.samples + v.pos;
+        const __m128 gl = _mm_set1_ps(v.gainL), gr = _mm_set1_ps(v.gainR);
+        for (int i = 0; i < n; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(s + i);
+            _mm_store_ps(m.mixL + i, _mm_add_ps(_mm_load_ps(m.mixL + i), _mm_mul_ps(x, gl)));
+            _mm_store_ps(m.mixR + i, _mm_add_ps(_mm_load_ps(m.mixR + i), _mm_mul_ps(x, gr)));
+        }
+        v.pos += n;
+        if (v.pos >= v.length) v.samples = nullptr;
+    }
+
+    // Clip, scale and interleave to 16 bits
+    const __m128 lo = _mm_set1_ps(-1.f), hi = _mm_set1_ps(1.f), full = _mm_set1_ps(32767.f);
+    for (int i = 0; i < AUDIO_BLOCK; i += 4)
+    {
+        __m128 l = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_load_ps(m.mixL + i), lo), hi), full);
+        __m128 r = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_load_ps(m.mixR + i), lo), hi), full);
+        __m128i first = _mm_cvtps_epi32(_mm_unpacklo_ps(l, r));  // l0 r0 l1 r1
+        __m128i second = _mm_cvtps_epi32(_mm_unpackhi_ps(l, r)); // l2 r2 l3 r3
+        _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_packs_epi32(first, second));
+    }
+    m.frames += AUDIO_BLOCK;
+}
+
+// ------------------------------------------------------------
+// WAV file sink (headless)
+// ------------------------------------------------------------
+
+struct WavHeader
+{
+    char riff[4]; uint32_t riffSize; char wave[4];
+    char fmt[4]; uint32_t fmtSize; uint16_t format, channels;
+    uint32_t rate, byteRate; uint16_t blockAlign, bits;
+    char data[4]; uint32_t dataSize;
+};
+
+// 16-bit stereo at AUDIO_RATE; the sizes are filled in by CloseWav
+FILE* OpenWav(const char* path)
+{
+    FILE* f = NULL;
+    if (fopen_s(&f, path, "wb") != 0 || !f) return NULL;
+    WavHeader h = { { 'R', 'I', 'F', 'F' }, 0, { 'W', 'A', 'V', 'E' }, { 'f', 'm', 't', ' ' }, 16, 1, 2,
+                    (uint32_t)AUDIO_RATE, (uint32_t)AUDIO_RATE * 4, 4, 16, { 'd', 'a', 't', 'a' }, 0 };
+    fwrite(&h, sizeof(h), 1, f);
+    return f;
+}
+
+void CloseWav(FILE* f, uint64_t frames)
+{
+    uint32_t dataSize = (uint32_t)(frames * 4);
+    uint32_t riffSize = dataSize + (uint32_t)sizeof(WavHeader) - 8;
+    fseek(f, 4, SEEK_SET);
+    fwrite(&riffSize, 4, 1, f);
+    fseek(f, (long)sizeof(WavHeader) - 4, SEEK_SET);
+    fwrite(&dataSize, 4, 1, f);
+    fclose(f);
+}
+
+#ifdef _WIN32
+// ------------------------------------------------------------
+// Sound device (waveOut)
+// ------------------------------------------------------------
+// The mixer thread keeps AUDIO_BUFFERS blocks queued on the device (about
+// 46 ms) and refills each one as the device hands it back.
+
+static const int AUDIO_BUFFERS = 4;
+std::atomic<bool> g_audioQuit{ false };
+
+void AudioThread(AudioMixer* mixer, HWAVEOUT device, HANDLE blockDone)
+{
+    static int16_t blocks[AUDIO_BUFFERS][AUDIO_BLOCK * 2];
+    WAVEHDR headers[AUDIO_BUFFERS] = {};
+    for (int i = 0; i < AUDIO_BUFFERS; ++i)
+    {
+        headers[i].lpData = (LPSTR)blocks[i];
+        headers[i].dwBufferLength = sizeof(blocks[i]);
+        waveOutPrepareHeader(device, &headers[i], sizeof(WAVEHDR));
+        headers[i].dwFlags |= WHDR_DONE; // free to fill
+    }
+
+    while (!g_audioQuit)
+    {
+        for (int i = 0; i < AUDIO_BUFFERS; ++i)
+        {
+            if (!(headers[i].dwFlags & WHDR_DONE)) continue;
+            MixAudio(*mixer, blocks[i]);
+            headers[i].dwFlags &= ~WHDR_DONE;
+            waveOutWrite(device, &headers[i], sizeof(WAVEHDR));
+        }
+        WaitForSingleObject(blockDone, 20);
+    }
+
+    waveOutReset(device);
+    for (int i = 0; i < AUDIO_BUFFERS; ++i)
+        waveOutUnprepareHeader(device, &headers[i], sizeof(WAVEHDR));
+}
+
+// Opens the default device; false (and the game stays silent) if there is none
+bool OpenAudioDevice(HWAVEOUT& device, HANDLE& blockDone)
+{
+    WAVEFORMATEX format = {};
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = 2;
+    format.nSamplesPerSec = AUDIO_RATE;
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = 4;
+    format.nAvgBytesPerSec = AUDIO_RATE * 4;
+
+    blockDone = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (waveOutOpen(&device, WAVE_MAPPER, &format, (DWORD_PTR)blockDone, 0, CALLBACK_EVENT) == MMSYSERR_NOERROR)
+        return true;
+    CloseHandle(blockDone);
+    return false;
+}
+#endif // _WIN32
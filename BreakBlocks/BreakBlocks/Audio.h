@@ -0,0 +1,81 @@
+// ============================================================
+// BreakBlocks audio
+//
+// Sound effects for brick hits and kills, paddle bounces and power-up
+// catches. The simulation never waits on audio: it queues a command on a
+// lock-free single-producer queue (like the input queue, the other way
+// round) and a mixer drains it a block at a time, so only the thread that
+// runs the ticks may queue sounds. Sounds are synthesized once into a
+// sample bank when the mixer is created; mixing after that allocates
+// nothing. Like hooks.particles, a game's hooks.audio is only set where
+// something listens.
+// ============================================================
+
+#pragma once
+
+#include "Game.h"
+
+enum SoundId
+{
+    SOUND_BRICK_HIT,
+    SOUND_BRICK_KILL,
+    SOUND_PADDLE,
+    SOUND_POWERUP,
+    SOUND_COUNT
+};
+
+static const int AUDIO_RATE = 44100;
+static const int AUDIO_BLOCK = 512;                 // frames per mix, a multiple of 4
+static const int AUDIO_VOICES = 32;                 // the oldest voice is cut for a new one
+static const unsigned int SOUND_QUEUE_SIZE = 256;   // power of two
+
+struct AudioCommand
+{
+    int sound;
+    float pan; // 0 = left .. 1 = right
+};
+
+struct SoundQueue
+{
+    AudioCommand commands[SOUND_QUEUE_SIZE];
+    std::atomic<unsigned int> head{ 0 }; // written by the simulation thread
+    std::atomic<unsigned int> tail{ 0 }; // written by the mixer
+};
+
+struct Voice
+{
+    const float* samples = nullptr; // null = free
+    int length = 0, pos = 0;        // multiples of 4
+    float gainL = 0.f, gainR = 0.f;
+};
+
+struct alignas(16) AudioMixer
+{
+    float mixL[AUDIO_BLOCK], mixR[AUDIO_BLOCK];
+    Voice voices[AUDIO_VOICES];
+    TaggedVector<float, MEM_AUDIO> bank[SOUND_COUNT]; // mono, padded to a multiple of 4
+    SoundQueue queue;
+    uint64_t frames = 0;  // mixed so far
+    uint64_t started = 0; // sounds started so far
+
+    MEM_TAGGED_NEW(MEM_AUDIO)
+};
+
+void InitAudioMixer(AudioMixer& m);
+bool PushSound(SoundQueue& q, int sound, float pan);
+
+// Panned by where in the world it happened
+inline void QueueSound(const GameState& g, int sound, float x)
+{
+    PushSound(g.hooks.audio->queue, sound, Clamp(x / g.worldW, 0.f, 1.f));
+}
+
+void MixAudio(AudioMixer& m, int16_t* out);
+FILE* OpenWav(const char* path);
+void CloseWav(FILE* f, uint64_t frames);
+
+#ifdef _WIN32
+extern std::atomic<bool> g_audioQuit;
+void AudioThread(AudioMixer* mixer, HWAVEOUT device, HANDLE blockDone);
+bool OpenAudioDevice(HWAVEOUT& device, HANDLE& blockDone);
+#endif // _WIN32
@@ -0,0 +1,769 @@
+#include "Tools.h"
+#include "Audio.h"
+#include "Particles.h"
+#include "Render.h"
+#include "ScoreStore.h"
+#include "Telemetry.h"
+#include "BreakBlocksEnv.h"
+
+// ============================================================
+// Benchmarks (BreakBlocks.exe /bench)
+// ============================================================
+
+// Every correctness check in the suite goes through Verdict, so a failed
+// one fails /bench, not just its line of output.
+static int g_benchFailures = 0;
+
+const char* Verdict(bool ok, const char* pass, const char* fail)
+{
+    if (!ok) g_benchFailures++;
+    return ok ? pass : fail;
+}
+
+// Headless stand-in for HandleInput: the paddle chases the lowest falling
+// ball, hitting it slightly off-center so rallies don't settle into a loop.
+void BenchAutopilot(GameState& g, int tick)
+{
+    int target = -1;
+    float lowest = -1e9f;
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        const Ball& b = g.ball[i];
+        if (b.alive && b.vy > 0.f && b.y > lowest) { lowest = b.y; target = i; }
+    }
+
+    g.paddlePrevX = g.paddle.x;
+    if (target >= 0)
+    {
+        float aim = 0.5f + 0.1f * (float)(tick % 7 - 3);
+        g.paddle.x = Clamp(g.ball[target].x - g.paddle.w * aim, 0.f, (float)g.worldW - g.paddle.w);
+    }
+    g.paddleVX = g.paddle.x - g.paddlePrevX;
+
+    if (g.gameOver) InitGame(g);
+    if (!g.ballLaunched) g.ballLaunched = true;
+}
+
+// FNV-1a over everything the simulation owns; equal hashes after the same
+// ticks from the same seed mean the two runs played out identically.
+unsigned int HashSimulationState(const GameState& g)
+{
+    unsigned int h = 2166136261u;
+    auto mix = [&h](const void* p, size_t n)
+    {
+        const unsigned char* bytes = (const unsigned char*)p;
+        for (size_t i = 0; i < n; ++i) { h ^= bytes[i]; h *= 16777619u; }
+    };
+
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        const Ball& b = g.ball[i];
+        if (!b.alive) continue;
+        mix(&b.x, sizeof(float) * 5);
+        mix(&b.penetrateCount, sizeof(int));
+    }
+    mix(g.brickHits.data(), g.brickHits.size());
+    mix(&g.score, sizeof(int));
+    mix(&g.lives, sizeof(int));
+    return h;
+}
+
+template<class Board>
+double BenchBoardTurn(GameState& g, int from, int to)
+{
+    double start = QpcSeconds();
+    for (int t = from; t < to; ++t)
+    {
+        BenchAutopilot(g, t);
+        StepSimulationOn<Board>(g);
+    }
+    return QpcSeconds() - start;
+}
+
+// The same seeded session on the default board through both policies: the
+// StaticBoard instantiation on the inline storage against RuntimeBoard.
+// They take turns like the telemetry bench, and the speedup is the median
+// of the per-turn ratios.
+void BenchBoardConfigs()
+{
+    const int TURNS = 200, TURN_TICKS = 10000;
+    GameState fixed, runtime;
+    InitGameState(fixed, 12345);
+    runtime = fixed;
+    std::vector<double> ratios;
+    double tStatic = 0.0, tRuntime = 0.0;
+
+    for (int turn = 0; turn < TURNS; ++turn)
+    {
+        int from = turn * TURN_TICKS, to = from + TURN_TICKS;
+        double s, r;
+        if (turn & 1)
+        {
+            r = BenchBoardTurn<RuntimeBoard>(runtime, from, to);
+            s = BenchBoardTurn<DefaultBoard>(fixed, from, to);
+        }
+        else
+        {
+            s = BenchBoardTurn<DefaultBoard>(fixed, from, to);
+            r = BenchBoardTurn<RuntimeBoard>(runtime, from, to);
+        }
+        tStatic += s;
+        tRuntime += r;
+        ratios.push_back(r / s);
+    }
+    std::sort(ratios.begin(), ratios.end());
+    bool same = HashSimulationState(fixed) == HashSimulationState(runtime) &&
+                fixed.level == runtime.level && fixed.rngState == runtime.rngState;
+
+    const int ticks = TURNS * TURN_TICKS;
+    printf("board %dx%d, %d balls, %d ticks\n", BRICK_ROWS, BRICK_COLS, BALL_CAP, ticks);
+    printf("  specialized: %8.1f ns/tick\n", tStatic * 1e9 / ticks);
+    printf("  generic:     %8.1f ns/tick\n", tRuntime * 1e9 / ticks);
+    printf("  speedup:     %8.2fx  median of %d turns (%s)\n", ratios[TURNS / 2], TURNS,
+        Verdict(same, "results match", "RESULTS DIFFER"));
+}
+
+// Cost of recording telemetry. Two copies of the same default game take
+// turns, 10,000 ticks at a time, one recording and one not; the median of
+// the per-turn time ratios is the overhead, so drift in machine speed over
+// the run cancels out. Telemetry only observes, so both games must stay the
+// same throughout.
+void BenchTelemetry()
+{
+    const int TURNS = 200, TURN_TICKS = 10000;
+    GameState games[2];
+    InitGameState(games[0], 12345);
+    games[1] = games[0];
+    Telemetry telemetry;
+    AttachTelemetry(games[1], &telemetry);
+    std::vector<double> ratios;
+    double total[2] = {};
+
+    for (int turn = 0; turn < TURNS; ++turn)
+    {
+        double elapsed[2];
+        for (int k = 0; k < 2; ++k)
+        {
+            int i = k ^ (turn & 1); // alternate which goes first
+            GameState& g = games[i];
+            double start = QpcSeconds();
+            for (int t = turn * TURN_TICKS; t < (turn + 1) * TURN_TICKS; ++t)
+            {
+                BenchAutopilot(g, t);
+                StepSimulation(g);
+            }
+            elapsed[i] = QpcSeconds() - start;
+            total[i] += elapsed[i];
+        }
+        ratios.push_back(elapsed[1] / elapsed[0]);
+    }
+    std::sort(ratios.begin(), ratios.end());
+    bool same = games[0].score == games[1].score && games[0].level == games[1].level &&
+                games[0].lives == games[1].lives && games[0].rngState == games[1].rngState;
+
+    uint32_t hits = 0, contacts = 0;
+    for (size_t i = 0; i < telemetry.brickHits.size(); ++i) hits += telemetry.brickHits[i];
+    for (int i = 0; i < PADDLE_ZONES; ++i) contacts += telemetry.paddleZones[i];
+
+    const int ticks = TURNS * TURN_TICKS;
+    printf("telemetry, %d ticks (%u brick hits, %u paddle contacts recorded)\n", ticks, hits, contacts);
+    printf("  off:         %8.1f ns/tick\n", total[0] * 1e9 / ticks);
+    printf("  on:          %8.1f ns/tick\n", total[1] * 1e9 / ticks);
+    printf("  overhead:    %8.2f%%  median of %d turns (%s)\n", (ratios[TURNS / 2] - 1.0) * 100.0, TURNS,
+        Verdict(same, "results match", "RESULTS DIFFER"));
+}
+
+// Accuracy of the bounce table against the direct formula over a dense
+// sweep of hit positions, then throughput at a contact on every call.
+void BenchPaddleBounce()
+{
+    const float MAX_ERROR = 1e-3f; // radians
+    const float MAX_SPEED_ERROR = 1e-5f;
+    InitPaddleBounceTable();
+
+    float maxAngleErr = 0.f, maxSpeedErr = 0.f;
+    for (int i = 0; i <= 200000; ++i)
+    {
+        float hit = -1.05f + 2.1f * (float)i / 200000.f;
+        float ax = 3.f, ay = 4.f, rx = 3.f, ry = 4.f;
+        PaddleBounce(hit, ax, ay);
+        PaddleBounceReference(hit, rx, ry);
+
+        float err = fabsf(atan2f(ax, -ay) - atan2f(rx, -ry));
+        float speedErr = fabsf(sqrtf(ax * ax + ay * ay) - 5.f) / 5.f;
+        if (err > maxAngleErr) maxAngleErr = err;
+        if (speedErr > maxSpeedErr) maxSpeedErr = speedErr;
+    }
+
+    // A batch of simultaneous contacts (ball-storm), bounced repeatedly
+    const int BATCH = 4096;
+    const int ROUNDS = 5000;
+    const int CONTACTS = BATCH * ROUNDS;
+    std::vector<float> hit(BATCH), vx(BATCH), vy(BATCH);
+    for (int i = 0; i < BATCH; ++i)
+    {
+        hit[i] = -1.f + 2.f * (float)((i * 97) % BATCH) / (BATCH - 1);
+        vx[i] = 2.f + (i & 3);
+        vy[i] = 5.f;
+    }
+
+    double start = QpcSeconds();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < BATCH; ++i)
+            PaddleBounceReference(hit[i], vx[i], vy[i]);
+    double tRef = QpcSeconds() - start;
+
+    start = QpcSeconds();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < BATCH; ++i)
+            PaddleBounce(hit[i], vx[i], vy[i]);
+    double tTable = QpcSeconds() - start;
+
+    float sink = 0.f;
+    for (int i = 0; i < BATCH; ++i)
+        sink += vx[i] + vy[i];
+
+    printf("paddle bounce, %d contacts\n", CONTACTS);
+    printf("  max angle error: %.2e rad (%s, bound %.0e)\n", maxAngleErr,
+        Verdict(maxAngleErr <= MAX_ERROR, "ok", "FAIL"), MAX_ERROR);
+    printf("  max speed error: %.2e (%s, bound %.0e)\n", maxSpeedErr,
+        Verdict(maxSpeedErr <= MAX_SPEED_ERROR, "ok", "FAIL"), MAX_SPEED_ERROR);
+    printf("  reference:   %8.2f ns/contact\n", tRef * 1e9 / CONTACTS);
+    printf("  table:       %8.2f ns/contact\n", tTable * 1e9 / CONTACTS);
+    printf("  speedup:     %8.2fx  (checksum %.3f)\n", tRef / tTable, sink);
+}
+
+// The largest stress board: brick storage per cell and the cost of a tick.
+void BenchLargeBoard()
+{
+    const int DIM = MAX_BOARD_DIM, BALLS = 4000, TICKS = 30;
+    printf("large board, %dx%d, %d balls, %d ticks\n", DIM, DIM, BALLS, TICKS);
+
+    GameState g;
+    SeedGameRand(g, 4242);
+    InitStressGame(g, DIM, DIM, BALLS);
+    printf("  brick storage: %zu bytes, %.2f per brick\n", g.brickHits.size(),
+        (double)g.brickHits.size() / ((double)DIM * DIM));
+
+    double start = QpcSeconds();
+    for (int t = 0; t < TICKS; ++t)
+        StepSimulation(g);
+    double elapsed = QpcSeconds() - start;
+    printf("  tick:          %8.3f ms  (score %d)\n", elapsed * 1e3 / TICKS, g.score);
+}
+
+// Ball/ball collisions in ball storms of growing size: whole ticks with them
+// on, then one more broadphase pass (re-sorting after a tick of motion, as
+// in play) against the all-pairs check it replaces, which must find the
+// same overlaps.
+void BenchBallCollisions()
+{
+    const int counts[] = { 250, 1000, 4000, 16000 };
+    const int TICKS = 60;
+    printf("ball/ball collisions, sort-and-sweep vs all pairs, %d ticks\n", TICKS);
+
+    GameState g;
+    for (size_t k = 0; k < sizeof(counts) / sizeof(counts[0]); ++k)
+    {
+        const int balls = counts[k];
+        g = GameState();
+        SeedGameRand(g, 31337);
+        InitStressGame(g, 10, 200, balls);
+        g.ballCollisions = true;
+
+        double start = QpcSeconds();
+        for (int t = 0; t < TICKS; ++t)
+            StepSimulation(g);
+        double tick = (QpcSeconds() - start) / TICKS;
+
+        start = QpcSeconds();
+        FindBallPairs(g);
+        double sweep = QpcSeconds() - start;
+
+        start = QpcSeconds();
+        size_t pairs = 0;
+        for (int i = 0; i < g.ballCap; ++i)
+        {
+            const Ball& a = g.ball[i];
+            if (!a.alive || a.stuck) continue;
+            for (int j = i + 1; j < g.ballCap; ++j)
+            {
+                const Ball& b = g.ball[j];
+                float dx = b.x - a.x, dy = b.y - a.y, rr = a.r + b.r;
+                pairs += b.alive && !b.stuck && dx * dx + dy * dy < rr * rr;
+            }
+        }
+        double allPairs = QpcSeconds() - start;
+
+        printf("  %5d balls: tick %7.3f ms  sweep %7.3f ms  all pairs %8.3f ms  %5.1fx  %zu overlaps %s\n",
+            balls, tick * 1e3, sweep * 1e3, allPairs * 1e3, allPairs / sweep, pairs,
+            Verdict(pairs == g.scratch.ballPairs.size(), "match", "MISMATCH"));
+    }
+}
+
+// Every power-up caught and run out over a ball storm, one effect table
+// row at a time, and a burst of Chaos pickups landing on the same tick.
+void BenchPowerUps()
+{
+    const int BALLS = 4000, ROUNDS = 200, CHAOS = 50;
+    printf("power-ups, %d balls, catch + expiry\n", BALLS);
+
+    GameState g;
+    SeedGameRand(g, 2024);
+    InitStressGame(g, 10, 200, BALLS);
+    for (int i = 0; i < g_powerUpCount; ++i)
+    {
+        const PowerUpDef& def = g_powerUps[i];
+        double start = QpcSeconds();
+        for (int r = 0; r < ROUNDS; ++r)
+        {
+            ApplyPowerUp(g, i);
+            for (int k = 0; k < MAX_ACTIVE_POWERUPS; ++k)
+                if (g.activePowerUps[k].timer > 0) g.activePowerUps[k].timer = 1;
+            UpdateActivePowerUps(g);
+            for (int k = 0; k < MAX_FALLING_POWERUPS; ++k) g.fallingPowerUps[k].alive = false;
+        }
+        double elapsed = (QpcSeconds() - start) / ROUNDS;
+        printf("  %-14s %8.2f us  %6.2f ns/ball\n", def.name, elapsed * 1e6, elapsed * 1e9 / BALLS);
+    }
+
+    int chaos = 0;
+    while (chaos < g_powerUpCount && !HasEffect(g_powerUps[chaos], EFFECT_DROPS)) chaos++;
+    ResetPowerUps(g);
+    double start = QpcSeconds();
+    for (int i = 0; i < CHAOS; ++i) ApplyPowerUp(g, chaos);
+    double elapsed = QpcSeconds() - start;
+    int falling = 0;
+    for (int k = 0; k < MAX_FALLING_POWERUPS; ++k) falling += g.fallingPowerUps[k].alive;
+    printf("  %d Chaos in one tick: %.2f us, %d falling\n", CHAOS, elapsed * 1e6, falling);
+}
+
+// A pool kept at 100,000 particles by bursts of debris: per tick, the
+// update (emission, SSE motion, culling) and the batched draw into an
+// 800x600 pixel buffer, against the 60 Hz budget. The SSE motion must match
+// the scalar loop bit for bit.
+void BenchParticles()
+{
+    const int TARGET = 100000, TICKS = 600;
+    printf("particles, %d live, %d ticks\n", TARGET, TICKS);
+
+    ParticlePool* pool = new ParticlePool;
+    ParticlePool* check = new ParticlePool;
+    std::vector<uint32_t> pixels((size_t)SCREEN_W * SCREEN_H);
+    GameState none; // no balls, so no trails: every particle comes from the bursts
+
+    double update = 0.0, draw = 0.0;
+    for (int t = 0; t < TICKS; ++t)
+    {
+        double start = QpcSeconds();
+        while (pool->count < TARGET)
+        {
+            float x = (float)(pool->rng % SCREEN_W), y = (float)(pool->rng % (SCREEN_H / 2));
+            EmitParticles(*pool, x, y, 0.f, -1.f, 24, 3.f, 60.f, PixelColor(GetBrickColor(1 + t % 5)));
+        }
+        AdvanceParticles(none, *pool);
+        double mid = QpcSeconds();
+        DrawParticles(pool->x, pool->y, pool->color, pool->count, pixels.data(), SCREEN_W, SCREEN_W, SCREEN_H, ViewTransform{ 1.f, 0, 0 });
+        draw += QpcSeconds() - mid;
+        update += mid - start;
+    }
+
+    *check = *pool;
+    MoveParticles(*pool);
+    MoveParticlesReference(*check);
+    size_t n = pool->count * sizeof(float);
+    bool same = memcmp(pool->x, check->x, n) == 0 && memcmp(pool->y, check->y, n) == 0 &&
+                memcmp(pool->vy, check->vy, n) == 0 && memcmp(pool->life, check->life, n) == 0;
+
+    printf("  update: %7.3f ms/tick\n", update * 1e3 / TICKS);
+    printf("  draw:   %7.3f ms/tick  (%.0f%% of a 60 Hz frame together, SSE %s)\n", draw * 1e3 / TICKS,
+        (update + draw) / TICKS * TICK_HZ * 100.0, Verdict(same, "matches scalar", "MISMATCH"));
+
+    delete check;
+    delete pool;
+}
+
+// A producer thread queues sounds in bursts while this thread mixes them
+// block by block; every command that wasn't dropped must start a voice.
+void BenchAudio()
+{
+    const int BLOCKS = 20000, BURST = 64;
+    printf("audio, %d blocks of %d frames, %d voices\n", BLOCKS, AUDIO_BLOCK, AUDIO_VOICES);
+
+    AudioMixer* mixer = new AudioMixer;
+    InitAudioMixer(*mixer);
+    static int16_t out[AUDIO_BLOCK * 2];
+
+    std::atomic<bool> done{ false };
+    std::atomic<uint64_t> pushed{ 0 }, dropped{ 0 };
+    std::thread producer([&]
+    {
+        uint32_t rng = 12345;
+        while (!done)
+        {
+            for (int i = 0; i < BURST; ++i)
+            {
+                rng = rng * 1664525u + 1013904223u;
+                pushed++;
+                if (!PushSound(mixer->queue, (rng >> 8) % SOUND_COUNT, (rng >> 16) / 65535.f)) dropped++;
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    double elapsed = 0.0;
+    for (int b = 0; b < BLOCKS; ++b)
+    {
+        double start = QpcSeconds();
+        MixAudio(*mixer, out);
+        elapsed += QpcSeconds() - start;
+        std::this_thread::yield(); // a device asks for one block at a time
+    }
+    done = true;
+    producer.join();
+    MixAudio(*mixer, out); // start whatever was queued last
+
+    double audioSeconds = (double)mixer->frames / AUDIO_RATE;
+    printf("  mix:     %7.3f us/block  (%.0fx real time)\n", elapsed * 1e6 / BLOCKS, audioSeconds / elapsed);
+    printf("  queued:  %llu, dropped %llu, started %llu  (%s)\n", (unsigned long long)pushed,
+        (unsigned long long)dropped, (unsigned long long)mixer->started,
+        Verdict(pushed - dropped == mixer->started, "all accounted for", "MISMATCH"));
+    delete mixer;
+}
+
+// A 10 second replay through the export pipeline, written nowhere
+void BenchExport()
+{
+    const double SECONDS = 10.0;
+    printf("export, %.0f s replay at %dx%d\n", SECONDS, SCREEN_W, SCREEN_H);
+
+    ExportStats stats = ExportReplay(1, SECONDS, NULL);
+    double frames = (double)max(stats.frames, (uint64_t)1);
+    printf("  frame:   %7.3f ms  (simulate %.3f, rasterize %.3f, encode %.3f busy)\n", stats.seconds * 1e3 / frames,
+        stats.stageSeconds[0] * 1e3 / frames, stats.stageSeconds[1] * 1e3 / frames, stats.stageSeconds[2] * 1e3 / frames);
+    printf("  %.0fx real time, %llu frames  (%s)\n", stats.frames / (TICK_HZ * stats.seconds),
+        (unsigned long long)stats.frames, Verdict(stats.frames == (uint64_t)(SECONDS * TICK_HZ), "complete", "MISMATCH"));
+}
+
+// Session results appended flat out from this thread, as a busy server
+// would: the cost to the appending thread, then a reopen that must rebuild
+// the same index with a corrupt record, a new best score after it and a
+// torn record tacked on the end: the corrupt one skipped, the best score
+// kept and the torn tail cut.
+void BenchScoreStore()
+{
+    const int RESULTS = 200000;
+    const char* path = "bench_scores.bbl";
+    printf("score store, %d results\n", RESULTS);
+    remove(path);
+
+    ScoreStore* store = new ScoreStore;
+    OpenScoreStore(*store, path);
+    uint32_t rng = 777;
+    double worst = 0.0;
+    double start = QpcSeconds();
+    for (int i = 0; i < RESULTS; ++i)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        StoreRecord r = {};
+        r.kind = (i & 3) ? RECORD_GAME : RECORD_LEVEL;
+        r.level = (uint16_t)(1 + (rng >> 28));
+        r.score = (int32_t)(rng >> 12);
+        r.ticks = 600 + (rng >> 20);
+        r.seed = rng;
+        r.time = 1700000000 + i;
+        double t = QpcSeconds();
+        AppendScore(*store, r);
+        worst = max(worst, QpcSeconds() - t);
+    }
+    double appendSeconds = QpcSeconds() - start;
+    CloseScoreStore(*store);
+    double totalSeconds = QpcSeconds() - start;
+
+    std::vector<StoreRecord> top(store->top.begin(), store->top.end());
+    std::vector<StoreRecord> levels(store->bestLevel.begin(), store->bestLevel.end());
+    uint64_t written = store->written, syncs = store->syncs, compactions = store->compactions;
+    delete store;
+
+    StoreRecord corrupt = {}, best = {};
+    corrupt.kind = RECORD_GAME;
+    corrupt.score = 0x7FFFFFFF;
+    corrupt.crc = RecordCrc(corrupt) ^ 1;
+    best.kind = RECORD_GAME;
+    best.level = 1;
+    best.score = 0x7FFFFFFE;
+    best.crc = RecordCrc(best);
+    FILE* f = NULL;
+    if (fopen_s(&f, path, "ab") == 0 && f)
+    {
+        fwrite(&corrupt, sizeof(corrupt), 1, f);
+        fwrite(&best, sizeof(best), 1, f);
+        fwrite("torn", 4, 1, f);
+        fclose(f);
+    }
+    top.insert(top.begin(), best);
+    if (top.size() > STORE_TOP) top.pop_back();
+
+    store = new ScoreStore;
+    OpenScoreStore(*store, path);
+    bool same = store->tornBytes == 4 && store->corrupt == 1 && store->top.size() == top.size() &&
+                store->bestLevel.size() == levels.size() &&
+                memcmp(store->top.data(), top.data(), top.size() * sizeof(StoreRecord)) == 0 &&
+                memcmp(store->bestLevel.data(), levels.data(), levels.size() * sizeof(StoreRecord)) == 0;
+    uint64_t recovered = store->recovered;
+    CloseScoreStore(*store);
+    delete store;
+    remove(path);
+
+    printf("  append:  %7.3f us avg, %.3f us worst  (%.0f results/s through the disk)\n",
+        appendSeconds * 1e6 / RESULTS, worst * 1e6, RESULTS / totalSeconds);
+    printf("  log:     %llu written in %llu syncs, %llu compactions, %llu records left\n", (unsigned long long)written,
+        (unsigned long long)syncs, (unsigned long long)compactions, (unsigned long long)recovered);
+    printf("  reopen:  %s\n", Verdict(same && written == (uint64_t)RESULTS,
+                                   "same index, corrupt record skipped, torn tail cut", "MISMATCH"));
+}
+
+// Landing prediction for every ball of a 6,000-ball stress game, per tick.
+void BenchAutoplayPrediction()
+{
+    const int BALLS = 6000, TICKS = 60;
+    GameState g;
+    SeedGameRand(g, 99);
+    InitStressGame(g, 20, 40, BALLS);
+
+    double predict = 0.0;
+    float sink = 0.f;
+    for (int t = 0; t < TICKS; ++t)
+    {
+        double start = QpcSeconds();
+        TickInput in = AutoplayInput(g);
+        predict += QpcSeconds() - start;
+        sink += in.paddleMove;
+        UpdateGame(g, in);
+    }
+
+    printf("autoplayer prediction, %d balls\n", BALLS);
+    printf("  %.3f ms/tick  (%.1f ns/ball, checksum %.1f)\n",
+        predict * 1e3 / TICKS, predict * 1e9 / TICKS / BALLS, sink);
+}
+
+// Vectorized environment throughput: env-steps per second on one core,
+// with every env's paddle chasing its first ball.
+void BenchVecEnv()
+{
+    const int ENVS = 1024, STEPS = 2000;
+    BBVecEnv* env = bb_vec_create(ENVS);
+    std::vector<float> obs(ENVS * BB_OBS_FLOATS), actions(ENVS), rewards(ENVS);
+    std::vector<uint8_t> bricks(ENVS * BB_BRICK_BYTES), dones(ENVS);
+    bb_vec_reset(env, NULL, obs.data(), bricks.data());
+
+    double reward = 0.0;
+    int episodes = 0;
+    double start = QpcSeconds();
+    for (int t = 0; t < STEPS; ++t)
+    {
+        for (int i = 0; i < ENVS; ++i)
+        {
+            const float* o = &obs[i * BB_OBS_FLOATS];
+            float offset = (o[2] + (i % 9 - 4) * 8.f) - (o[0] + o[1] * 0.5f);
+            actions[i] = Clamp(offset / PADDLE_SPEED, -1.f, 1.f);
+        }
+        bb_vec_step(env, actions.data(), obs.data(), bricks.data(), rewards.data(), dones.data());
+        for (int i = 0; i < ENVS; ++i) { reward += rewards[i]; episodes += dones[i]; }
+    }
+    double elapsed = QpcSeconds() - start;
+    bb_vec_destroy(env);
+
+    printf("vectorized env, %d envs x %d steps\n", ENVS, STEPS);
+    printf("  %.2f M env-steps/s  (%.0f ns/step, %d episodes, reward %.0f)\n",
+        ENVS * (double)STEPS / elapsed * 1e-6, elapsed * 1e9 / ENVS / STEPS, episodes, reward);
+}
+
+// Steady-state ticks must not allocate: every buffer a tick uses is sized
+// when the board is configured, or grows to its high-water mark during the
+// warm-up, and is reused after that. Counts operator new
+// calls over ticks that follow a warm-up, on the default game as the
+// window runs it (telemetry, particles and a render snapshot attached,
+// through level changes and restarts), on a stress board with ball/ball
+// collisions and on vectorized envs resetting after game overs. Any
+// allocation fails the suite.
+bool BenchSteadyStateAllocations()
+{
+    const int WARMUP = 2000, TICKS = 200000, STRESS_WARMUP = 60, STRESS_TICKS = 120;
+    printf("steady-state allocations\n");
+    if (!COUNTING_ALLOCATIONS)
+    {
+        printf("  not counted in this build\n");
+        return true;
+    }
+
+    bool ok = true;
+    auto report = [&](const char* what, uint64_t allocs, int ticks)
+    {
+        printf("  %-40s %7d ticks  %llu allocations  %s\n", what, ticks, (unsigned long long)allocs,
+            allocs ? "ALLOCATES" : "ok");
+        ok = ok && allocs == 0;
+    };
+
+    GameState g;
+    InitGameState(g, 8080);
+    Telemetry* telemetry = new Telemetry;
+    ParticlePool* particles = new ParticlePool;
+    RenderSnapshot* snap = new RenderSnapshot;
+    AttachTelemetry(g, telemetry);
+    g.hooks.particles = particles;
+    uint64_t before = 0;
+    for (int t = 0; t < WARMUP + TICKS; ++t)
+    {
+        if (t == WARMUP) before = g_allocCount.load(std::memory_order_relaxed);
+        UpdateGame(g, AutoplayInput(g));
+        AdvanceParticles(g, *particles);
+        CaptureSnapshot(g, *snap);
+    }
+    report("default game, autoplay", g_allocCount.load(std::memory_order_relaxed) - before, TICKS);
+    AttachTelemetry(g, nullptr);
+    g.hooks.particles = nullptr;
+    delete snap;
+    delete particles;
+    delete telemetry;
+
+    g = GameState();
+    SeedGameRand(g, 31337);
+    InitStressGame(g, 100, 100, 2000);
+    g.ballCollisions = true;
+    for (int t = 0; t < STRESS_WARMUP; ++t)
+        StepSimulation(g);
+    before = g_allocCount.load(std::memory_order_relaxed);
+    for (int t = 0; t < STRESS_TICKS; ++t)
+        StepSimulation(g);
+    report("100x100, 2000 balls, collisions", g_allocCount.load(std::memory_order_relaxed) - before, STRESS_TICKS);
+
+    // A still paddle loses every ball, so envs keep ending and resetting
+    const int ENVS = 16;
+    BBVecEnv* env = bb_vec_create(ENVS);
+    std::vector<float> obs(ENVS * BB_OBS_FLOATS), actions(ENVS, 0.f), rewards(ENVS);
+    std::vector<uint8_t> bricks(ENVS * BB_BRICK_BYTES), dones(ENVS);
+    bb_vec_reset(env, NULL, obs.data(), bricks.data());
+    int episodes = 0;
+    for (int t = 0; t < WARMUP + TICKS / 10; ++t)
+    {
+        if (t == WARMUP) before = g_allocCount.load(std::memory_order_relaxed);
+        bb_vec_step(env, actions.data(), obs.data(), bricks.data(), rewards.data(), dones.data());
+        if (t >= WARMUP)
+            for (int i = 0; i < ENVS; ++i) episodes += dones[i];
+    }
+    char what[64];
+    sprintf_s(what, sizeof(what), "vectorized env, %d resets", episodes);
+    report(what, g_allocCount.load(std::memory_order_relaxed) - before, TICKS / 10);
+    bb_vec_destroy(env);
+    return ok;
+}
+
+int RunBenchmarks()
+{
+    bool ownConsole = OpenConsole();
+
+    BenchBoardConfigs();
+    BenchTelemetry();
+    BenchPaddleBounce();
+    BenchLargeBoard();
+    BenchBallCollisions();
+    BenchPowerUps();
+    BenchParticles();
+    BenchAudio();
+    BenchExport();
+    BenchScoreStore();
+    BenchVecEnv();
+    BenchAutoplayPrediction();
+    if (!BenchSteadyStateAllocations()) g_benchFailures++;
+
+    SampleResident();
+    printf("memory: %.1f MB resident, %llu allocations\n", g_rssBytes.load() / 1048576.0,
+        (unsigned long long)g_allocCount.load());
+
+    if (g_benchFailures) printf("%d check(s) FAILED\n", g_benchFailures);
+
+    CloseConsole(ownConsole);
+    return g_benchFailures ? 1 : 0;
+}
+
+// ============================================================
+// Soak Runs (BreakBlocks.exe /soak [hours])
+// ============================================================
+
+// The autoplayer plays the default game flat out (no tick pacing) for
+// 'hours', restarting after every game over. Every tick is checked against
+// CheckInvariants; progress, with the sampled resident set, is reported
+// every 10 seconds. With a telemetryPrefix the run's telemetry and memory
+// counters are written there at the end.
+int RunSoak(double hours, const char* telemetryPrefix)
+{
+    bool ownConsole = OpenConsole();
+    if (hours <= 0.0) hours = 1.0;
+
+    GameState g;
+    uint32_t seed = (uint32_t)time(NULL);
+    InitGameState(g, seed);
+    printf("soak: %.2f h, seed %u\n", hours, seed);
+
+    Telemetry telemetry;
+    AttachTelemetry(g, &telemetry);
+    StartRssSampler(1.0);
+
+    const double start = QpcSeconds();
+    const double end = start + hours * 3600.0;
+    double lastReport = start;
+    unsigned long long ticks = 0, lastTicks = 0;
+    int livesLost = 0, gameOvers = 0, bestLevel = 1;
+    int violations = 0, violationTicks = 0;
+
+    for (;;)
+    {
+        int lives = g.lives;
+        bool wasOver = g.gameOver;
+        UpdateGame(g, AutoplayInput(g));
+        ticks++;
+
+        if (g.lives < lives) livesLost += lives - g.lives;
+        if (g.gameOver && !wasOver) gameOvers++;
+        if (g.level > bestLevel) bestLevel = g.level;
+
+        const char* what = NULL;
+        int broken = CheckInvariants(g, &what);
+        if (broken)
+        {
+            violations += broken;
+            if (violationTicks++ < 20)
+                printf("  tick %llu: %s (level %d)\n", ticks, what, g.level);
+        }
+
+        if ((ticks & 4095) != 0) continue;
+        double now = QpcSeconds();
+        bool done = now >= end;
+        if (now - lastReport < 10.0 && !done) continue;
+
+        printf("%8.0f s  %12llu ticks  %9.0f ticks/s  level %d (best %d)  lives lost %d  game overs %d  "
+               "rss %.1f MB (peak %.1f)  violations %d\n",
+            now - start, ticks, (ticks - lastTicks) / (now - lastReport), g.level, bestLevel,
+            livesLost, gameOvers, g_rssBytes.load() / (1024.0 * 1024.0), g_rssPeak.load() / (1024.0 * 1024.0),
+            violations);
+        fflush(stdout);
+        lastReport = now;
+        lastTicks = ticks;
+        if (done) break;
+    }
+
+    StopRssSampler();
+    if (telemetryPrefix)
+    {
+        char path[512];
+        sprintf_s(path, sizeof(path), "%s_memory.json", telemetryPrefix);
+        if (WriteTelemetry(telemetry, telemetryPrefix) && WriteMemoryJson(path))
+            printf("telemetry written to %s_*.csv, memory to %s\n", telemetryPrefix, path);
+        else
+            printf("cannot write telemetry to %s_*\n", telemetryPrefix);
+    }
+
+    CloseConsole(ownConsole);
+    return violations ? 1 : 0;
+}
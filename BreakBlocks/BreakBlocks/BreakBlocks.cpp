@@ -3,141 +3,42 @@
 // Paddle + Ball + Bricks + Levels + PowerUps + Effects
 // Win32 + GDI
 // C++14
+//
+// This file is the front end: the window, input, the simulation and render
+// threads, and the command line. The game itself is Game.cpp; subsystems
+// and tool modes each have a file of their own.
+//
+// The simulation also builds headless on Linux for the game server:
+//   g++ -std=c++14 -O2 -pthread *.cpp -o breakblocks
 // ============================================================
 
-#include <windows.h>
-#include <math.h>
-#include <stdio.h>
-#include <time.h>
-#include <stdlib.h>
-
-// ============================================================
-// Constants / Configuration
-// ============================================================
-
-static const int SCREEN_W = 800;
-static const int SCREEN_H = 600;
-
-static const float PADDLE_W = 100.f;
-static const float PADDLE_H = 15.f;
-static const float PADDLE_SPEED = 6.f;
-
-static const float BALL_RADIUS = 6.f;
-static const float BALL_SPEED = 5.5f;
-static const int BALL_CAP = 6;
-
-static const int BRICK_ROWS = 5;
-static const int BRICK_COLS = 10;
-static const int BRICK_W = 70;
-static const int BRICK_H = 20;
-static const int BRICK_GAP = 6;
-
-// Base values for reset/restoration
-static const float BASE_BALL_SPEED = BALL_SPEED;
-static const float BASE_BALL_RADIUS = BALL_RADIUS;
-
-// ============================================================
-// Math / Utility Functions
-// ============================================================
-
-float Clamp(float v, float min, float max)
-{
-    if (v < min) return min;
-    if (v > max) return max;
-    return v;
-}
-
-bool CircleRectIntersect(float cx, float cy, float r, const RECT& rc)
-{
-    float closestX = Clamp(cx, (float)rc.left, (float)rc.right);
-    float closestY = Clamp(cy, (float)rc.top, (float)rc.bottom);
-    float dx = cx - closestX;
-    float dy = cy - closestY;
-    return (dx * dx + dy * dy) <= (r * r);
-}
-
-COLORREF GetBrickColor(int hits)
-{
-    switch (hits)
-    {
-    case 1: return RGB(200, 200, 200); // light gray
-    case 2: return RGB(0, 200, 255);   // cyan
-    case 3: return RGB(0, 180, 0);     // green
-    case 4: return RGB(255, 180, 0);   // orange
-    case 5: return RGB(255, 0, 0);     // red
-    default: return RGB(255, 255, 255);
-    }
-}
-
-int RollBrickHits(int level)
-{
-    int base = 1 + level / 2;
-    if (base < 1) base = 1;
-    if (base > 4) base = 4;
-
-    int roll = rand() % 100;
-    if (roll < 50) return base;
-    else if (roll < 80) return base + 1;
-    else return base + 2;
-}
-
-// ============================================================
-// Enums / Structs
-// ============================================================
-
-struct Paddle
-{
-    float x, y, w, h;
-};
-
-struct Ball
-{
-    float x, y, vx, vy, r;
-    float spin = 0.f;
-	int penetrateMax = 0; // max number of bricks it can penetrate
-	int penetrateCount = 0; // number of bricks it can penetrate per hit
-	bool stuck = false;
-	bool alive = false;
-};
-
-struct Brick
-{
-    RECT rect;
-    int hits;
-    COLORREF color;
-    bool alive;
-};
-
-// ============================================================
-// Global Game State
-// ============================================================
-
-static Paddle g_paddle;
-static float g_paddleVX = 0.f;
-static float g_paddlePrevX = 0.f;
-static Ball g_ball[BALL_CAP];
-static int g_ballMax = 1; // current number of active balls
-static bool g_ballLaunched = false;
-
-static Brick g_bricks[BRICK_ROWS * BRICK_COLS];
-
-static int g_score = 0;
-static int g_lives = 3;
-static int g_level = 1;
-static bool g_gameOver = false;
-static bool g_spin = false;
-static bool g_stickyPaddle = false;
-static bool g_invulnerable = false;
-
+#include "Game.h"
+#include "Audio.h"
+#include "Particles.h"
+#include "Render.h"
+#include "ScoreStore.h"
+#include "Telemetry.h"
+#include "Tools.h"
+#ifdef _WIN32
+#pragma comment(lib, "winmm.lib") // timeBeginPeriod
+#endif
+
+#ifdef _WIN32
 // ============================================================
 // Persistent Back Buffer
 // ============================================================
 
+// The bitmap only ever grows: shrinking the window just draws into less of
+// it, and growing past it reallocates with headroom, so a drag-resize
+// reallocates a handful of times rather than on every WM_SIZE.
 static HDC g_backDC = NULL;
 static HBITMAP g_backBitmap = NULL;
 static HBITMAP g_backOldBitmap = NULL;
-static int g_backW = 0;
+static uint32_t* g_backBits = NULL; // top-down 0x00RRGGBB pixels, for batched drawing
+static int g_backW = 0;             // bitmap size (g_backW is the row pitch)
 static int g_backH = 0;
+static int g_viewW = 0;             // client area, the part drawn and presented
+static int g_viewH = 0;
 
 void DestroyBackBuffer()
 {
@@ -150,6 +51,7 @@ void DestroyBackBuffer()
     g_backDC = NULL;
     g_backBitmap = NULL;
     g_backOldBitmap = NULL;
+    g_backBits = NULL;
     g_backW = g_backH = 0;
 }
 
@@ -158,874 +60,499 @@ void CreateBackBuffer(HWND hwnd, int width, int height)
     DestroyBackBuffer();
     HDC hdc = GetDC(hwnd);
     g_backDC = CreateCompatibleDC(hdc);
-    g_backBitmap = CreateCompatibleBitmap(hdc, width, height);
+
+    // A DIB section, so particles can be written straight into its pixels
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height; // top-down
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    g_backBitmap = CreateDIBSection(hdc, &bmi, DIB_RGB_COLORS, (void**)&g_backBits, NULL, 0);
     g_backOldBitmap = (HBITMAP)SelectObject(g_backDC, g_backBitmap);
     g_backW = width;
     g_backH = height;
     ReleaseDC(hwnd, hdc);
 }
 
+// Makes the view width x height, growing the bitmap by at least half again
+// (up to the desktop size) when it doesn't fit
+void ResizeBackBuffer(HWND hwnd, int width, int height)
+{
+    g_viewW = width;
+    g_viewH = height;
+    if (g_backDC && width <= g_backW && height <= g_backH) return;
+
+    int w = max(width, g_backW), h = max(height, g_backH);
+    if (width > g_backW) w = max(width, min(g_backW * 3 / 2, GetSystemMetrics(SM_CXVIRTUALSCREEN)));
+    if (height > g_backH) h = max(height, min(g_backH * 3 / 2, GetSystemMetrics(SM_CYVIRTUALSCREEN)));
+    CreateBackBuffer(hwnd, w, h);
+}
+#endif // _WIN32
+
 // ============================================================
-// Initialization
+// Startup
 // ============================================================
 
-void InitPaddle()
-{
-    g_paddle.w = PADDLE_W;
-    g_paddle.h = PADDLE_H;
-    g_paddle.x = (g_backW - g_paddle.w) * 0.5f;
-    g_paddle.y = g_backH - 40.f;
-}
+// Time to first frame. StartupMark times each step of getting there, and
+// of the deferred work running alongside, from StartupBegin; /startup
+// writes them to startup.txt on exit. What the first frame can do without
+// (particles, the score log, sound) is built on a side thread while the
+// window comes up, and the simulation thread adopts it between ticks once
+// it is ready. Until then those features are off, as if their hooks were
+// never set.
 
-void InitBall()
-{
-    for (int i = 0; i < BALL_CAP; ++i)
-    {
-        g_ball[i].r = BALL_RADIUS;
-        g_ball[i].vx = (i == 0) ? BALL_SPEED : 0.f;  // only first ball moving
-        g_ball[i].vy = (i == 0) ? -BALL_SPEED : 0.f;
-        g_ball[i].penetrateMax = 0;
-        g_ball[i].penetrateCount = 0;
-        g_ball[i].x = g_paddle.x + g_paddle.w * 0.5f;
-        g_ball[i].y = g_paddle.y - g_ball[i].r - 1.f;
-        g_ball[i].alive = (i == 0);  // only the first g_ball is alive
-        g_ball[i].stuck = false;
-		g_ball[i].spin = 0.f;
-    }
-    g_ballMax = 1;
-    g_ballLaunched = false;
-}
+static const int STARTUP_MARKS = 32;
 
-void KillAllBalls()
+struct StartupStep
 {
-    for (int i = 0; i < BALL_CAP; ++i)
-    {
-        g_ball[i].alive = false;
-        g_ball[i].spin = 0.f;
-    }
-    g_ballMax = 1;
+    const char* what;
+    double at;     // seconds from StartupBegin
+    bool deferred; // on the side thread
+};
 
-    g_ballLaunched = false;
-}
+static StartupStep g_startupSteps[STARTUP_MARKS];
+static std::atomic<int> g_startupStepCount{ 0 };
+static double g_startupBegin = 0.0;
+static double g_processAge = 0.0; // process creation to StartupBegin, 0 = unknown
 
-int FindActiveBall(){
-    for (int i = 0; i < BALL_CAP; ++i)
+void StartupBegin()
+{
+    g_startupBegin = QpcSeconds();
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user, now;
+    if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
     {
-        if (g_ball[i].alive)
-            return i;
+        GetSystemTimePreciseAsFileTime(&now);
+        ULARGE_INTEGER a, b;
+        a.LowPart = created.dwLowDateTime; a.HighPart = created.dwHighDateTime;
+        b.LowPart = now.dwLowDateTime; b.HighPart = now.dwHighDateTime;
+        g_processAge = (b.QuadPart - a.QuadPart) * 1e-7; // 100 ns units
     }
-    return -1;
+#endif
 }
 
-void SetActiveBallCount()
+void StartupMark(const char* what, bool deferred = false)
 {
-	int src = FindActiveBall();
-    if (src == -1) { return; } // no active ball to clone from
-
-	int count = 0;// only add balls up to g_ballMax
+    int i = g_startupStepCount.fetch_add(1);
+    if (i >= STARTUP_MARKS) return;
+    g_startupSteps[i].what = what;
+    g_startupSteps[i].at = QpcSeconds() - g_startupBegin;
+    g_startupSteps[i].deferred = deferred;
+}
 
-    for (int i = 0; i < BALL_CAP; ++i)
+// Each step with the time since the previous one on its thread
+void WriteStartupProfile(FILE* f)
+{
+    int count = min(g_startupStepCount.load(), STARTUP_MARKS);
+    if (g_processAge > 0.0)
+        fprintf(f, "%9.3f ms  process start to startup\n", g_processAge * 1e3);
+    for (int pass = 0; pass < 2; ++pass)
     {
-        if (count < g_ballMax)
-        {
-            if (!g_ball[i].alive)
-            {
-                // Spawn this ball by cloning ball 0
-                g_ball[i] = g_ball[src];
-                g_ball[i].vx = (i & 1) ? g_ball[i].vx : -g_ball[i].vx;
-                g_ball[i].alive = true;
-				g_ball[i].stuck = false;
-            }
-			count++;
-        }
-        else
-        {
-            g_ball[i].alive = false;
+        if (pass == 1) fprintf(f, "deferred, alongside:\n");
+        double last = 0.0;
+        for (int i = 0; i < count; ++i)
+        {
+            const StartupStep& s = g_startupSteps[i];
+            if (s.deferred != (pass == 1)) continue;
+            fprintf(f, "%9.3f ms  %+8.3f  %s\n", s.at * 1e3, (s.at - last) * 1e3, s.what);
+            last = s.at;
         }
     }
 }
 
-struct LevelDef
+struct DeferredInit
 {
-    int rows;
-    int cols;
-    int brickPattern[BRICK_ROWS][BRICK_COLS];
-
-    // Power-up rule per brick
-    // -1  = no power-up
-    //  0  = guaranteed random power-up
-    // >0  = guaranteed specific power-up index
-    int mustDropPowerUp[BRICK_ROWS][BRICK_COLS];
-
-    // Brick descent pressure
-    int descendIntervalFrames;   // 0 = no descent
-    int descendAmount;           // pixels per descent
-};
-
-// Example Level (you can expand for more levels)
-LevelDef g_levels[] =
-{
-    // Level 1
-    {
-        5, 10,
-        {
-            {1,1,1,1,1,1,1,1,1,1},
-            {0,1,2,2,2,2,2,2,1,0},
-            {0,0,1,3,3,3,3,1,0,0},
-            {0,0,0,1,4,4,1,0,0,0},
-            {0,0,0,0,5,5,0,0,0,0}
-        },
-        {// defined power-ups in specific bricks
-            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 
-            {-1, 0, 0, 0, 0, 0, 0, 0, 0,-1},
-            {-1,-1, 6 -1,-1,-1,-1, 6,-1,-1},
-            {-1,-1,-1,11, 0, 0,11,-1,-1,-1},
-            {-1,-1,-1,-1, 0, 0,-1,-1,-1,-1}
-        },
-        0,0
-    },
-
-    // Level 2 - can define another pattern
+    std::thread thread;
+    std::atomic<bool> ready{ false };
+    ParticlePool* particles = nullptr;
+    ScoreStore* scores = nullptr;
+    AudioMixer* audio = nullptr;
+#ifdef _WIN32
+    HWAVEOUT audioDevice = NULL;
+    HANDLE audioBlockDone = NULL;
+    std::thread audioThread;
+#endif
 };
 
-// Convenience
-static const int g_levelCount = sizeof(g_levels) / sizeof(g_levels[0]);
+static DeferredInit g_deferred;
 
-// ------------------------------------------------------------
-// InitBricks using LevelDef
-// ------------------------------------------------------------
-void InitBricksForLevel(int level)
+// Side thread. The sound device is opened first since it is the slowest
+// and everything else can go on meanwhile; headless there is no device,
+// but the sample bank is still built so its cost shows up.
+void BuildDeferredSubsystems(const char* scorePath)
 {
-    if (level < 1 || level > g_levelCount) level = g_levelCount; // clamp to last level
-    const LevelDef& lvl = g_levels[level - 1];
+    DeferredInit& d = g_deferred;
+#ifdef _WIN32
+    bool sound = OpenAudioDevice(d.audioDevice, d.audioBlockDone);
+    StartupMark("sound device", true);
+#else
+    bool sound = true;
+#endif
 
-    int index = 0;
-    int totalW = lvl.cols * BRICK_W + (lvl.cols - 1) * BRICK_GAP;
-    int startX = (g_backW - totalW) / 2;
-    int startY = 40;
+    d.particles = new ParticlePool;
+    StartupMark("particle pool", true);
 
-    for (int r = 0; r < lvl.rows; ++r)
+    if (scorePath)
     {
-        for (int c = 0; c < lvl.cols; ++c)
+        d.scores = new ScoreStore;
+        if (!OpenScoreStore(*d.scores, scorePath))
         {
-            Brick& b = g_bricks[index++];
-            int x = startX + c * (BRICK_W + BRICK_GAP);
-            int y = startY + r * (BRICK_H + BRICK_GAP);
-
-            b.rect = { x, y, x + BRICK_W, y + BRICK_H };
-
-            int baseHits = lvl.brickPattern[r][c];
-            if (baseHits == 0)
-            {
-                b.alive = false;
-                continue;
-            }
-
-            // Add some randomness on top of base hits
-            int hits = baseHits + (rand() % 2); // +0 or +1
-            b.hits = Clamp(hits, 1, 5);
-
-            b.color = GetBrickColor(b.hits);
-            b.alive = true;
-
-            // Optional: attach must-drop power-up flag
-            if (lvl.mustDropPowerUp[r][c])
-            {
-                // Tag the brick or just spawn power-up when destroyed
-                // We'll handle it in HandleBrickCollisions
-                // Example: store in hits = -hits to mark?
-                // Or just check lvl data in collision
-            }
+            delete d.scores;
+            d.scores = nullptr;
         }
+        StartupMark("score log", true);
     }
 
-    // Mark remaining bricks dead
-    for (; index < BRICK_ROWS * BRICK_COLS; ++index)
-        g_bricks[index].alive = false;
+    if (sound)
+    {
+        d.audio = new AudioMixer;
+        InitAudioMixer(*d.audio);
+#ifdef _WIN32
+        d.audioThread = std::thread(AudioThread, d.audio, d.audioDevice, d.audioBlockDone);
+#endif
+        StartupMark("sample bank", true);
+    }
+    d.ready.store(true, std::memory_order_release);
 }
 
-void InitGame()
+// A null scorePath keeps no score log
+void StartDeferredInit(const char* scorePath)
 {
-    g_score = 0;
-    g_lives = 3;
-    g_level = 1;
-    g_gameOver = false;
-    InitPaddle();
-    InitBall();
-    InitBricksForLevel(g_level);
+    g_deferred.thread = std::thread(BuildDeferredSubsystems, scorePath);
 }
 
-// ============================================================
-// PowerUp / Effect Logic
-// ============================================================
-struct PowerUpDef
+// Simulation thread, between ticks; true once the deferred subsystems are
+// ready and hooked up to 'g'
+bool AdoptDeferredSubsystems(GameState& g)
 {
-    const char* name;                     // For debugging / display
-    COLORREF color;                       // Display color
-    void (*applyFunc)();                   // Function to apply effect
-    void (*revertFunc)();                 // Function to revert effect
-    int durationFrames;                    // 0 = instant, >0 = timed
-};
-
-// Forward Declarations (Power-Up Spawning)
-
-void SpawnPowerUp(float x, float y);
-void SpawnPowerUp(float x, float y, int index);
-
-// Declarations of effect functions
-
-void ForEachAliveBall(void (*func)(Ball&))
-{
-    for (int i = 0; i < BALL_CAP; ++i)
-    {
-        if (!g_ball[i].alive)
-            continue;
-
-        func(g_ball[i]);
-    }
-}
-
-void EffectBallFast() {                                                //1
-    ForEachAliveBall([](Ball& b)
-        {
-            b.vx *= 1.5f;
-            b.vy *= 1.5f;
-        });
-}
-void EffectBallSlow() {                                                 //2
-    ForEachAliveBall([](Ball& b)
-        {
-            b.vx *= 0.7f;
-            b.vy *= 0.7f;
-        });
-}
-void EffectBallBig() {                                                  //3
-    ForEachAliveBall([](Ball& b)
-        {
-            b.r = BASE_BALL_RADIUS * 1.5f;
-            b.penetrateMax = 2;
-            b.penetrateCount = 2;
-		});
-}
-void EffectBallSmall() {                                                //4
-    ForEachAliveBall([](Ball& b)
-        {
-            b.r = BASE_BALL_RADIUS * 0.7f;
-            b.penetrateMax = 0;
-            b.penetrateCount = 0;
-        });
-}
-void EffectBallSpin() { g_spin = true; }                         //5
-void EffectMultiBall() { g_ballMax = 3; SetActiveBallCount(); }         //6
-void EffectMultiRare() { g_ballMax = 6; SetActiveBallCount(); }         //7
-void EffectWreakingBall() {                                             //8
-    ForEachAliveBall([](Ball& b)
-        {
-            b.r = BASE_BALL_RADIUS * 3.0f;
-            b.penetrateMax = 100;
-            b.penetrateCount = 100;
-        });
-}
-void EffectPaddleWide() { g_paddle.w *= 1.5f; }                         //9
-void EffectPaddleNarrow() { g_paddle.w *= 0.7f; }                       //10
-void EffectSticky() { g_stickyPaddle = true; }                          //11
-void invulnerable() { g_invulnerable = true; }                          //12
-void EffectAddLife() { g_lives++; }                                     //13
-void EffectChaos() {                                                    //14
-    const int CHAOS_DROPS = 20;
-
-    for (int i = 0; i < CHAOS_DROPS; ++i)
-    {
-        float x = (float)(rand() % g_backW);
-        float y = 0.f; // or brick center, or paddle height
-        SpawnPowerUp(x, y);
-    }
+    DeferredInit& d = g_deferred;
+    if (!d.ready.load(std::memory_order_acquire)) return false;
+    g.hooks.particles = d.particles;
+    g.hooks.audio = d.audio;
+    g_scores = d.scores;
+    return true;
 }
 
-// ------------------------------------------------------------
-// Revert Functions for Timed Effects
-// ------------------------------------------------------------
-void RevertBallFast() {
-    ForEachAliveBall([](Ball& b)
-        {
-            b.vx /= 1.5f;
-            b.vy /= 1.5f;
-        });
-}
-void RevertBallSlow() {
-    ForEachAliveBall([](Ball& b)
-        {
-            b.vx /= 0.7f;
-            b.vy /= 0.7f;
-        });
-}
-void RevertBallBig() {
-    ForEachAliveBall([](Ball& b)
-        {
-            b.r = BASE_BALL_RADIUS;
-            b.penetrateMax = 0;
-            b.penetrateCount = 0;
-        });
-}
-void RevertBallSmall() {
-    ForEachAliveBall([](Ball& b)
-        {
-            b.r = BASE_BALL_RADIUS;
-        });
-}
-void RevertBallSpin() { g_spin = false; }
-void RevertWreakingBall() {
-    ForEachAliveBall([](Ball& b)
-        {
-            b.r = BASE_BALL_RADIUS;
-            b.penetrateMax = 0;
-            b.penetrateCount = 0;
-        });
-}
-void RevertPaddleWide() { g_paddle.w /= 1.5f; }
-void RevertPaddleNarrow() { g_paddle.w /= 0.7f; }
-void RevertSticky()
+// Once nothing ticks any more
+void StopDeferredSubsystems(GameState& g)
 {
-    g_stickyPaddle = false;
-	bool anyStuck = false;
+    DeferredInit& d = g_deferred;
+    if (d.thread.joinable()) d.thread.join();
+    g.hooks.particles = nullptr;
+    g.hooks.audio = nullptr;
+    g_scores = nullptr;
 
-    // Auto-launch any stuck balls
-    for (int i = 0; i < g_ballMax; ++i)
+#ifdef _WIN32
+    if (d.audioThread.joinable())
     {
-        Ball& b = g_ball[i];
-        if (!b.alive || !b.stuck) continue;
-
-        b.stuck = false;
-
-		//If velocity is zero, give it an initial launch
-        if (b.vx == 0.f && b.vy == 0.f) {
-            b.vx = (i & 1) ? BASE_BALL_SPEED : -BASE_BALL_SPEED;
-            b.vy = -BASE_BALL_SPEED;
-        }
-		anyStuck = true;
-    }
-    if (anyStuck) {
-        g_ballLaunched = true;
+        g_audioQuit = true;
+        d.audioThread.join();
+        waveOutClose(d.audioDevice);
     }
+    if (d.audioBlockDone) CloseHandle(d.audioBlockDone);
+#endif
+    if (d.scores && !CloseScoreStore(*d.scores))
+        fprintf(stderr, "score store: %llu results lost\n", (unsigned long long)d.scores->lost);
+    delete d.scores;
+    delete d.audio;
+    delete d.particles;
+    d.scores = nullptr;
+    d.audio = nullptr;
+    d.particles = nullptr;
+    d.ready = false;
 }
 
-void RevertInvulnerable() { g_invulnerable = false; }
+// ============================================================
+// Input
+// ============================================================
+
+// The UI thread timestamps keyboard and raw-mouse events as they arrive and
+// pushes them into a lock-free SPSC queue; the simulation thread drains it
+// once per tick. Nothing is polled, so a tap shorter than a tick still
+// registers, and held keys move the paddle for exactly the part of the tick
+// they were down.
 
-// All power-ups are defined here, in one array
-static PowerUpDef g_powerUps[] =
+enum InputEventType
 {
-    { "Ball Fast",    RGB(255, 0, 255),  EffectBallFast,   RevertBallFast,    600 },
-    { "Ball Slow",    RGB(0, 255, 255),  EffectBallSlow,   RevertBallSlow,    600 },
-    { "Ball Big",     RGB(255, 255, 0),  EffectBallBig,    RevertBallBig,     600 },
-    { "Ball Small",   RGB(0, 0, 255),    EffectBallSmall,  RevertBallSmall,   600 },
-    { "Ball Spin",    RGB(255, 165, 0),  EffectBallSpin,   RevertBallSpin,    600 },
-    { "Multi Ball",   RGB(128, 0, 128),  EffectMultiBall,  nullptr,           0 },
-    { "Multi Rare",   RGB(75, 0, 130),   EffectMultiRare,  nullptr,           0 },
-    { "Wreaking Ball",RGB(255, 20, 147), EffectWreakingBall,nullptr,          0 },
-    { "Paddle Wide",  RGB(0, 255, 0),    EffectPaddleWide, RevertPaddleWide,  600 },
-    { "Paddle Narrow",RGB(255, 140, 0),  EffectPaddleNarrow,RevertPaddleNarrow,600 },
-    { "Sticky Paddle",RGB(34, 139, 34),  EffectSticky,     RevertSticky,      600 },
-    { "Invulnerable", RGB(255, 215, 0),  invulnerable,     RevertInvulnerable,600 },
-	{ "Chaos",        RGB(220, 20, 60),  EffectChaos,      nullptr,           0 },
-    { "Add Life",     RGB(255, 0, 0),    EffectAddLife,    nullptr,           0 },
+    INPUT_KEY_DOWN,
+    INPUT_KEY_UP,
+    INPUT_MOUSE_MOVE,  // value = raw x delta
+    INPUT_RELEASE_ALL, // focus lost
 };
 
-static const int g_powerUpCount = sizeof(g_powerUps) / sizeof(g_powerUps[0]);
-
-struct ActivePowerUp
+struct InputEvent
 {
-    const PowerUpDef * def = nullptr;
-    int timer = 0;
+    double time; // QpcSeconds() on arrival
+    int type;
+    int value;
 };
 
-static ActivePowerUp g_activePowerUps[10]; // allow up to 10 concurrent timed power-ups
+static const unsigned int INPUT_QUEUE_SIZE = 256; // power of two
 
-struct FallingPowerUp
+struct InputQueue
 {
-    int index = -1;   // which power-up type
-    float x = 0.f;
-    float y = 0.f;
-    bool alive = false;
+    InputEvent events[INPUT_QUEUE_SIZE];
+    std::atomic<unsigned int> head{ 0 }; // written by the UI thread
+    std::atomic<unsigned int> tail{ 0 }; // written by the simulation thread
 };
 
-static const int MAX_FALLING_POWERUPS = 20;
-static FallingPowerUp g_fallingPowerUps[MAX_FALLING_POWERUPS];
+static InputQueue g_inputQueue;
 
-int RandomPowerUpIndex()
-{
-    return rand() % g_powerUpCount;
-}
+// Keys as the simulation has seen them so far (simulation thread only)
+static bool g_keyLeft = false;
+static bool g_keyRight = false;
+static bool g_keyLaunch = false;
+static bool g_keyRestart = false;
 
-void SpawnPowerUp(float x, float y)
+bool IsGameKey(int vk)
 {
-    int slot = -1;
-    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
-    {
-        if (!g_fallingPowerUps[i].alive)
-        {
-            slot = i;
-            break;
-        }
-    }
-    if (slot == -1) return; // no free slot
-
-    g_fallingPowerUps[slot].alive = true;
-    g_fallingPowerUps[slot].x = x;
-    g_fallingPowerUps[slot].y = y;
-    g_fallingPowerUps[slot].index = RandomPowerUpIndex();
+    return vk == VK_LEFT || vk == VK_RIGHT || vk == VK_SPACE || vk == 'R';
 }
 
-void SpawnPowerUp(float x, float y, int index)
+// UI thread. Drops the event if the simulation has fallen 256 events behind.
+void PushInputEvent(int type, int value)
 {
-    if (index < 0 || index >= g_powerUpCount) return;
-
-    int slot = -1;
-    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
-    {
-        if (!g_fallingPowerUps[i].alive)
-        {
-            slot = i;
-            break;
-        }
-    }
-    if (slot == -1) return;
+    unsigned int head = g_inputQueue.head.load(std::memory_order_relaxed);
+    if (head - g_inputQueue.tail.load(std::memory_order_acquire) >= INPUT_QUEUE_SIZE) return;
 
-    g_fallingPowerUps[slot].alive = true;
-    g_fallingPowerUps[slot].x = x;
-    g_fallingPowerUps[slot].y = y;
-    g_fallingPowerUps[slot].index = index;
+    InputEvent& e = g_inputQueue.events[head & (INPUT_QUEUE_SIZE - 1)];
+    e.time = QpcSeconds();
+    e.type = type;
+    e.value = value;
+    g_inputQueue.head.store(head + 1, std::memory_order_release);
 }
 
-ActivePowerUp* FindActivePowerUp(const PowerUpDef* def)
+// Simulation thread. Applies every event up to tickEnd at its position
+// within [tickStart, tickEnd].
+TickInput CollectTickInput(double tickStart, double tickEnd)
 {
-    for (int i = 0; i < 10; ++i)
-    {
-        if (g_activePowerUps[i].def == def && g_activePowerUps[i].timer > 0)
-            return &g_activePowerUps[i];
-    }
-    return nullptr;
-}
-
-void ApplyPowerUp(int index)
-{
-    if (index < 0 || index >= g_powerUpCount) return;
-    const PowerUpDef* def = &g_powerUps[index];
-
-	// Instant effect
-    if (def->durationFrames == 0)
-    {
-        def->applyFunc();
-        return;
-    }
+    TickInput in;
+    double span = tickEnd - tickStart;
+    if (span <= 0.0) span = 1.0 / TICK_HZ;
 
-    // Timed effect
-    ActivePowerUp* existing = FindActivePowerUp(def);
-    if (existing)
-    {
-        // refresh timer only
-        existing->timer = def->durationFrames;
-        return;
-    }
+    bool launchPressed = false, restartPressed = false;
+    float held = 0.f; // net right-minus-left fraction of the tick
+    float mouse = 0.f;
+    double cursor = tickStart;
 
-    // find empty slot
-    for (int i = 0; i < 10; ++i)
+    unsigned int tail = g_inputQueue.tail.load(std::memory_order_relaxed);
+    unsigned int head = g_inputQueue.head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail)
     {
-        if (g_activePowerUps[i].timer <= 0)
-        {
-            g_activePowerUps[i].def = def;
-            g_activePowerUps[i].timer = def->durationFrames;
-            def->applyFunc();
+        const InputEvent& e = g_inputQueue.events[tail & (INPUT_QUEUE_SIZE - 1)];
+        if (e.time > tickEnd) break;
+
+        double t = (e.time > cursor) ? e.time : cursor;
+        float fraction = (float)((t - cursor) / span);
+        if (g_keyRight) held += fraction;
+        if (g_keyLeft) held -= fraction;
+        cursor = t;
+
+        bool down = (e.type == INPUT_KEY_DOWN);
+        switch (e.type)
+        {
+        case INPUT_KEY_DOWN:
+        case INPUT_KEY_UP:
+            if (e.value == VK_LEFT) g_keyLeft = down;
+            else if (e.value == VK_RIGHT) g_keyRight = down;
+            else if (e.value == VK_SPACE) { g_keyLaunch = down; launchPressed |= down; }
+            else if (e.value == 'R') { g_keyRestart = down; restartPressed |= down; }
+            break;
+        case INPUT_MOUSE_MOVE:
+            mouse += e.value * MOUSE_PADDLE_SCALE;
+            break;
+        case INPUT_RELEASE_ALL:
+            g_keyLeft = g_keyRight = g_keyLaunch = g_keyRestart = false;
             break;
-        }
-    }
-}
-
-void UpdateFallingPowerUps()
-{
-    const float FALL_SPEED = 2.f;
-
-    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
-    {
-        FallingPowerUp& pu = g_fallingPowerUps[i];
-        if (!pu.alive) continue;
-
-        pu.y += FALL_SPEED;
-
-        RECT paddleRect = { (LONG)g_paddle.x, (LONG)g_paddle.y,
-                            (LONG)(g_paddle.x + g_paddle.w), (LONG)(g_paddle.y + g_paddle.h) };
-
-        if (CircleRectIntersect(pu.x, pu.y, 8.f, paddleRect))
-        {
-            ApplyPowerUp(pu.index);
-            pu.alive = false;
         }
 
-        // Remove if it falls off screen
-        if (pu.y > g_backH + 10.f)
-            pu.alive = false;
+        g_lastInputTime = e.time;
+        g_lastInputSeq++;
     }
-}
+    g_inputQueue.tail.store(tail, std::memory_order_release);
 
-void UpdateActivePowerUps()
-{
-    for (int i = 0; i < 10; ++i)
-    {
-        ActivePowerUp& apu = g_activePowerUps[i];
-        if (apu.timer > 0)
-        {
-            apu.timer--;
-            if (apu.timer == 0)
-            {
-                // Remove effect when timer ends
-                if (apu.def && apu.def->revertFunc)
-                    apu.def->revertFunc();
+    float fraction = (float)((tickEnd - cursor) / span);
+    if (g_keyRight) held += fraction;
+    if (g_keyLeft) held -= fraction;
 
-                apu.def = nullptr;
-            }
-        }
-    }
+    in.paddleMove = held * PADDLE_SPEED + mouse;
+    in.launch = g_keyLaunch || launchPressed;
+    in.restart = g_keyRestart || restartPressed;
+    return in;
 }
 
+#ifdef _WIN32
 // ============================================================
-// Update / Game Logic
+// Simulation Thread
 // ============================================================
 
-void HandleInput()
-{
-    g_paddlePrevX = g_paddle.x;
-    if (GetAsyncKeyState(VK_LEFT)) g_paddle.x -= PADDLE_SPEED;
-    if (GetAsyncKeyState(VK_RIGHT)) g_paddle.x += PADDLE_SPEED;
-    g_paddle.x = Clamp(g_paddle.x, 0.f, (float)g_backW - g_paddle.w);
-    g_paddleVX = g_paddle.x - g_paddlePrevX;
-}
-
-void HandleLaunchInput()
-{
-    if (g_gameOver && (GetAsyncKeyState('R') & 0x8000))
-        InitGame();
-
-    if (!g_gameOver && !g_ballLaunched && (GetAsyncKeyState(VK_SPACE) & 0x8000)){
-
-        g_ballLaunched = true;
-    }
-}
-
-void UpdateBall()
-{
-    int aliveCount = 0;
-
-    if (g_ballLaunched)
+// Ticks at a fixed rate on its own thread and publishes a snapshot per tick,
+// so GDI stalls, window drags and back-buffer rebuilds on the UI thread
+// never delay the simulation.
+static std::atomic<bool> g_simQuit{ false };
+static std::atomic<bool> g_autoplay{ false }; // F2
+static HANDLE g_frameReady = NULL; // auto-reset, signalled per published tick
+static ScoreTracker g_scoreTracker; // simulation thread only
+static GameState g_game; // set up by WinMain, then simulation thread only
+
+void SimulationThread()
+{
+    timeBeginPeriod(1);
+
+    GameState& g = g_game;
+    const double tickSeconds = 1.0 / TICK_HZ;
+    double nextTick = QpcSeconds();
+    double lastTick = nextTick - tickSeconds;
+    bool adopted = false;
+    while (!g_simQuit)
     {
-        for (int i = 0; i < g_ballMax; ++i)
-        {
-            Ball& b = g_ball[i];
-            if (b.alive && b.stuck)
-            {
-                b.stuck = false;
-                //Force launch direction and velocity
-				b.vx = (i & 1) ? BASE_BALL_SPEED * 0.5f : BASE_BALL_SPEED * 0.7f;
-				b.vy = -BASE_BALL_SPEED;
-            }
+        if (!adopted) adopted = AdoptDeferredSubsystems(g);
+        double now = QpcSeconds();
+        TickInput in = CollectTickInput(lastTick, now);
+        UpdateGame(g, g_autoplay ? AutoplayInput(g) : in);
+        TrackScores(g, g_autoplay ? nullptr : g_scores, g_scoreTracker); // the autoplayer's games aren't the player's
+        if (g.hooks.particles) AdvanceParticles(g, *g.hooks.particles);
+        lastTick = now;
+        g_simTick++;
+        PublishSnapshot(g);
+        SetEvent(g_frameReady);
+
+        nextTick += tickSeconds;
+        now = QpcSeconds();
+        if (now - nextTick > 0.25) nextTick = now; // suspended or debugged: don't try to catch up
+
+        // Sleep most of the wait, then yield the last millisecond away
+        for (;;)
+        {
+            double wait = nextTick - QpcSeconds();
+            if (wait <= 0.0) break;
+            Sleep(wait > 0.002 ? (DWORD)((wait - 0.001) * 1000.0) : 0);
         }
     }
-    for (int i = 0; i < g_ballMax; ++i)
-    {
-        Ball& b = g_ball[i];
-        if (!b.alive) continue;
 
-        // --- Sticky paddle hold ---
-        if (b.stuck || !g_ballLaunched)
-        {
-            b.x = g_paddle.x + g_paddle.w * 0.5f;
-            b.y = g_paddle.y - b.r - 1.f;
-            continue; // skip motion
-        }
-
-        // Apply spin curve
-        b.vx += b.spin * 0.02f;
-        // Spin decay
-        b.spin *= 0.995f;
- 
-        // --- Normal movement ---
-        b.x += b.vx;
-        b.y += b.vy;
-        // Left / Right walls
-        if (b.x - b.r < 0)
-        {
-            b.x = b.r;
-            b.vx = -b.vx;
-        }
-        else if (b.x + b.r > g_backW)
-        {
-            b.x = g_backW - b.r;
-            b.vx = -b.vx;
-        }
-        // Top wall
-        if (b.y - b.r < 0)
-        {
-            b.y = b.r;
-            b.vy = -b.vy;
-        }
-        // Bottom (ball lost)
-        if (b.y - b.r > g_backH)
-        {
-            b.alive = false;
-            continue;
-        }
-        // Only count balls that are alive and on-screen
-		aliveCount++;
-    }
-    // If ALL balls are gone ? lose life
-    if (aliveCount == 0 && g_ballLaunched)
-    {
-        g_lives--;
-
-        if (g_lives <= 0)
-        {
-            g_lives = 0;
-            g_gameOver = true;
-            g_ballLaunched = false;
-        }
-        else
-        {
-			KillAllBalls();
-            InitBall();       // respawn base balls
-            g_ballLaunched = false;
-        }
-    }
+    timeEndPeriod(1);
 }
 
-void HandlePaddleCollision()
-{
-    if (!g_ballLaunched) return;
-
-    RECT paddleRect = { (LONG)g_paddle.x, (LONG)g_paddle.y,
-                        (LONG)(g_paddle.x + g_paddle.w), (LONG)(g_paddle.y + g_paddle.h) };
-
-    for (int i = 0; i < g_ballMax; ++i)
-    {
-        Ball& ball = g_ball[i];
-        if (!ball.alive) continue;
-        if (ball.vy <= 0.f) continue;
-
-        if (!CircleRectIntersect(ball.x, ball.y, ball.r, paddleRect))
-            continue;
+// ============================================================
+// Rendering
+// ============================================================
 
-        // Sticky paddle: stop ball until relaunch
-        if (g_stickyPaddle)
-        {
-		    ball.stuck = true;
-            g_ballLaunched = false;
-            continue;
-        }
-        // Calculate hit position (-1 .. 1)
-        float hit =
-            (ball.x - (g_paddle.x + g_paddle.w * 0.5f)) /
-            (g_paddle.w * 0.5f);
-        hit = Clamp(hit, -1.f, 1.f);
-
-        const float DEAD_ZONE = 0.2f;
-        const float MAX_ANGLE = 70.f * 3.14159f / 180.f;
-        float angleFactor = 0.f;
-
-        if (fabsf(hit) < DEAD_ZONE) { angleFactor = hit * 0.25f; }
-        else
-        {
-            float sign = (hit < 0.f) ? -1.f : 1.f;
-            float t = (fabsf(hit) - DEAD_ZONE) / (1.f - DEAD_ZONE);
-            angleFactor = sign * (t * t);
-        }
+// Input-to-present latency, measured on the UI thread right after BitBlt
+// for each snapshot that carries a new input event. F3 shows it.
+struct LatencyStats
+{
+    unsigned int lastSeq = 0;
+    int samples = 0;
+    double last = 0.0, total = 0.0, worst = 0.0;
+};
 
-        float speed = sqrtf(ball.vx * ball.vx + ball.vy * ball.vy);
-        float angle = angleFactor * MAX_ANGLE;
+static LatencyStats g_inputLatency;
+static bool g_showLatency = false;
+static bool g_showMemory = false; // F4: resident set and the per-tag counters
 
-        ball.vx = sinf(angle) * speed;
-        ball.vy = -cosf(angle) * speed;
+void RecordPresentLatency(const RenderSnapshot& snap)
+{
+    LatencyStats& s = g_inputLatency;
+    if (snap.inputSeq == s.lastSeq) return;
+    s.lastSeq = snap.inputSeq;
 
-        if (g_spin)
-        {
-            ball.spin += g_paddleVX * 0.05f;
-            ball.spin = Clamp(ball.spin, -1.f, 1.f);
-        }
-    }
+    s.last = QpcSeconds() - snap.inputTime;
+    s.total += s.last;
+    if (s.last > s.worst) s.worst = s.last;
+    s.samples++;
 }
 
-void HandleBrickCollisions()
+// Bricks a tile at a time, skipping empty tiles and any below the window.
+// Once bricks shrink under a few pixels each tile is drawn as one block in
+// the color of its strongest brick.
+void RenderBricks(HDC hdc, const RenderSnapshot& snap, const ViewTransform& view)
 {
-    if (!g_ballLaunched) return;
+    const int TILE_CELLS = BRICK_TILE * BRICK_TILE;
+    const int pitchX = BRICK_W + BRICK_GAP, pitchY = BRICK_H + BRICK_GAP;
+    const bool blocks = BRICK_W * view.scale < 3.f;
+    const int viewBottom = (int)((g_viewH - view.y) / view.scale);
 
-    int lvlIndex = g_level - 1;
-    if (lvlIndex < 0) lvlIndex = 0;
-    if (lvlIndex >= g_levelCount) lvlIndex = g_levelCount - 1;
+    HBRUSH brushes[6]; // hits 1..5, then anything else
+    for (int i = 0; i < 6; ++i) brushes[i] = CreateSolidBrush(GetBrickColor(i + 1));
+    HBRUSH old = (HBRUSH)SelectObject(hdc, brushes[0]);
 
-    const LevelDef& lvl = g_levels[lvlIndex];
-
-    for (int b = 0; b < g_ballMax; ++b)
+    int tilesY = (snap.boardRows + BRICK_TILE - 1) >> BRICK_TILE_SHIFT;
+    for (int ty = 0; ty < tilesY; ++ty)
     {
-        Ball& ball = g_ball[b];
-        if (!ball.alive) continue;
-
-        for (int i = 0; i < BRICK_ROWS * BRICK_COLS; ++i)
+        int top = snap.boardOriginY + ty * BRICK_TILE * pitchY + snap.brickOffsetY;
+        if (top > viewBottom) break;
+        for (int tx = 0; tx < snap.boardTilesX; ++tx)
         {
-            Brick& brick = g_bricks[i];
-            if (!brick.alive) continue;
-            if (!CircleRectIntersect(ball.x, ball.y, ball.r, brick.rect)) continue;
+            const uint8_t* tile = &snap.brickHits[(size_t)(ty * snap.boardTilesX + tx) * TILE_CELLS];
+            int left = snap.boardOriginX + tx * BRICK_TILE * pitchX;
 
-
-            // Handle brick penetration and destruction
-            if (ball.penetrateCount > 0) {
-                brick.alive = false;
-                brick.hits = 0;
-                ball.penetrateCount--; // decrement penetration
-                g_score += 100;
+            if (blocks)
+            {
+                int strongest = 0;
+                for (int i = 0; i < TILE_CELLS; ++i) strongest = max(strongest, (int)tile[i]);
+                if (strongest == 0) continue;
+                SelectObject(hdc, brushes[min(strongest, 6) - 1]);
+                Rectangle(hdc, left, top, left + BRICK_TILE * pitchX - BRICK_GAP, top + BRICK_TILE * pitchY - BRICK_GAP);
+                continue;
             }
 
-            //Handle normal brick hits
-            else {
-                brick.hits--;
-                if (brick.hits <= 0)
-                {
-                    brick.alive = false;
-                    g_score += 100;
-                }
-                else
-                {
-                    brick.color = GetBrickColor(brick.hits);
-                    g_score += 25;
-                }
-                if (!brick.alive) {
-                    int row = i / BRICK_COLS;
-                    int col = i % BRICK_COLS;
-
-                    // Get the power-up rule for this brick
-                    int puRule = -1;
-                    if (row < lvl.rows && col < lvl.cols)
-                    { puRule = lvl.mustDropPowerUp[row][col];}
-
-                    // Decide which power-up to spawn, if any
-                    bool shouldDrop = false;
-
-                    if (puRule > 0){
-                            shouldDrop = true;
-                    }
-                    else if (puRule == 0) {
-                        shouldDrop = (rand() % 5) == 0; // 20%
-                       }
-                    else {shouldDrop = false;}
-
-                    if (shouldDrop)
-                    {
-                        float px = (brick.rect.left + brick.rect.right) * 0.5f;
-                        float py = (brick.rect.top + brick.rect.bottom) * 0.5f;
-
-                        if (puRule > 0) {
-                            SpawnPowerUp(px, py, puRule - 1);
-                        }
-                        else {
-                            SpawnPowerUp(px, py);
-                        }
-                    }
-                }
-
-                // Reflect ball only if no penetrateCount left
-                if (ball.penetrateCount == 0)
-                {
-
-                    // Determine collision side
-                    float left = ball.x - brick.rect.left;
-                    float right = brick.rect.right - ball.x;
-                    float top = ball.y - brick.rect.top;
-                    float bottom = brick.rect.bottom - ball.y;
-
-                    if (min(left, right) < min(top, bottom)) { ball.vx = -ball.vx; }
-                    else
-                    {
-                        ball.vy = -ball.vy;
-                        ball.vx += ball.spin * 0.2f;
-                        ball.penetrateCount = ball.penetrateMax; // reset penetrate count after reflection
-                    }
-                }
+            for (int i = 0; i < TILE_CELLS; ++i)
+            {
+                if (tile[i] == 0) continue;
+                int x = left + (i & (BRICK_TILE - 1)) * pitchX;
+                int y = top + (i >> BRICK_TILE_SHIFT) * pitchY;
+                SelectObject(hdc, brushes[min((int)tile[i], 6) - 1]);
+                Rectangle(hdc, x, y, x + BRICK_W, y + BRICK_H);
             }
         }
     }
-}
-
-bool AreAllBricksCleared()
-{
-    for (int i = 0; i < BRICK_ROWS * BRICK_COLS; ++i)
-        if (g_bricks[i].alive) return false;
-    return true;
-}
-
-void CheckLevelCompletion()
-{
-    if (g_gameOver) return;
-
-    static bool levelAdvancePending = false;
-
-    if (!levelAdvancePending && AreAllBricksCleared())
-    {
-        levelAdvancePending = true;
-        g_ballLaunched = false;
-    }
 
-    if (levelAdvancePending && !g_ballLaunched)
-    {
-        g_level++;
-        InitBricksForLevel(g_level);
-		KillAllBalls();
-        InitBall();
-        levelAdvancePending = false;
-    }
+    SelectObject(hdc, old);
+    for (int i = 0; i < 6; ++i) DeleteObject(brushes[i]);
 }
 
-void UpdateGame()
+// HUD font at 'hud' times its 1:1 height, remade only when that changes
+HFONT HudFont(float hud)
 {
-    HandleInput();
-    HandleLaunchInput();
-    UpdateBall();
-
-    if (g_ballLaunched)
+    static HFONT font = NULL;
+    static int height = 0;
+    int h = (int)(16 * hud);
+    if (!font || h != height)
     {
-        HandlePaddleCollision();
-        HandleBrickCollisions();
+        if (font) DeleteObject(font);
+        font = CreateFont(-h, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
+            CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY, DEFAULT_PITCH | FF_SWISS, NULL);
+        height = h;
     }
-    UpdateFallingPowerUps();      // <--- added
-    UpdateActivePowerUps();       // <--- added
-    CheckLevelCompletion();
+    return font;
 }
 
-// ============================================================
-// Rendering
-// ============================================================
-
-void Render(HDC hdc){
+void Render(HDC hdc, const RenderSnapshot& snap){
 
 // Clear background
-PatBlt(hdc, 0, 0, g_backW, g_backH, BLACKNESS);
+PatBlt(hdc, 0, 0, g_viewW, g_viewH, BLACKNESS);
 
-// Draw bricks
-for (int i = 0; i < BRICK_ROWS * BRICK_COLS; ++i)
-{
-    Brick& b = g_bricks[i];
-    if (!b.alive) continue;
+// The world is in logical units; fit it to the window, letterboxed. Only
+// the transform depends on the window size, nothing is laid out again.
+ViewTransform view = FitView(snap.worldW, snap.worldH, g_viewW, g_viewH);
+const float hud = HudScale(view);
+XFORM xf = { view.scale, 0.f, 0.f, view.scale, (float)view.x, (float)view.y };
+SetGraphicsMode(hdc, GM_ADVANCED);
+SetWorldTransform(hdc, &xf);
 
-    HBRUSH brush = CreateSolidBrush(b.color);
-    HBRUSH old = (HBRUSH)SelectObject(hdc, brush);
-    Rectangle(hdc, b.rect.left, b.rect.top, b.rect.right, b.rect.bottom);
-    SelectObject(hdc, old);
-    DeleteObject(brush);
-}
+// Draw bricks
+RenderBricks(hdc, snap, view);
 
 // Draw paddle
-Rectangle(hdc, (int)g_paddle.x, (int)g_paddle.y,
-    (int)(g_paddle.x + g_paddle.w), (int)(g_paddle.y + g_paddle.h));
+Rectangle(hdc, (int)snap.paddleX, (int)snap.paddleY,
+    (int)(snap.paddleX + snap.paddleW), (int)(snap.paddleY + snap.paddleH));
 
 // Draw all active balls
-for (int i = 0; i < g_ballMax; ++i)
+for (size_t i = 0; i < snap.balls.size(); ++i)
 {
-    Ball& ball = g_ball[i];
-    if (!ball.alive) continue;
+    const RenderBall& ball = snap.balls[i];
 
     Ellipse(hdc,
         (int)(ball.x - ball.r),
@@ -1036,55 +563,268 @@ for (int i = 0; i < g_ballMax; ++i)
 
 // Draw power-ups
 
-for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+for (int i = 0; i < snap.powerUpCount; ++i)
 {
-    FallingPowerUp& pu = g_fallingPowerUps[i];
-    if (!pu.alive) continue;
+    const RenderPowerUp& pu = snap.powerUps[i];
 
-    HBRUSH brush = CreateSolidBrush(g_powerUps[pu.index].color);
+    HBRUSH brush = CreateSolidBrush(pu.color);
     HBRUSH old = (HBRUSH)SelectObject(hdc, brush);
     Ellipse(hdc, (int)(pu.x - 8), (int)(pu.y - 8), (int)(pu.x + 8), (int)(pu.y + 8));
     SelectObject(hdc, old);
     DeleteObject(brush);
 }
 
+ModifyWorldTransform(hdc, NULL, MWT_IDENTITY);
+SetGraphicsMode(hdc, GM_COMPATIBLE);
+
+// Particles go straight into the pixels, once GDI is done with them
+if (g_backBits && !snap.particleX.empty())
+{
+    GdiFlush();
+    DrawParticles(snap.particleX.data(), snap.particleY.data(), snap.particleColor.data(),
+        (int)snap.particleX.size(), g_backBits, g_backW, g_viewW, g_viewH, view);
+}
+
 // Draw score, lives, level
 char buf[64];
+HFONT oldFont = (HFONT)SelectObject(hdc, HudFont(hud));
 SetBkMode(hdc, TRANSPARENT);
 SetTextColor(hdc, RGB(250, 250, 250));
-sprintf_s(buf, sizeof(buf), "Score: %d", g_score);
-TextOutA(hdc, 10, 10, buf, (int)strlen(buf));
-sprintf_s(buf, sizeof(buf), "Lives: %d", g_lives);
-TextOutA(hdc, 170, 10, buf, (int)strlen(buf));
-sprintf_s(buf, sizeof(buf), "Level: %d", g_level);
-TextOutA(hdc, 340, 10, buf, (int)strlen(buf));
+const int hudX = view.x, hudY = view.y;
+sprintf_s(buf, sizeof(buf), "Score: %d", snap.score);
+TextOutA(hdc, hudX + (int)(10 * hud), hudY + (int)(10 * hud), buf, (int)strlen(buf));
+sprintf_s(buf, sizeof(buf), "Lives: %d", snap.lives);
+TextOutA(hdc, hudX + (int)(170 * hud), hudY + (int)(10 * hud), buf, (int)strlen(buf));
+sprintf_s(buf, sizeof(buf), "Level: %d", snap.level);
+TextOutA(hdc, hudX + (int)(340 * hud), hudY + (int)(10 * hud), buf, (int)strlen(buf));
+
+if (g_showLatency && g_inputLatency.samples > 0)
+{
+    const LatencyStats& lat = g_inputLatency;
+    sprintf_s(buf, sizeof(buf), "Input->present: %.1f ms (avg %.1f, max %.1f)",
+        lat.last * 1e3, lat.total * 1e3 / lat.samples, lat.worst * 1e3);
+    TextOutA(hdc, hudX + (int)(10 * hud), hudY + (int)(30 * hud), buf, (int)strlen(buf));
+}
+
+if (g_showMemory)
+{
+    int line = 50;
+    sprintf_s(buf, sizeof(buf), "RSS %.1f MB (peak %.1f), %llu allocations",
+        g_rssBytes.load(std::memory_order_relaxed) / 1048576.0, g_rssPeak.load(std::memory_order_relaxed) / 1048576.0,
+        (unsigned long long)g_allocCount.load(std::memory_order_relaxed));
+    TextOutA(hdc, hudX + (int)(10 * hud), hudY + (int)(line * hud), buf, (int)strlen(buf));
+    for (int i = 0; i < MEM_TAGS; ++i)
+    {
+        const MemCounters& m = g_mem[i];
+        if (m.peak.load(std::memory_order_relaxed) == 0) continue;
+        line += 18;
+        sprintf_s(buf, sizeof(buf), "%-10s %9.1f KB (peak %.1f), %llu allocations", MEM_TAG_NAMES[i],
+            m.bytes.load(std::memory_order_relaxed) / 1024.0, m.peak.load(std::memory_order_relaxed) / 1024.0,
+            (unsigned long long)m.allocs.load(std::memory_order_relaxed));
+        TextOutA(hdc, hudX + (int)(10 * hud), hudY + (int)(line * hud), buf, (int)strlen(buf));
+    }
+}
 
 // Game Over message
-if (g_gameOver)
+if (snap.gameOver)
 {
     const char* msg = "GAME OVER! Press R to Restart";
     int len = (int)strlen(msg);
-    int x = g_backW / 2 - (len * 4);
-    int y = g_backH / 2;
+    int x = view.x + (int)(snap.worldW * view.scale) / 2 - (int)(len * 4 * hud);
+    int y = view.y + (int)(snap.worldH * view.scale) / 2;
     TextOutA(hdc, x, y, msg, len);
 }
+SelectObject(hdc, oldFont);
+}
+
+#endif // _WIN32
+
+// ============================================================
+// Console
+// ============================================================
+
+// GUI subsystem: borrow the launching console, or open one. Returns true
+// if one was opened (CloseConsole then waits for Enter so it can be read).
+bool OpenConsole()
+{
+#ifdef _WIN32
+    bool ownConsole = false;
+    if (!AttachConsole(ATTACH_PARENT_PROCESS))
+        ownConsole = AllocConsole() != 0;
+    FILE* out = NULL;
+    freopen_s(&out, "CONOUT$", "w", stdout);
+    return ownConsole;
+#else
+    return false;
+#endif
+}
+void CloseConsole(bool ownConsole)
+{
+#ifdef _WIN32
+    if (ownConsole)
+    {
+        printf("\nPress Enter to close.\n");
+        FILE* in = NULL;
+        freopen_s(&in, "CONIN$", "r", stdin);
+        getchar();
+    }
+#else
+    (void)ownConsole;
+#endif
+}
+// ============================================================
+// Startup Time (breakblocks --startup)
+// ============================================================
+
+// WinMain's startup with the window taken out: the deferred subsystems on
+// their side thread, the game, one tick and its frame through the software
+// renderer. Fails if that first frame took more than STARTUP_BUDGET.
+static const double STARTUP_BUDGET = 0.050;
+
+int RunStartupProfile()
+{
+    StartupBegin();
+    const char* scorePath = "startup_scores.bbl";
+    StartDeferredInit(scorePath);
+
+    GameState g;
+    InitGameState(g, (uint32_t)time(NULL));
+    StartupMark("game");
+
+    AdoptDeferredSubsystems(g); // whatever is ready by now, as on the simulation thread
+    RenderSnapshot* snap = new RenderSnapshot;
+    TickInput in;
+    UpdateGame(g, in);
+    CaptureSnapshot(g, *snap);
+    StartupMark("first tick");
+
+    std::vector<uint32_t> pixels((size_t)SCREEN_W * SCREEN_H);
+    RasterizeSnapshot(*snap, pixels.data(), SCREEN_W, SCREEN_H);
+    StartupMark("first frame");
+    double firstFrame = QpcSeconds() - g_startupBegin;
+
+    StopDeferredSubsystems(g);
+    remove(scorePath);
+    delete snap;
+
+    WriteStartupProfile(stdout);
+    bool ok = firstFrame <= STARTUP_BUDGET;
+    printf("first frame after %.3f ms (budget %.0f ms)%s\n", firstFrame * 1e3, STARTUP_BUDGET * 1e3,
+        ok ? "" : "  OVER BUDGET");
+    return ok ? 0 : 1;
 }
 
+#if !defined(_WIN32) && !defined(BREAKBLOCKS_LIBRARY) && !defined(BREAKBLOCKS_FUZZER)
+// ============================================================
+// Headless Entry Point
+// ============================================================
+
+int main(int argc, char** argv)
+{
+    const char* mode = (argc > 1) ? argv[1] : "";
+    if (strcmp(mode, "--bench") == 0)
+        return RunBenchmarks();
+    if (strcmp(mode, "--soak") == 0)
+        return RunSoak(argc > 2 ? atof(argv[2]) : 1.0, argc > 3 ? argv[3] : NULL);
+    if (strcmp(mode, "--plan") == 0)
+        return RunPlanner(argc > 2 ? atoi(argv[2]) : 64);
+    if (strcmp(mode, "--audio") == 0)
+        return RunAudioCapture(argc > 2 ? argv[2] : NULL, argc > 3 ? atof(argv[3]) : 30.0);
+    if (strcmp(mode, "--startup") == 0)
+        return RunStartupProfile();
+    if (strcmp(mode, "--export") == 0)
+        return RunExport(argc > 2 ? argv[2] : "replay.y4m", argc > 3 ? atof(argv[3]) : 30.0,
+            argc > 4 ? (uint32_t)strtoul(argv[4], NULL, 10) : 1);
+    if (strcmp(mode, "--fuzz") == 0)
+        return RunFuzzer(argc > 2 ? atoi(argv[2]) : 1000, argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 10) : (uint32_t)time(NULL));
+    if (strcmp(mode, "--golden") == 0 && argc > 2 && strcmp(argv[2], "record") == 0)
+        return RunGoldenRecord(argc > 3 ? argv[3] : GOLDEN_CORPUS, argc > 4 ? atoi(argv[4]) : GOLDEN_SESSIONS,
+            argc > 5 ? atoi(argv[5]) : GOLDEN_TICKS, argc > 6 ? (uint32_t)strtoul(argv[6], NULL, 10) : 1);
+    if (strcmp(mode, "--golden") == 0 && argc > 2 && strcmp(argv[2], "check") == 0)
+        return RunGoldenCheck(argc > 3 ? argv[3] : GOLDEN_CORPUS, argc > 4 ? (float)atof(argv[4]) : 0.f);
+#ifdef __linux__
+    if (strcmp(mode, "--server") == 0)
+        return RunServer(argc > 2 ? argv[2] : "7777", argc > 3 && *argv[3] ? argv[3] : NULL,
+            argc > 4 ? argv[4] : "scores.bbl");
+    if (strcmp(mode, "--loopback") == 0)
+        return RunLoopbackTest(argc > 2 ? atoi(argv[2]) : 1000, argc > 3 ? atoi(argv[3]) : 300);
+#endif
+
+    printf("usage: %s --bench | --soak [hours] [csv prefix] | --plan [rollouts] | --audio [wav] [seconds] | --export [out.y4m | out.mp4 | -] [seconds] [seed] | --startup | --fuzz [cases] [seed] | --golden record [corpus] [sessions] [ticks] [seed] | --golden check [corpus] [tolerance] | --server [port | unix:path] [csv prefix] [score log] | --loopback [sessions] [ticks]\n", argv[0]);
+    return 1;
+}
+#endif
+
+#if defined(_WIN32) && !defined(BREAKBLOCKS_LIBRARY) && !defined(BREAKBLOCKS_FUZZER)
 // ============================================================
 // Win32 Boilerplate
 // ============================================================
 
+// Sizes the window so its client area shows the logical SCREEN_W x SCREEN_H
+// at 'dpi' (USER_DEFAULT_SCREEN_DPI = 100%)
+void SizeWindowForDpi(HWND hwnd, UINT dpi)
+{
+    RECT window, client;
+    GetWindowRect(hwnd, &window);
+    GetClientRect(hwnd, &client);
+    int frameW = (window.right - window.left) - client.right;
+    int frameH = (window.bottom - window.top) - client.bottom;
+    SetWindowPos(hwnd, NULL, 0, 0, MulDiv(SCREEN_W, dpi, USER_DEFAULT_SCREEN_DPI) + frameW,
+        MulDiv(SCREEN_H, dpi, USER_DEFAULT_SCREEN_DPI) + frameH, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+}
+
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
     switch (msg)
     {
     case WM_SIZE:
     {
+        // Only the view changes; the game keeps its logical coordinates
         int w = LOWORD(lParam);
         int h = HIWORD(lParam);
-        if (w > 0 && h > 0) CreateBackBuffer(hwnd, w, h);
+        if (w > 0 && h > 0) ResizeBackBuffer(hwnd, w, h);
         return 0;
     }
+    case WM_DPICHANGED:
+    {
+        // Moved to a monitor with another scale: take the size Windows suggests
+        const RECT* r = (const RECT*)lParam;
+        SetWindowPos(hwnd, NULL, r->left, r->top, r->right - r->left, r->bottom - r->top,
+            SWP_NOZORDER | SWP_NOACTIVATE);
+        return 0;
+    }
+    case WM_KEYDOWN:
+        if (lParam & (1 << 30)) return 0; // auto-repeat
+        if (wParam == VK_F2)
+            g_autoplay = !g_autoplay;
+        if (wParam == VK_F3)
+        {
+            g_showLatency = !g_showLatency;
+            g_inputLatency = LatencyStats();
+        }
+        if (wParam == VK_F4)
+            g_showMemory = !g_showMemory;
+        if (IsGameKey((int)wParam)) PushInputEvent(INPUT_KEY_DOWN, (int)wParam);
+        return 0;
+    case WM_KEYUP:
+        if (IsGameKey((int)wParam)) PushInputEvent(INPUT_KEY_UP, (int)wParam);
+        return 0;
+    case WM_INPUT:
+    {
+        RAWINPUT raw;
+        UINT size = sizeof(raw);
+        if (GetRawInputData((HRAWINPUT)lParam, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) != (UINT)-1 &&
+            raw.header.dwType == RIM_TYPEMOUSE &&
+            !(raw.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE) &&
+            raw.data.mouse.lLastX != 0)
+        {
+            PushInputEvent(INPUT_MOUSE_MOVE, (int)raw.data.mouse.lLastX);
+        }
+        break; // DefWindowProc does the WM_INPUT cleanup
+    }
+    case WM_KILLFOCUS:
+        PushInputEvent(INPUT_RELEASE_ALL, 0);
+        return 0;
     case WM_DESTROY:
         DestroyBackBuffer();
         PostQuitMessage(0);
@@ -1094,8 +834,34 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
     return DefWindowProc(hwnd, msg, wParam, lParam);
 }
 
-int WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, int)
-{
+int WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR cmdLine, int)
+{
+    StartupBegin();
+    if (cmdLine && strstr(cmdLine, "/bench"))
+        return RunBenchmarks();
+    if (cmdLine && strstr(cmdLine, "/soak"))
+        return RunSoak(atof(strstr(cmdLine, "/soak") + 5), NULL);
+    if (cmdLine && strstr(cmdLine, "/plan"))
+        return RunPlanner(atoi(strstr(cmdLine, "/plan") + 5));
+    if (cmdLine && strstr(cmdLine, "/audio"))
+        return RunAudioCapture("audio.wav", atof(strstr(cmdLine, "/audio") + 6));
+    if (cmdLine && strstr(cmdLine, "/export"))
+        return RunExport("replay.y4m", atof(strstr(cmdLine, "/export") + 7), 1);
+    if (cmdLine && strstr(cmdLine, "/fuzz"))
+        return RunFuzzer(atoi(strstr(cmdLine, "/fuzz") + 5), (uint32_t)time(NULL));
+    if (cmdLine && strstr(cmdLine, "/golden"))
+    {
+        const char* args = strstr(cmdLine, "/golden") + 7;
+        if (strstr(args, "record"))
+            return RunGoldenRecord(GOLDEN_CORPUS, GOLDEN_SESSIONS, GOLDEN_TICKS, 1);
+        return RunGoldenCheck(GOLDEN_CORPUS, (float)atof(args));
+    }
+
+    // /stress rows cols balls: a stress board under the autoplayer, scaled
+    // down to fit the window. Its scores aren't kept.
+    const char* stress = cmdLine ? strstr(cmdLine, "/stress") : NULL;
+    StartDeferredInit(stress ? NULL : "scores.bbl");
+
     WNDCLASS wc = {};
     wc.lpfnWndProc = WndProc;
     wc.hInstance = hInst;
@@ -1103,45 +869,114 @@ int WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, int)
     wc.hCursor = LoadCursor(NULL, IDC_ARROW);
 
     RegisterClass(&wc);
+    StartupMark("window class");
+
+    // Pixels are real pixels on every monitor; Render scales the logical
+    // playfield up to them instead of Windows stretching a blurry bitmap
+    SetProcessDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
 
     HWND hwnd = CreateWindow(
         wc.lpszClassName,
         L"Breakout - Clean Version",
-        WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU,
+        WS_OVERLAPPEDWINDOW,
         CW_USEDEFAULT, CW_USEDEFAULT,
         SCREEN_W, SCREEN_H,
         NULL, NULL, hInst, NULL);
 
+    SizeWindowForDpi(hwnd, GetDpiForWindow(hwnd));
     ShowWindow(hwnd, SW_SHOW);
+    StartupMark("window");
 
     RECT rc; GetClientRect(hwnd, &rc);
-    CreateBackBuffer(hwnd, rc.right, rc.bottom);
+    ResizeBackBuffer(hwnd, rc.right, rc.bottom);
+    StartupMark("back buffer");
+
+    // Relative mouse motion for analog paddle control (foreground only)
+    RAWINPUTDEVICE mouse = {};
+    mouse.usUsagePage = 0x01; // generic desktop
+    mouse.usUsage = 0x02;     // mouse
+    mouse.hwndTarget = hwnd;
+    RegisterRawInputDevices(&mouse, 1, sizeof(mouse));
+
+    g_scoreTracker.seed = (uint32_t)time(NULL);
+    SeedGameRand(g_game, g_scoreTracker.seed);
+
+    if (stress)
+    {
+        char* p = (char*)stress + 7;
+        int rows = (int)strtol(p, &p, 10);
+        int cols = (int)strtol(p, &p, 10);
+        int balls = (int)strtol(p, &p, 10);
+        InitStressGame(g_game, min(max(rows, 1), MAX_BOARD_DIM), min(max(cols, 1), MAX_BOARD_DIM), balls > 0 ? balls : 64);
+        g_autoplay = true;
+    }
+    else
+        InitGame(g_game);
+    StartupMark("game");
+
+    // /ballcollide: balls bounce off each other
+    if (cmdLine && strstr(cmdLine, "/ballcollide")) g_game.ballCollisions = true;
+
+    // /telemetry: record this session, written to telemetry_*.csv on exit
+    Telemetry telemetry;
+    bool recordTelemetry = cmdLine && strstr(cmdLine, "/telemetry");
+    if (recordTelemetry) AttachTelemetry(g_game, &telemetry);
 
-    srand((unsigned int)time(NULL));
-    InitGame();
+    // Simulation runs on its own thread from here on; this thread only
+    // pumps messages and presents the latest snapshot.
+    g_frameReady = CreateEvent(NULL, FALSE, FALSE, NULL);
+    std::thread simThread(SimulationThread);
+    StartupMark("simulation thread");
+    StartRssSampler(1.0);
 
     MSG msg = {};
+    bool presented = false;
     while (msg.message != WM_QUIT)
     {
         if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
         {
             TranslateMessage(&msg);
             DispatchMessage(&msg);
+            continue;
         }
-        else
+
+        const RenderSnapshot* snap = AcquireSnapshot();
+        if (snap && g_backDC)
         {
-            UpdateGame();
-            Render(g_backDC);
+            Render(g_backDC, *snap);
 
             HDC hdc = GetDC(hwnd);
-            BitBlt(hdc, 0, 0, g_backW, g_backH, g_backDC, 0, 0, SRCCOPY);
+            BitBlt(hdc, 0, 0, g_viewW, g_viewH, g_backDC, 0, 0, SRCCOPY);
             ReleaseDC(hwnd, hdc);
-
-            Sleep(16); // ~60 FPS
+            RecordPresentLatency(*snap);
+            if (!presented) StartupMark("first frame");
+            presented = true;
         }
+
+        // Sleep until the next tick is published or a message arrives
+        MsgWaitForMultipleObjects(1, &g_frameReady, FALSE, INFINITE, QS_ALLINPUT);
     }
 
-    return 0;
-}
+    g_simQuit = true;
+    simThread.join();
+    CloseHandle(g_frameReady);
+    StopDeferredSubsystems(g_game);
+    StopRssSampler();
+
+    // /memory: the allocation counters as they ended, in memory.json
+    if (cmdLine && strstr(cmdLine, "/memory")) WriteMemoryJson("memory.json");
 
+    g_game.hooks.telemetry = nullptr;
+    if (recordTelemetry) WriteTelemetry(telemetry, "telemetry");
 
+    // /startup: how long the first frame took, and what came after
+    FILE* profile = NULL;
+    if (cmdLine && strstr(cmdLine, "/startup") && fopen_s(&profile, "startup.txt", "w") == 0 && profile)
+    {
+        WriteStartupProfile(profile);
+        fclose(profile);
+    }
+
+    return 0;
+}
+#endif // _WIN32
@@ -0,0 +1,58 @@
+// ============================================================
+// BreakBlocks vectorized environment - C API
+//
+// N independent games on the default 5x10 board, stepped together with one
+// call. Every output goes straight into caller-owned contiguous buffers:
+//   obs     float[N][BB_OBS_FLOATS]   paddle x, paddle w, then per ball slot
+//                                     x, y, vx, vy, alive (pixels, px/tick)
+//   bricks  uint8[N][BB_BRICK_BYTES]  row-major bitmap, bit (i & 7) of
+//                                     byte i / 8 set = brick i is standing
+//   rewards float[N]                  points / 100, minus 1 per life lost;
+//                                     catching an Add Life earns nothing
+//   dones   uint8[N]                  1 = game over; that env has already
+//                                     been reset and obs shows the new game
+// Actions are floats in [-1, 1]: paddle speed as a fraction of full speed.
+// Balls launch by themselves.
+//
+// Library build (no window, no main):
+//   g++ -std=c++14 -O2 -shared -fPIC -DBREAKBLOCKS_LIBRARY *.cpp -o libbreakblocks.so
+// ============================================================
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(BREAKBLOCKS_LIBRARY)
+#define BB_API __declspec(dllexport)
+#elif defined(BREAKBLOCKS_LIBRARY)
+#define BB_API __attribute__((visibility("default")))
+#else
+#define BB_API
+#endif
+
+#define BB_OBS_BALLS 6
+#define BB_OBS_FLOATS (2 + BB_OBS_BALLS * 5)
+#define BB_BRICK_BYTES 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct BBVecEnv BBVecEnv;
+
+BB_API BBVecEnv* bb_vec_create(int count);
+BB_API void bb_vec_destroy(BBVecEnv* env);
+BB_API int bb_vec_count(const BBVecEnv* env);
+
+// Sizes of one env's obs (floats) and bricks (bytes), for bindings
+BB_API void bb_vec_layout(int* obsFloats, int* brickBytes);
+
+// Starts every env over; seeds[i] fixes env i's game (NULL = 1..N)
+BB_API void bb_vec_reset(BBVecEnv* env, const uint32_t* seeds, float* obs, uint8_t* bricks);
+
+BB_API void bb_vec_step(BBVecEnv* env, const float* actions,
+                        float* obs, uint8_t* bricks, float* rewards, uint8_t* dones);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,433 @@
+#include "Tools.h"
+#include "Audio.h"
+#include "Particles.h"
+#include "Render.h"
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+#ifdef __linux__
+#include <signal.h>
+#endif
+
+// ============================================================
+// Frame Export
+// ============================================================
+
+// Renders a replay to video with no window. A replay is a seed: the
+// autoplayer's game from it is the same every run. Three stages overlap on
+// their own threads: this thread simulates and captures snapshots, a
+// rasterizer draws them with RasterizeSnapshot and converts to YUV, and an
+// encoder writes a YUV4MPEG2 stream to a .y4m file, to stdout ("-"), or
+// through an ffmpeg child process for any other file name. Frames go round
+// a ring of EXPORT_QUEUE slots, so a slow stage holds the others back
+// instead of letting frames pile up. The stream itself is opened by
+// RunExport.
+
+static const int EXPORT_QUEUE = 8;
+
+struct ExportFrame
+{
+    RenderSnapshot snap;
+    TaggedVector<uint8_t, MEM_EXPORT> yuv; // 4:2:0 planes, Y then U then V
+};
+
+struct ExportPipeline
+{
+    ExportFrame frames[EXPORT_QUEUE];
+    int w = SCREEN_W, h = SCREEN_H;
+    uint64_t count = 0;
+    std::mutex lock;
+    std::condition_variable moved;
+    uint64_t simulated = 0, rasterized = 0, encoded = 0; // frames through each stage
+    bool failed = false;
+};
+
+// Blocks until 'ready' holds or a stage has failed; false on failure
+template <typename Ready>
+bool WaitForStage(ExportPipeline& p, Ready ready)
+{
+    std::unique_lock<std::mutex> hold(p.lock);
+    p.moved.wait(hold, [&] { return p.failed || ready(); });
+    return !p.failed;
+}
+
+void FinishStage(ExportPipeline& p, uint64_t& cursor)
+{
+    {
+        std::lock_guard<std::mutex> hold(p.lock);
+        cursor++;
+    }
+    p.moved.notify_all();
+}
+
+// BT.601 full range ("C420jpeg"), chroma averaged over each 2x2 block.
+// w and h must be even. Frames are mostly flat color, so a block of one
+// color is converted once and reused while the color repeats.
+inline uint8_t LumaOf(uint32_t c)
+{
+    return (uint8_t)((77 * (int)(c >> 16 & 0xFF) + 150 * (int)(c >> 8 & 0xFF) + 29 * (int)(c & 0xFF) + 128) >> 8);
+}
+
+void PixelsToYUV420(const uint32_t* pixels, int w, int h, uint8_t* yuv)
+{
+    uint8_t* yp = yuv;
+    uint8_t* up = yuv + (size_t)w * h;
+    uint8_t* vp = up + (size_t)(w / 2) * (h / 2);
+    uint32_t flat = 0;
+    uint8_t flatY = 0, flatU = 128, flatV = 128;
+
+    for (int y = 0; y < h; y += 2)
+    {
+        const uint32_t* row0 = pixels + (size_t)y * w;
+        const uint32_t* row1 = row0 + w;
+        uint8_t* y0 = yp + (size_t)y * w;
+        uint8_t* y1 = y0 + w;
+        for (int x = 0; x < w; x += 2)
+        {
+            uint32_t a = row0[x], b = row0[x + 1], c = row1[x], d = row1[x + 1];
+            if (a == b && a == c && a == d)
+            {
+                if (a != flat)
+                {
+                    int r4 = (a >> 16 & 0xFF) * 4, g4 = (a >> 8 & 0xFF) * 4, b4 = (a & 0xFF) * 4;
+                    flat = a;
+                    flatY = LumaOf(a);
+                    flatU = (uint8_t)((-43 * r4 - 85 * g4 + 128 * b4 + (128 << 10) + 511) >> 10);
+                    flatV = (uint8_t)((128 * r4 - 107 * g4 - 21 * b4 + (128 << 10) + 511) >> 10);
+                }
+                y0[x] = y0[x + 1] = y1[x] = y1[x + 1] = flatY;
+                *up++ = flatU;
+                *vp++ = flatV;
+                continue;
+            }
+
+            y0[x] = LumaOf(a); y0[x + 1] = LumaOf(b);
+            y1[x] = LumaOf(c); y1[x + 1] = LumaOf(d);
+            int rs = (a >> 16 & 0xFF) + (b >> 16 & 0xFF) + (c >> 16 & 0xFF) + (d >> 16 & 0xFF);
+            int gs = (a >> 8 & 0xFF) + (b >> 8 & 0xFF) + (c >> 8 & 0xFF) + (d >> 8 & 0xFF);
+            int bs = (a & 0xFF) + (b & 0xFF) + (c & 0xFF) + (d & 0xFF);
+            *up++ = (uint8_t)((-43 * rs - 85 * gs + 128 * bs + (128 << 10) + 511) >> 10);
+            *vp++ = (uint8_t)((128 * rs - 107 * gs - 21 * bs + (128 << 10) + 511) >> 10);
+        }
+    }
+}
+
+void RasterizeStage(ExportPipeline* p, double* busy)
+{
+    TaggedVector<uint32_t, MEM_EXPORT> pixels((size_t)p->w * p->h);
+    for (uint64_t f = 0; f < p->count; ++f)
+    {
+        if (!WaitForStage(*p, [&] { return p->simulated > f; })) return;
+        double start = QpcSeconds();
+        ExportFrame& frame = p->frames[f % EXPORT_QUEUE];
+        RasterizeSnapshot(frame.snap, pixels.data(), p->w, p->h);
+        PixelsToYUV420(pixels.data(), p->w, p->h, frame.yuv.data());
+        *busy += QpcSeconds() - start;
+        FinishStage(*p, p->rasterized);
+    }
+}
+
+// Null 'out' throws the frames away (for timing the rest)
+void EncodeStage(ExportPipeline* p, FILE* out, double* busy)
+{
+    for (uint64_t f = 0; f < p->count; ++f)
+    {
+        if (!WaitForStage(*p, [&] { return p->rasterized > f; })) return;
+        double start = QpcSeconds();
+        const ExportFrame& frame = p->frames[f % EXPORT_QUEUE];
+        if (out && (fputs("FRAME\n", out) < 0 || fwrite(frame.yuv.data(), frame.yuv.size(), 1, out) != 1))
+        {
+            std::lock_guard<std::mutex> hold(p->lock);
+            p->failed = true;
+            p->moved.notify_all();
+            return;
+        }
+        *busy += QpcSeconds() - start;
+        FinishStage(*p, p->encoded);
+    }
+}
+
+// 'seconds' of the replay from 'seed' into 'out' (null: rendered, not written)
+ExportStats ExportReplay(uint32_t seed, double seconds, FILE* out)
+{
+    GameState g;
+    InitGameState(g, seed);
+
+    ParticlePool* particles = new ParticlePool;
+    g.hooks.particles = particles;
+
+    ExportPipeline* p = new ExportPipeline;
+    p->count = (uint64_t)(seconds * TICK_HZ);
+    for (int i = 0; i < EXPORT_QUEUE; ++i)
+        p->frames[i].yuv.resize((size_t)p->w * p->h * 3 / 2);
+    if (out) fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", p->w, p->h, TICK_HZ);
+
+    ExportStats stats;
+    const double start = QpcSeconds();
+    std::thread rasterizer(RasterizeStage, p, &stats.stageSeconds[1]);
+    std::thread encoder(EncodeStage, p, out, &stats.stageSeconds[2]);
+
+    for (uint64_t f = 0; f < p->count; ++f)
+    {
+        if (!WaitForStage(*p, [&] { return p->encoded + EXPORT_QUEUE > f; })) break;
+        double tickStart = QpcSeconds();
+        UpdateGame(g, AutoplayInput(g));
+        AdvanceParticles(g, *particles);
+        g_simTick++;
+        CaptureSnapshot(g, p->frames[f % EXPORT_QUEUE].snap);
+        stats.stageSeconds[0] += QpcSeconds() - tickStart;
+        FinishStage(*p, p->simulated);
+    }
+
+    rasterizer.join();
+    encoder.join();
+    stats.seconds = QpcSeconds() - start;
+    stats.frames = p->encoded;
+    stats.ok = !p->failed;
+
+    delete particles;
+    delete p;
+    return stats;
+}
+
+// ============================================================
+// Audio Capture (BreakBlocks.exe /audio [seconds])
+// ============================================================
+
+// The autoplayer plays 'seconds' of the default game and the mixer keeps
+// pace with it, AUDIO_RATE / TICK_HZ frames per tick, into a WAV file (or
+// nowhere without one, to time the mixer under a real game's load).
+int RunAudioCapture(const char* wavPath, double seconds)
+{
+    bool ownConsole = OpenConsole();
+    if (seconds <= 0.0) seconds = 30.0;
+
+    GameState g;
+    InitGameState(g, 1);
+
+    FILE* wav = NULL;
+    if (wavPath && !(wav = OpenWav(wavPath)))
+    {
+        printf("cannot write %s\n", wavPath);
+        CloseConsole(ownConsole);
+        return 1;
+    }
+
+    AudioMixer* mixer = new AudioMixer;
+    InitAudioMixer(*mixer);
+    g.hooks.audio = mixer;
+    static int16_t out[AUDIO_BLOCK * 2];
+
+    const uint64_t ticks = (uint64_t)(seconds * TICK_HZ);
+    double mixTime = 0.0;
+    for (uint64_t t = 1; t <= ticks; ++t)
+    {
+        UpdateGame(g, AutoplayInput(g));
+        double start = QpcSeconds();
+        while (mixer->frames < t * AUDIO_RATE / TICK_HZ)
+        {
+            MixAudio(*mixer, out);
+            if (wav) fwrite(out, sizeof(out), 1, wav);
+        }
+        mixTime += QpcSeconds() - start;
+    }
+
+    g.hooks.audio = nullptr;
+    if (wav) CloseWav(wav, mixer->frames);
+    printf("audio: %.1f s, %llu sounds, mixing %.1f us per tick (%.0fx real time)%s%s\n",
+        (double)mixer->frames / AUDIO_RATE, (unsigned long long)mixer->started, mixTime * 1e6 / ticks,
+        (double)mixer->frames / AUDIO_RATE / mixTime, wav ? ", written to " : "", wav ? wavPath : "");
+    delete mixer;
+
+    CloseConsole(ownConsole);
+    return 0;
+}
+
+// ============================================================
+// Video Export (BreakBlocks.exe /export [seconds])
+// ============================================================
+
+// Where the stream goes: a .y4m file, stdout ("-"), or anything else
+// through an ffmpeg child reading the stream on its stdin
+struct FrameSink
+{
+    FILE* f = NULL;
+#ifdef _WIN32
+    HANDLE process = NULL;
+#else
+    pid_t process = -1;
+#endif
+};
+
+// The encoder's arguments. The output goes through ffmpeg's file: protocol
+// so a name can't be taken for an option or another protocol.
+static const char* const FFMPEG_ARGS[] =
+{
+    "ffmpeg", "-loglevel", "error", "-y", "-f", "yuv4mpegpipe", "-i", "-", "-pix_fmt", "yuv420p",
+};
+static const int FFMPEG_ARG_COUNT = sizeof(FFMPEG_ARGS) / sizeof(FFMPEG_ARGS[0]);
+
+#ifdef _WIN32
+// Appends 'arg' to a command line so CommandLineToArgvW / the CRT give it
+// back unchanged: quoted, with quotes and the backslashes before them escaped
+void AppendCommandArg(std::string& cmd, const char* arg)
+{
+    if (!cmd.empty()) cmd += ' ';
+    cmd += '"';
+    for (const char* p = arg;; ++p)
+    {
+        size_t slashes = 0;
+        while (*p == '\\') { slashes++; p++; }
+        if (*p == 0) { cmd.append(slashes * 2, '\\'); break; }
+        if (*p == '"') cmd.append(slashes * 2 + 1, '\\');
+        else cmd.append(slashes, '\\');
+        cmd += *p;
+    }
+    cmd += '"';
+}
+#endif
+
+bool SpawnEncoder(FrameSink& sink, const char* path)
+{
+    std::string target = std::string("file:") + path;
+#ifdef _WIN32
+    std::string cmd;
+    for (int i = 0; i < FFMPEG_ARG_COUNT; ++i) AppendCommandArg(cmd, FFMPEG_ARGS[i]);
+    AppendCommandArg(cmd, target.c_str());
+
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), NULL, TRUE };
+    HANDLE readEnd = NULL, writeEnd = NULL;
+    if (!CreatePipe(&readEnd, &writeEnd, &sa, 0)) return false;
+    SetHandleInformation(writeEnd, HANDLE_FLAG_INHERIT, 0); // only the read end goes to ffmpeg
+
+    STARTUPINFOA si = {};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdInput = readEnd;
+    si.hStdOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    PROCESS_INFORMATION pi = {};
+    BOOL started = CreateProcessA(NULL, &cmd[0], NULL, NULL, TRUE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi);
+    CloseHandle(readEnd);
+    if (!started)
+    {
+        CloseHandle(writeEnd);
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    sink.process = pi.hProcess;
+    int fd = _open_osfhandle((intptr_t)writeEnd, _O_WRONLY | _O_BINARY);
+    sink.f = fd >= 0 ? _fdopen(fd, "wb") : NULL;
+#else
+    std::vector<char*> argv;
+    for (int i = 0; i < FFMPEG_ARG_COUNT; ++i) argv.push_back((char*)FFMPEG_ARGS[i]);
+    argv.push_back(&target[0]);
+    argv.push_back(NULL);
+
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[0], 0);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    posix_spawn_file_actions_addclose(&actions, fds[1]);
+    int err = posix_spawnp(&sink.process, "ffmpeg", &actions, NULL, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[0]);
+    if (err != 0)
+    {
+        close(fds[1]);
+        sink.process = -1;
+        return false;
+    }
+    sink.f = fdopen(fds[1], "w");
+#endif
+    return sink.f != NULL;
+}
+
+bool OpenFrameSink(FrameSink& sink, const char* path)
+{
+    if (strcmp(path, "-") == 0)
+    {
+#ifdef _WIN32
+        // Text mode would turn every LF in the frames into CRLF, and the GUI
+        // build's stdout is the console, which can't take video at all
+        if (_isatty(_fileno(stdout)) || _setmode(_fileno(stdout), _O_BINARY) == -1) return false;
+#endif
+        sink.f = stdout;
+        return true;
+    }
+
+    size_t len = strlen(path);
+    if (len > 4 && strcmp(path + len - 4, ".y4m") == 0)
+        return fopen_s(&sink.f, path, "wb") == 0 && sink.f;
+    return SpawnEncoder(sink, path);
+}
+
+// 0 once everything is written (and the encoder exited cleanly)
+int CloseFrameSink(FrameSink& sink)
+{
+    int result = 0;
+    if (sink.f == stdout) result = fflush(stdout);
+    else if (sink.f) result = fclose(sink.f);
+    sink.f = NULL;
+#ifdef _WIN32
+    if (sink.process)
+    {
+        DWORD code = 1;
+        WaitForSingleObject(sink.process, INFINITE);
+        GetExitCodeProcess(sink.process, &code);
+        CloseHandle(sink.process);
+        sink.process = NULL;
+        if (code != 0) result = 1;
+    }
+#else
+    if (sink.process > 0)
+    {
+        int status = 0;
+        while (waitpid(sink.process, &status, 0) < 0 && errno == EINTR) {}
+        sink.process = -1;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) result = 1;
+    }
+#endif
+    return result;
+}
+
+int RunExport(const char* path, double seconds, uint32_t seed)
+{
+    bool ownConsole = OpenConsole();
+    if (seconds <= 0.0) seconds = 30.0;
+
+#ifdef __linux__
+    signal(SIGPIPE, SIG_IGN); // a closed pipe fails the write instead of killing us
+#endif
+    FrameSink sink;
+    if (!OpenFrameSink(sink, path))
+    {
+        fprintf(stderr, "cannot write %s\n", path);
+        CloseFrameSink(sink);
+        CloseConsole(ownConsole);
+        return 1;
+    }
+
+    ExportStats stats = ExportReplay(seed, seconds, sink.f);
+    int closed = CloseFrameSink(sink);
+
+    // Progress goes to stderr so "-" can stream the video on stdout
+    double video = (double)stats.frames / TICK_HZ;
+    fprintf(stderr, "export: seed %u, %llu frames (%.1f s) in %.2f s, %.0fx real time\n", seed,
+        (unsigned long long)stats.frames, video, stats.seconds, video / stats.seconds);
+    fprintf(stderr, "  busy: simulate %.2f s, rasterize %.2f s, encode %.2f s\n",
+        stats.stageSeconds[0], stats.stageSeconds[1], stats.stageSeconds[2]);
+    bool ok = stats.ok && closed == 0;
+    if (!ok) fprintf(stderr, "export to %s failed\n", path);
+
+    CloseConsole(ownConsole);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,414 @@
+#include "Tools.h"
+
+// ============================================================
+// Fuzzing (breakblocks --fuzz [cases] [seed], or libFuzzer)
+// ============================================================
+
+// Each case is a byte string that builds a game (board shape, standing
+// bricks, balls in flight, power-ups) and then feeds it one input per tick,
+// the autoplayer taking over once the bytes run out. Every tick is run on
+// RuntimeBoard, on BruteForceBoard (the reference: no brick broadphase,
+// every cell tested) and, when the board is the default one, on the
+// StaticBoard instantiation, all from the same state. The results must
+// match bit for bit, pass CheckInvariants, and only change what the tick's
+// events explain (CheckTickEvents). The ball pairs FindBallPairs sweeps out
+// are checked against testing every pair.
+//
+// libFuzzer build (no main):
+//   clang++ -std=c++14 -g -O1 -fsanitize=fuzzer,address -DBREAKBLOCKS_FUZZER *.cpp -o breakblocks_fuzz
+
+static const int FUZZ_MAX_TICKS = 2000;
+
+// Reads the case bytes; past the end everything reads as 0.
+struct FuzzBytes
+{
+    const uint8_t* data;
+    size_t left;
+
+    bool Done() const { return left == 0; }
+    int Byte()
+    {
+        if (left == 0) return 0;
+        left--;
+        return *data++;
+    }
+    int Int(int n) { return n > 0 ? ((Byte() << 8) | Byte()) % n : 0; } // 0 .. n-1
+    float Unit() { return ((Byte() << 8) | Byte()) / 65535.f; }         // 0 .. 1
+    uint32_t U32() { return ((uint32_t)Int(65536) << 16) | (uint32_t)Int(65536); }
+};
+
+bool BallTouchesBrick(const GameState& g, const Ball& b)
+{
+    float ballY = b.y - g.brickOffsetY;
+    int c0, c1, r0, r1;
+    BrickCellsNear(g, b.x, ballY, b.r, c0, c1, r0, r1);
+    for (int r = r0; r <= r1; ++r)
+        for (int c = c0; c <= c1; ++c)
+            if (BrickHits(g, r, c) && CircleRectIntersect(b.x, ballY, b.r, BrickRect(g, r, c)))
+                return true;
+    return false;
+}
+
+// A game in 'g' from the case bytes. Bricks are thinned out and re-rolled,
+// the board may already have come down part of the way, and balls are
+// dropped anywhere above the paddle that is clear of bricks.
+void BuildFuzzGame(GameState& g, FuzzBytes& in)
+{
+    g = GameState();
+    SeedGameRand(g, in.U32());
+    int shape = in.Int(4);
+    if (shape == 0)
+    {
+        InitGame(g);
+        g.level = 1 + in.Int(g_levelCount);
+        InitBricksForLevel(g, g.level);
+    }
+    else
+        InitStressGame(g, 1 + in.Int(12), 1 + in.Int(24), 1 + in.Int(16));
+    g.ballCollisions = in.Int(2) != 0;
+
+    // Bricks: kill a share of them, re-roll the rest
+    int dead = in.Int(5); // out of 4; 4 clears the board
+    g.lowestLiveRow = -1;
+    for (int r = 0; r < g.boardRows; ++r)
+    {
+        g.rowLiveCount[r] = 0;
+        for (int c = 0; c < g.boardCols; ++c)
+        {
+            uint8_t& hits = BrickHits(g, r, c);
+            if (!hits) continue;
+            hits = (GameRand(g) % 4 < dead) ? 0 : (uint8_t)(1 + GameRand(g) % 5);
+            g.rowLiveCount[r] += hits > 0;
+        }
+        if (g.rowLiveCount[r]) g.lowestLiveRow = r;
+    }
+
+    g.paddle.x = in.Unit() * (g.worldW - g.paddle.w);
+    g.lives = 1 + in.Int(5);
+
+    // Descent already under way, stopping well short of the paddle
+    const LevelDef& lvl = CurrentLevelDef(g);
+    g.descendTimer = in.Int(lvl.descendIntervalFrames);
+    if (g.lowestLiveRow >= 0)
+    {
+        int room = (int)g.paddle.y - 4 * (int)BALL_RADIUS - BrickRect(g, g.lowestLiveRow, 0).bottom;
+        g.brickOffsetY = in.Int(room);
+    }
+
+    // Balls in flight, or the serve still on the paddle
+    if (shape != 0 || in.Int(4) != 0)
+    {
+        int count = 1 + in.Int(g.ballCap);
+        for (int i = 0; i < g.ballCap; ++i)
+        {
+            Ball& b = g.ball[i];
+            b = Ball();
+            if (i >= count) continue;
+
+            b.r = BALL_RADIUS;
+            b.alive = true;
+            for (int tries = 0; tries < 8; ++tries)
+            {
+                b.x = b.r + in.Unit() * (g.worldW - 2.f * b.r);
+                b.y = b.r + in.Unit() * (g.paddle.y - 2.f * b.r);
+                if (!BallTouchesBrick(g, b)) break;
+            }
+            if (BallTouchesBrick(g, b)) b.y = g.paddle.y - b.r - 1.f;
+
+            float angle = (in.Unit() * 2.f - 1.f) * 1.3f; // off vertical
+            float speed = MIN_BALL_SPEED + in.Unit() * (MAX_BALL_SPEED - MIN_BALL_SPEED);
+            b.vx = speed * sinf(angle);
+            b.vy = speed * cosf(angle) * ((in.Byte() & 1) ? 1.f : -1.f);
+            if (in.Byte() & 1) b.spin = in.Unit() * 2.f - 1.f;
+        }
+        g.ballMax = count;
+        g.ballLaunched = true;
+    }
+
+    // Power-ups already running (with timers part-way down) and falling
+    for (int n = in.Int(6); n > 0; --n)
+        ApplyPowerUp(g, in.Int(g_powerUpCount));
+    for (int i = 0; i < MAX_ACTIVE_POWERUPS; ++i)
+        if (g.activePowerUps[i].timer > 0)
+            g.activePowerUps[i].timer = 1 + in.Int(g.activePowerUps[i].timer);
+    for (int n = in.Int(5); n > 0; --n)
+        SpawnPowerUp(g, in.Unit() * g.worldW, in.Unit() * g.paddle.y, in.Int(g_powerUpCount));
+}
+
+TickInput FuzzInput(FuzzBytes& in)
+{
+    int b = in.Byte();
+    TickInput tick;
+    tick.paddleMove = ((b & 15) - 7.5f) * 4.f; // keys or a mouse flick
+    tick.launch = (b & 16) != 0;
+    tick.restart = (b & 32) != 0;
+    return tick;
+}
+
+// First field where two states differ, or NULL. Floats are compared
+// exactly: every variant has to do the same arithmetic in the same order.
+const char* DiffGameState(const GameState& a, const GameState& b)
+{
+    if (a.paddle.x != b.paddle.x || a.paddle.y != b.paddle.y || a.paddle.w != b.paddle.w ||
+        a.paddle.h != b.paddle.h || a.paddleVX != b.paddleVX || a.paddlePrevX != b.paddlePrevX)
+        return "paddle";
+
+    if (a.ballMax != b.ballMax || a.ballLaunched != b.ballLaunched) return "ball count";
+    for (int i = 0; i < a.ballCap; ++i)
+    {
+        const Ball& p = a.ball[i];
+        const Ball& q = b.ball[i];
+        if (p.alive != q.alive || p.stuck != q.stuck) return "ball alive/stuck";
+        if (p.x != q.x || p.y != q.y || p.prevX != q.prevX || p.prevY != q.prevY) return "ball position";
+        if (p.vx != q.vx || p.vy != q.vy || p.spin != q.spin) return "ball velocity";
+        if (p.r != q.r || p.penetrateMax != q.penetrateMax || p.penetrateCount != q.penetrateCount)
+            return "ball radius/penetration";
+    }
+
+    if (a.boardEpoch != b.boardEpoch) return "board epoch";
+    if (a.boardTilesX != b.boardTilesX || a.brickHits != b.brickHits) return "brick";
+    if (a.brickOffsetY != b.brickOffsetY || a.descendTimer != b.descendTimer) return "descent";
+    if (a.rowLiveCount != b.rowLiveCount || a.lowestLiveRow != b.lowestLiveRow) return "row counts";
+
+    if (a.score != b.score) return "score";
+    if (a.lives != b.lives || a.level != b.level || a.gameOver != b.gameOver ||
+        a.levelAdvancePending != b.levelAdvancePending)
+        return "lives/level";
+    if (a.rngState != b.rngState) return "rng";
+    if (a.spin != b.spin || a.stickyPaddle != b.stickyPaddle || a.invulnerable != b.invulnerable)
+        return "power-up flags";
+    if (a.ballCollisions != b.ballCollisions) return "ball collisions";
+
+    for (int i = 0; i < MAX_ACTIVE_POWERUPS; ++i)
+        if (a.activePowerUps[i].def != b.activePowerUps[i].def ||
+            a.activePowerUps[i].timer != b.activePowerUps[i].timer)
+            return "active power-up";
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+    {
+        const FallingPowerUp& p = a.fallingPowerUps[i];
+        const FallingPowerUp& q = b.fallingPowerUps[i];
+        if (p.alive != q.alive || p.index != q.index || p.x != q.x || p.y != q.y)
+            return "falling power-up";
+    }
+    return NULL;
+}
+
+// Whether FindBallPairs finds exactly the overlapping pairs of balls in
+// flight that testing every pair does
+bool BallPairsMatch(GameState& g)
+{
+    FindBallPairs(g);
+    std::vector<std::pair<int, int>> swept, all;
+    for (const std::pair<int, int>& p : g.scratch.ballPairs)
+        swept.push_back(std::make_pair(min(p.first, p.second), max(p.first, p.second)));
+    std::sort(swept.begin(), swept.end());
+
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        const Ball& a = g.ball[i];
+        if (!a.alive || a.stuck) continue;
+        for (int j = i + 1; j < g.ballCap; ++j)
+        {
+            const Ball& b = g.ball[j];
+            if (!b.alive || b.stuck) continue;
+            float dx = b.x - a.x, dy = b.y - a.y, rr = a.r + b.r;
+            if (dx * dx + dy * dy < rr * rr) all.push_back(std::make_pair(i, j));
+        }
+    }
+    return swept == all;
+}
+
+// Changes a tick may only make together with the event behind them: score
+// and bricks with a logged brick hit, the board moving with descent, a new
+// board with a cleared level, lives with a lost ball or a caught Add Life.
+// 'before' is where the tick started, 'hits' its brick log and 'g' where it
+// ended. Not meaningful across a restart.
+int CheckTickEvents(const GameState& g, const GameState& before, const BrickLog& hits, const char** what)
+{
+    int broken = 0;
+    auto fail = [&](const char* msg)
+    {
+        if (broken++ == 0 && what) *what = msg;
+    };
+
+    int points = g.score - before.score;
+    int n = (int)hits.size();
+    if (points < 25 * n || points > 100 * n) fail("score change doesn't match the bricks hit");
+
+    const int cells = before.boardRows * before.boardCols;
+    std::vector<char> hit(cells, 0);
+    for (int i = 0; i < n; ++i) hit[hits[i]] = 1;
+
+    if (g.boardEpoch == before.boardEpoch)
+    {
+        for (int i = 0; i < cells; ++i)
+        {
+            size_t slot = BrickSlot(i / g.boardCols, i % g.boardCols, before.boardTilesX);
+            uint8_t was = before.brickHits[slot], now = g.brickHits[slot];
+            if (now == was) continue;
+            if (!hit[i]) fail("brick changed without being hit");
+            if (now > was) fail("brick gained hits");
+        }
+        int drop = g.brickOffsetY - before.brickOffsetY;
+        if (drop != 0 && drop != CurrentLevelDef(g).descendAmount) fail("board moved without descending");
+    }
+    else
+    {
+        if (g.level != before.level + 1) fail("new board without a level advance");
+        for (int i = 0; i < cells; ++i)
+            if (before.brickHits[BrickSlot(i / g.boardCols, i % g.boardCols, before.boardTilesX)] && !hit[i])
+                fail("level advanced with bricks standing");
+    }
+
+    if (g.lives < before.lives && (g.lives != before.lives - 1 || g.ballLaunched))
+        fail("life lost with a ball in play");
+    if (g.lives > before.lives)
+    {
+        int caught = 0;
+        for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+        {
+            const FallingPowerUp& was = before.fallingPowerUps[i];
+            const FallingPowerUp& now = g.fallingPowerUps[i];
+            bool stillFalling = now.alive && now.index == was.index && now.x == was.x;
+            if (was.alive && HasEffect(g_powerUps[was.index], EFFECT_LIVES) && !stillFalling)
+                caught++;
+        }
+        if (g.lives - before.lives > caught) fail("life gained without an Add Life");
+    }
+
+    if (g.gameOver && !before.gameOver && g.lives > 0)
+    {
+        bool reached = g.lowestLiveRow >= 0 &&
+            BrickRect(g, g.lowestLiveRow, 0).bottom + g.brickOffsetY >= (int)g.paddle.y;
+        if (!reached) fail("game over with lives left");
+    }
+    return broken;
+}
+
+// Builds a game from 'data' and plays it out, checking every tick. Returns
+// the tick that failed with 'what' describing it, or 0 if none did.
+int RunFuzzCase(const uint8_t* data, size_t size, const char** what)
+{
+    static char message[128];
+    FuzzBytes in = { data, size };
+    GameState g; // the reference run
+    BuildFuzzGame(g, in);
+
+    // The bounce table against the formula it replaces
+    for (int i = 0; i < 4; ++i)
+    {
+        float hit = in.Unit() * 2.f - 1.f;
+        float vx = in.Unit() * 8.f - 4.f, vy = MIN_BALL_SPEED + in.Unit() * 8.f;
+        float rx = vx, ry = vy;
+        PaddleBounce(hit, vx, vy);
+        PaddleBounceReference(hit, rx, ry);
+        if (fabsf(atan2f(vx, -vy) - atan2f(rx, -ry)) > 1e-4f ||
+            fabsf(sqrtf(vx * vx + vy * vy) - sqrtf(rx * rx + ry * ry)) > 1e-4f * sqrtf(rx * rx + ry * ry))
+        {
+            *what = "paddle bounce table disagrees with the reference";
+            return 1;
+        }
+    }
+
+    const int ticks = 1 + in.Int(FUZZ_MAX_TICKS);
+    BrickLog hits;
+    g.hooks.brickLog = &hits;
+    GameState start, fixed, brute;
+
+    for (int t = 1; t <= ticks; ++t)
+    {
+        TickInput tick = in.Done() ? AutoplayInput(g) : FuzzInput(in);
+        const bool defaultBoard = DefaultBoard::Matches(g);
+        start = g;
+
+        if (defaultBoard)
+        {
+            fixed = g;
+            UpdateGameOn<DefaultBoard>(fixed, tick);
+        }
+        brute = g;
+        UpdateGameOn<BruteForceBoard>(brute, tick);
+
+        hits.clear();
+        UpdateGameOn<RuntimeBoard>(g, tick);
+
+        const char* field = DiffGameState(brute, g);
+        if (field)
+        {
+            sprintf_s(message, sizeof(message), "RuntimeBoard path differs from the brute-force reference in %s", field);
+            *what = message;
+            return t;
+        }
+        field = defaultBoard ? DiffGameState(brute, fixed) : NULL;
+        if (field)
+        {
+            sprintf_s(message, sizeof(message), "StaticBoard path differs from the brute-force reference in %s", field);
+            *what = message;
+            return t;
+        }
+        if (!BallPairsMatch(brute))
+        {
+            *what = "ball pair sweep disagrees with testing every pair";
+            return t;
+        }
+
+        if (CheckInvariants(g, what)) return t;
+        if (!(start.gameOver && tick.restart) && CheckTickEvents(g, start, hits, what)) return t;
+    }
+    return 0;
+}
+
+#ifdef BREAKBLOCKS_FUZZER
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    const char* what = NULL;
+    int tick = RunFuzzCase(data, size, &what);
+    if (tick)
+    {
+        fprintf(stderr, "tick %d: %s\n", tick, what);
+        abort();
+    }
+    return 0;
+}
+#endif
+
+// 'cases' random byte strings; case i is generated from seed + i, so a
+// failure reproduces alone with --fuzz 1 <its seed>.
+int RunFuzzer(int cases, uint32_t seed)
+{
+    bool ownConsole = OpenConsole();
+    if (cases <= 0) cases = 1000;
+    printf("fuzz: %d cases from seed %u\n", cases, seed);
+
+    std::vector<uint8_t> bytes;
+    int failures = 0;
+    const double start = QpcSeconds();
+
+    for (int i = 0; i < cases; ++i)
+    {
+        uint32_t caseSeed = seed + (uint32_t)i;
+        uint32_t x = caseSeed ? caseSeed : 1;
+        auto next = [&]()
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            return x;
+        };
+        bytes.resize(64 + next() % 4096);
+        for (size_t j = 0; j < bytes.size(); ++j)
+            bytes[j] = (uint8_t)(next() >> 24);
+
+        const char* what = NULL;
+        int tick = RunFuzzCase(bytes.data(), bytes.size(), &what);
+        if (tick)
+        {
+            printf("  case %d (seed %u), tick %d: %s\n", i, caseSeed, tick, what);
+            if (++failures == 20) break;
+        }
+    }
+
+    printf("%d failures in %.1f s\n", failures, QpcSeconds() - start);
+    CloseConsole(ownConsole);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,1833 @@
+#include "Game.h"
+#include "Audio.h"
+#include "Particles.h"
+#include "Telemetry.h"
+
+// ============================================================
+// Math / Utility Functions
+// ============================================================
+
+float Clamp(float v, float min, float max)
+{
+    if (v < min) return min;
+    if (v > max) return max;
+    return v;
+}
+
+bool CircleRectIntersect(float cx, float cy, float r, const RECT& rc)
+{
+    float closestX = Clamp(cx, (float)rc.left, (float)rc.right);
+    float closestY = Clamp(cy, (float)rc.top, (float)rc.bottom);
+    float dx = cx - closestX;
+    float dy = cy - closestY;
+    return (dx * dx + dy * dy) <= (r * r);
+}
+
+double QpcSeconds()
+{
+#ifdef _WIN32
+    static const double secondsPerCount = []
+    {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        return 1.0 / (double)freq.QuadPart;
+    }();
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart * secondsPerCount;
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
+
+COLORREF GetBrickColor(int hits)
+{
+    switch (hits)
+    {
+    case 1: return RGB(200, 200, 200); // light gray
+    case 2: return RGB(0, 200, 255);   // cyan
+    case 3: return RGB(0, 180, 0);     // green
+    case 4: return RGB(255, 180, 0);   // orange
+    case 5: return RGB(255, 0, 0);     // red
+    default: return RGB(255, 255, 255);
+    }
+}
+
+// ============================================================
+// Paddle Bounce
+// ============================================================
+
+// Hit position (-1 .. 1) to bounce direction. The dead-zone/quadratic curve
+// is cheap; the trig is what costs, so sin/cos of the final angle come from a
+// small table over angleFactor (-1 .. 1) with linear interpolation. At 64
+// intervals the direction error is on the order of 1e-6 rad (see /bench).
+// Everything here is plain IEEE arithmetic and sqrtf (correctly rounded),
+// and the table is baked rather than taken from the CRT's sinf/cosf, so a
+// bounce comes out the same bits on every CPU and compiler: seeds, replays
+// and golden traces depend on it.
+static const float BOUNCE_DEAD_ZONE = 0.2f;
+static const float BOUNCE_MAX_ANGLE = 70.f * 3.14159f / 180.f;
+static const int BOUNCE_TABLE_SIZE = 64;
+
+// One interval per entry: value at its start plus slope, so a lookup is a
+// single 16-byte load and two multiply-adds.
+struct BounceSample
+{
+    float s, c, ds, dc;
+};
+
+// sinf/cosf of (-1 + 2 i / BOUNCE_TABLE_SIZE) * BOUNCE_MAX_ANGLE, the
+// interval ends, each the nearest float to the true value
+static const float BOUNCE_SIN[BOUNCE_TABLE_SIZE + 1] =
+{
+    -0.939692318f, -0.925952673f, -0.910863459f, -0.894446731f, -0.876726389f, -0.857728183f,
+    -0.837479949f, -0.816011071f, -0.793352902f, -0.769538462f, -0.744602442f, -0.7185812f,
+    -0.691512585f, -0.663436174f, -0.634392858f, -0.604424894f, -0.573576033f, -0.541891217f,
+    -0.50941658f, -0.476199478f, -0.442288369f, -0.407732636f, -0.372582614f, -0.336889595f,
+    -0.300705582f, -0.264083296f, -0.227076083f, -0.189737946f, -0.152123272f, -0.114286877f,
+    -0.0762839168f, -0.0381697714f, 0.f, 0.0381697714f, 0.0762839168f, 0.114286877f,
+    0.152123272f, 0.189737946f, 0.227076083f, 0.264083296f, 0.300705582f, 0.336889595f,
+    0.372582614f, 0.407732636f, 0.442288369f, 0.476199478f, 0.50941658f, 0.541891217f,
+    0.573576033f, 0.604424894f, 0.634392858f, 0.663436174f, 0.691512585f, 0.7185812f,
+    0.744602442f, 0.769538462f, 0.793352902f, 0.816011071f, 0.837479949f, 0.857728183f,
+    0.876726389f, 0.894446731f, 0.910863459f, 0.925952673f, 0.939692318f,
+};
+static const float BOUNCE_COS[BOUNCE_TABLE_SIZE + 1] =
+{
+    0.342021048f, 0.377639651f, 0.412707835f, 0.447174519f, 0.480989486f, 0.514103413f,
+    0.546468079f, 0.578036308f, 0.608762026f, 0.638600469f, 0.667508185f, 0.695443094f,
+    0.722364426f, 0.748232841f, 0.77301079f, 0.796662092f, 0.819152296f, 0.840448618f,
+    0.860520065f, 0.879337251f, 0.896872878f, 0.913101375f, 0.92799902f, 0.941544175f,
+    0.953716993f, 0.964499891f, 0.973877013f, 0.981834769f, 0.988361537f, 0.993447781f,
+    0.997086108f, 0.999271274f, 1.f, 0.999271274f, 0.997086108f, 0.993447781f,
+    0.988361537f, 0.981834769f, 0.973877013f, 0.964499891f, 0.953716993f, 0.941544175f,
+    0.92799902f, 0.913101375f, 0.896872878f, 0.879337251f, 0.860520065f, 0.840448618f,
+    0.819152296f, 0.796662092f, 0.77301079f, 0.748232841f, 0.722364426f, 0.695443094f,
+    0.667508185f, 0.638600469f, 0.608762026f, 0.578036308f, 0.546468079f, 0.514103413f,
+    0.480989486f, 0.447174519f, 0.412707835f, 0.377639651f, 0.342021048f,
+};
+
+static BounceSample g_bounceTable[BOUNCE_TABLE_SIZE];
+static bool g_bounceTableReady = false;
+
+void InitPaddleBounceTable()
+{
+    if (g_bounceTableReady) return;
+    for (int i = 0; i < BOUNCE_TABLE_SIZE; ++i)
+    {
+        BounceSample& e = g_bounceTable[i];
+        e.s = BOUNCE_SIN[i];
+        e.c = BOUNCE_COS[i];
+        e.ds = BOUNCE_SIN[i + 1] - e.s;
+        e.dc = BOUNCE_COS[i + 1] - e.c;
+    }
+    g_bounceTableReady = true;
+}
+
+// Written as selects rather than branches: contact positions are effectively
+// random, so branches here mispredict more often than not.
+float BounceAngleFactor(float hit)
+{
+    float mag = fabsf(hit);
+    mag = (mag > 1.f) ? 1.f : mag;
+    float t = (mag - BOUNCE_DEAD_ZONE) * (1.f / (1.f - BOUNCE_DEAD_ZONE));
+    float curve = (mag < BOUNCE_DEAD_ZONE) ? mag * 0.25f : t * t;
+    return copysignf(curve, hit);
+}
+
+// New velocity for a ball leaving the paddle at hit position 'hit',
+// keeping its speed.
+void PaddleBounce(float hit, float& vx, float& vy)
+{
+    float x = (BounceAngleFactor(hit) + 1.f) * (0.5f * BOUNCE_TABLE_SIZE);
+    int i = (int)x;
+    if (i > BOUNCE_TABLE_SIZE - 1) i = BOUNCE_TABLE_SIZE - 1;
+    float f = x - (float)i;
+
+    const BounceSample& e = g_bounceTable[i];
+    float s = e.s + e.ds * f;
+    float c = e.c + e.dc * f;
+
+    // Interpolated (s, c) falls slightly inside the unit circle (|1 - n| is
+    // below 4e-4), so one Newton step from 1 renormalizes it to ~1e-7. Kept
+    // off the speed's dependency chain so the two overlap.
+    float speed = sqrtf(vx * vx + vy * vy);
+    float scale = speed * (1.5f - 0.5f * (s * s + c * c));
+
+    vx = s * scale;
+    vy = -c * scale;
+}
+
+// The direct formula the table replaces; kept for the accuracy check.
+void PaddleBounceReference(float hit, float& vx, float& vy)
+{
+    float speed = sqrtf(vx * vx + vy * vy);
+    float angle = BounceAngleFactor(hit) * BOUNCE_MAX_ANGLE;
+    vx = sinf(angle) * speed;
+    vy = -cosf(angle) * speed;
+}
+
+// ============================================================
+// Game State
+// ============================================================
+
+void SeedGameRand(GameState& g, uint32_t seed)
+{
+    g.rngState = seed ? seed : 2463534242u; // xorshift never leaves 0
+}
+
+int GameRand(GameState& g)
+{
+    uint32_t x = g.rngState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    g.rngState = x;
+    return (int)(x >> 1);
+}
+
+int RollBrickHits(GameState& g, int level)
+{
+    int base = 1 + level / 2;
+    if (base < 1) base = 1;
+    if (base > 4) base = 4;
+
+    int roll = GameRand(g) % 100;
+    if (roll < 50) return base;
+    else if (roll < 80) return base + 1;
+    else return base + 2;
+}
+
+// ============================================================
+// Board Configuration
+// ============================================================
+
+void ConfigureBoard(GameState& g, int rows, int cols, int ballCap)
+{
+    g.boardRows = rows;
+    g.boardCols = cols;
+    g.ballCap = ballCap;
+    g.boardTilesX = BoardTiles(cols);
+    g.brickHits.assign((size_t)g.boardTilesX * BoardTiles(rows) * BRICK_TILE * BRICK_TILE, 0);
+    g.ball.assign(ballCap, Ball());
+    g.rowLiveCount.assign(rows, 0);
+}
+
+// ============================================================
+// Initialization
+// ============================================================
+
+void InitPaddle(GameState& g)
+{
+    g.paddle.w = PADDLE_W;
+    g.paddle.h = PADDLE_H;
+    g.paddle.x = (g.worldW - g.paddle.w) * 0.5f;
+    g.paddle.y = g.worldH - 40.f;
+}
+
+void InitBall(GameState& g)
+{
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        g.ball[i].r = BALL_RADIUS;
+        g.ball[i].vx = (i == 0) ? BALL_SPEED : 0.f;  // only first ball moving
+        g.ball[i].vy = (i == 0) ? -BALL_SPEED : 0.f;
+        g.ball[i].penetrateMax = 0;
+        g.ball[i].penetrateCount = 0;
+        g.ball[i].x = g.paddle.x + g.paddle.w * 0.5f;
+        g.ball[i].y = g.paddle.y - g.ball[i].r - 1.f;
+        g.ball[i].alive = (i == 0);  // only the first g.ball is alive
+        g.ball[i].stuck = false;
+		g.ball[i].spin = 0.f;
+    }
+    g.ballMax = 1;
+    g.ballLaunched = false;
+}
+
+void KillAllBalls(GameState& g)
+{
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        g.ball[i].alive = false;
+        g.ball[i].spin = 0.f;
+    }
+    g.ballMax = 1;
+
+    g.ballLaunched = false;
+}
+
+int FindActiveBall(const GameState& g){
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        if (g.ball[i].alive)
+            return i;
+    }
+    return -1;
+}
+
+void SetActiveBallCount(GameState& g)
+{
+	int src = FindActiveBall(g);
+    if (src == -1) { return; } // no active ball to clone from
+
+	int count = 0;// only add balls up to g.ballMax
+
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        if (count < g.ballMax)
+        {
+            if (!g.ball[i].alive)
+            {
+                // Spawn this ball by cloning ball 0
+                g.ball[i] = g.ball[src];
+                g.ball[i].vx = (i & 1) ? g.ball[i].vx : -g.ball[i].vx;
+                g.ball[i].alive = true;
+				g.ball[i].stuck = false;
+                if (g.hooks.telemetry) TelemetryBallAdded(g, i);
+            }
+			count++;
+        }
+        else
+        {
+            if (g.hooks.telemetry && g.ball[i].alive) TelemetryBallLost(g, i);
+            g.ball[i].alive = false;
+        }
+    }
+}
+
+// Example Level (you can expand for more levels)
+static constexpr LevelDef g_levels[] =
+{
+    // Level 1
+    {
+        5, 10,
+        {
+            {1,1,1,1,1,1,1,1,1,1},
+            {0,1,2,2,2,2,2,2,1,0},
+            {0,0,1,3,3,3,3,1,0,0},
+            {0,0,0,1,4,4,1,0,0,0},
+            {0,0,0,0,5,5,0,0,0,0}
+        },
+        {// defined power-ups in specific bricks
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 
+            {-1, 0, 0, 0, 0, 0, 0, 0, 0,-1},
+            {-1,-1, 6 -1,-1,-1,-1, 6,-1,-1},
+            {-1,-1,-1,11, 0, 0,11,-1,-1,-1},
+            {-1,-1,-1,-1, 0, 0,-1,-1,-1,-1}
+        },
+        0,0
+    },
+
+    // Level 2 - descent pressure
+    {
+        5, 10,
+        {
+            {2,2,2,2,2,2,2,2,2,2},
+            {1,3,1,3,1,1,3,1,3,1},
+            {1,1,2,2,1,1,2,2,1,1},
+            {0,1,1,1,3,3,1,1,1,0},
+            {1,0,1,0,1,1,0,1,0,1}
+        },
+        {
+            {-1, 0, 0, 0, 0, 0, 0, 0, 0,-1},
+            { 0,-1, 0,-1, 0, 0,-1, 0,-1, 0},
+            { 0, 0,12, 0, 0, 0, 0,12, 0, 0},
+            {-1, 0, 0, 0, 9, 9, 0, 0, 0,-1},
+            { 0,-1, 0,-1, 0, 0,-1, 0,-1, 0}
+        },
+        480, 12 // every 8 s, 12 px
+    },
+};
+
+// Convenience
+static constexpr int LEVEL_COUNT = sizeof(g_levels) / sizeof(g_levels[0]);
+const int g_levelCount = LEVEL_COUNT;
+
+// A level's bricks as LayoutBoard leaves nothing else to compute: the live
+// cells of its pattern in row-major order with their base hits. Brick rects
+// follow from the board origin, so the random roll on top of the base hits
+// is all that is left per level start. Baked at compile time from g_levels.
+struct BakedCell
+{
+    uint8_t row, col, baseHits;
+};
+
+struct BakedLevel
+{
+    BakedCell cells[BRICK_ROWS * BRICK_COLS];
+    int count;
+};
+
+struct BakedLevels
+{
+    BakedLevel level[LEVEL_COUNT];
+};
+
+static constexpr BakedLevels BakeLevels()
+{
+    BakedLevels baked = {};
+    for (int l = 0; l < LEVEL_COUNT; ++l)
+    {
+        const LevelDef& lvl = g_levels[l];
+        BakedLevel& out = baked.level[l];
+        for (int r = 0; r < lvl.rows; ++r)
+            for (int c = 0; c < lvl.cols; ++c)
+                if (lvl.brickPattern[r][c])
+                {
+                    BakedCell& cell = out.cells[out.count++];
+                    cell.row = (uint8_t)r;
+                    cell.col = (uint8_t)c;
+                    cell.baseHits = (uint8_t)lvl.brickPattern[r][c];
+                }
+    }
+    return baked;
+}
+
+static constexpr BakedLevels g_bakedLevels = BakeLevels();
+
+const LevelDef& CurrentLevelDef(const GameState& g)
+{
+    int lvlIndex = g.level - 1;
+    if (lvlIndex < 0) lvlIndex = 0;
+    if (lvlIndex >= g_levelCount) lvlIndex = g_levelCount - 1;
+    return g_levels[lvlIndex];
+}
+
+// ------------------------------------------------------------
+// InitBricks using LevelDef
+// ------------------------------------------------------------
+// Lays the board out on a uniform grid centered in the world (so a brick's
+// cell can be computed from a position) and resets per-level board state.
+// Bricks are stored row-major; every cell starts dead.
+void LayoutBoard(GameState& g)
+{
+    g.boardEpoch++;
+    g.brickOffsetY = 0;
+    g.descendTimer = 0;
+    g.lowestLiveRow = -1;
+    for (int r = 0; r < g.boardRows; ++r)
+        g.rowLiveCount[r] = 0;
+
+    int totalW = g.boardCols * BRICK_W + (g.boardCols - 1) * BRICK_GAP;
+    g.boardOriginX = (g.worldW - totalW) / 2;
+    g.boardOriginY = 40;
+
+    std::fill(g.brickHits.begin(), g.brickHits.end(), (uint8_t)0);
+}
+
+void InitBricksForLevel(GameState& g, int level)
+{
+    if (level < 1 || level > g_levelCount) level = g_levelCount; // clamp to last level
+    const BakedLevel& baked = g_bakedLevels.level[level - 1];
+
+    LayoutBoard(g);
+
+    // Cells outside the level pattern stay dead, as do pattern cells off a
+    // smaller board. Must-drop power-ups are looked up in the LevelDef when
+    // the brick dies.
+    for (int i = 0; i < baked.count; ++i)
+    {
+        const BakedCell& cell = baked.cells[i];
+        if (cell.row >= g.boardRows || cell.col >= g.boardCols) continue;
+
+        // Add some randomness on top of base hits
+        int hits = cell.baseHits + (GameRand(g) % 2); // +0 or +1
+        BrickHits(g, cell.row, cell.col) = (uint8_t)Clamp(hits, 1, 5);
+
+        g.rowLiveCount[cell.row]++;
+        g.lowestLiveRow = cell.row;
+    }
+}
+
+// Keeps the per-row live counts in sync; call once per brick that dies.
+// The lowest live row only ever moves up, so the walk is amortized O(rows)
+// per level.
+void OnBrickDestroyed(GameState& g, int index)
+{
+    int row = index / g.boardCols;
+    g.rowLiveCount[row]--;
+    while (g.lowestLiveRow >= 0 && g.rowLiveCount[g.lowestLiveRow] == 0)
+        g.lowestLiveRow--;
+}
+
+void InitGame(GameState& g)
+{
+    if (g.ball.empty())
+        ConfigureBoard(g, BRICK_ROWS, BRICK_COLS, BALL_CAP);
+    InitPaddleBounceTable();
+    ResetPowerUps(g);
+
+    g.score = 0;
+    g.lives = 3;
+    g.level = 1;
+    g.gameOver = false;
+    g.levelAdvancePending = false;
+    InitPaddle(g);
+    InitBall(g);
+    InitBricksForLevel(g, g.level);
+}
+
+// Stress session: a rows x cols board with every cell live, and 'balls'
+// balls already in flight below it. The world is widened and deepened to
+// fit, so only use this headless.
+void InitStressGame(GameState& g, int rows, int cols, int balls)
+{
+    ConfigureBoard(g, rows, cols, balls);
+    InitPaddleBounceTable();
+    ResetPowerUps(g);
+
+    int boardW = cols * (BRICK_W + BRICK_GAP) + BRICK_GAP;
+    int boardH = rows * (BRICK_H + BRICK_GAP);
+    g.worldW = max(SCREEN_W, boardW + 80);
+    g.worldH = 40 + boardH + SCREEN_H;
+
+    g.score = 0;
+    g.lives = 3;
+    g.level = 1;
+    g.gameOver = false;
+    g.levelAdvancePending = false;
+    InitPaddle(g);
+
+    LayoutBoard(g);
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < cols; ++c)
+            BrickHits(g, r, c) = (uint8_t)(1 + GameRand(g) % 5);
+        g.rowLiveCount[r] = cols;
+    }
+    g.lowestLiveRow = rows - 1;
+
+    float fieldTop = (float)(40 + boardH + BALL_RADIUS * 2);
+    for (int i = 0; i < balls; ++i)
+    {
+        Ball& b = g.ball[i];
+        b = Ball();
+        b.r = BALL_RADIUS;
+        b.x = BALL_RADIUS + (float)(GameRand(g) % (g.worldW - 2 * (int)BALL_RADIUS));
+        b.y = fieldTop + (float)(GameRand(g) % (SCREEN_H / 2));
+        b.vx = (GameRand(g) & 1) ? BALL_SPEED : -BALL_SPEED;
+        b.vy = -BALL_SPEED;
+        b.alive = true;
+    }
+    g.ballMax = balls;
+    g.ballLaunched = true;
+}
+
+// A fresh default game in 'g' from 'seed'. Its hooks and scratch buffers
+// stay, and so does the capacity of its storage: copying a blank game in
+// (rather than moving one) reuses the buffers, so resetting never frees
+// what the next game allocates again.
+void InitGameState(GameState& g, uint32_t seed)
+{
+    static const GameState blank;
+    g = blank;
+    SeedGameRand(g, seed);
+    InitGame(g);
+}
+
+// ============================================================
+// PowerUp / Effect Logic
+// ============================================================
+
+static const float EFFECT_KEEP = -1.f;   // 'undo': the change stays after expiry
+static const float EFFECT_REVERT = -2.f; // 'undo': the inverse operation
+
+// A ball that grows next to a wall would stick into it until the next tick
+// (reverts can grow one too, when Big/Small overlapped)
+void KeepBallInWalls(const GameState& g, Ball& b)
+{
+    b.x = Clamp(b.x, b.r, g.worldW - b.r);
+    if (b.y < b.r) b.y = b.r;
+}
+
+// Speed effects scale whatever speed a ball has, and reverts also hit balls
+// respawned since; keep the result playable
+void LimitBallSpeed(Ball& b)
+{
+    float speed = sqrtf(b.vx * b.vx + b.vy * b.vy);
+    float limited = Clamp(speed, MIN_BALL_SPEED, MAX_BALL_SPEED);
+    if (speed > 0.f && limited != speed)
+    {
+        b.vx *= limited / speed;
+        b.vy *= limited / speed;
+    }
+}
+
+// Same for a paddle that widens next to one
+void KeepPaddleInWorld(GameState& g)
+{
+    g.paddle.x = Clamp(g.paddle.x, 0.f, (float)g.worldW - g.paddle.w);
+}
+
+// Sticky running out launches whatever it was holding
+void ReleaseStuckBalls(GameState& g)
+{
+    bool anyStuck = false;
+    for (int i = 0; i < g.ballMax; ++i)
+    {
+        Ball& b = g.ball[i];
+        if (!b.alive || !b.stuck) continue;
+
+        b.stuck = false;
+
+        // If velocity is zero, give it an initial launch
+        if (b.vx == 0.f && b.vy == 0.f)
+        {
+            b.vx = (i & 1) ? BASE_BALL_SPEED : -BASE_BALL_SPEED;
+            b.vy = -BASE_BALL_SPEED;
+        }
+        anyStuck = true;
+    }
+    if (anyStuck) g.ballLaunched = true;
+}
+
+// One row, forwards or undone. Ball rows are one straight loop over the
+// ball array each, with nothing called through a pointer.
+void RunEffectRow(GameState& g, const EffectRow& e, bool undo)
+{
+    float m = e.magnitude;
+    if (undo)
+    {
+        if (e.undo == EFFECT_KEEP) return;
+        if (e.op == EFFECT_SET) m = e.undo;
+        else if (e.op == EFFECT_ADD) m = -m;
+    }
+    const bool divide = undo && e.op == EFFECT_SCALE;
+
+    switch (e.target)
+    {
+    case EFFECT_NONE:
+        break;
+    case EFFECT_BALL_SPEED:
+        for (int i = 0; i < g.ballCap; ++i)
+        {
+            Ball& b = g.ball[i];
+            if (!b.alive) continue;
+            if (divide) { b.vx /= m; b.vy /= m; }
+            else { b.vx *= m; b.vy *= m; }
+            LimitBallSpeed(b);
+        }
+        break;
+    case EFFECT_BALL_RADIUS:
+        for (int i = 0; i < g.ballCap; ++i)
+        {
+            Ball& b = g.ball[i];
+            if (!b.alive) continue;
+            b.r = BASE_BALL_RADIUS * m;
+            KeepBallInWalls(g, b);
+        }
+        break;
+    case EFFECT_BALL_PENETRATION:
+        for (int i = 0; i < g.ballCap; ++i)
+        {
+            Ball& b = g.ball[i];
+            if (!b.alive) continue;
+            b.penetrateMax = b.penetrateCount = (int)m;
+        }
+        break;
+    case EFFECT_BALL_COUNT:
+        g.ballMax = min((int)m, g.ballCap);
+        SetActiveBallCount(g);
+        break;
+    case EFFECT_PADDLE_WIDTH:
+        if (divide) g.paddle.w /= m;
+        else g.paddle.w *= m;
+        KeepPaddleInWorld(g);
+        break;
+    case EFFECT_SPIN:
+        g.spin = m != 0.f;
+        break;
+    case EFFECT_STICKY:
+        g.stickyPaddle = m != 0.f;
+        if (!g.stickyPaddle) ReleaseStuckBalls(g);
+        break;
+    case EFFECT_INVULNERABLE:
+        g.invulnerable = m != 0.f;
+        break;
+    case EFFECT_LIVES:
+        g.lives += (int)m;
+        break;
+    case EFFECT_DROPS:
+        for (int i = 0; i < (int)m; ++i)
+            SpawnPowerUp(g, (float)(GameRand(g) % g.worldW), 0.f);
+        break;
+    }
+}
+
+void RunEffects(GameState& g, const PowerUpDef& def, bool undo)
+{
+    int rows = 0;
+    while (rows < MAX_EFFECT_ROWS && def.effects[rows].target != EFFECT_NONE) rows++;
+    if (undo)
+        for (int i = rows - 1; i >= 0; --i) RunEffectRow(g, def.effects[i], true);
+    else
+        for (int i = 0; i < rows; ++i) RunEffectRow(g, def.effects[i], false);
+}
+
+bool HasEffect(const PowerUpDef& def, EffectTarget target)
+{
+    for (int i = 0; i < MAX_EFFECT_ROWS; ++i)
+        if (def.effects[i].target == target) return true;
+    return false;
+}
+
+// All power-ups are defined here, in one array
+PowerUpDef g_powerUps[] =
+{
+    { "Ball Fast",    RGB(255, 0, 255),  600, false, { { EFFECT_BALL_SPEED, EFFECT_SCALE, 1.5f, EFFECT_REVERT } } },
+    { "Ball Slow",    RGB(0, 255, 255),  600, true,  { { EFFECT_BALL_SPEED, EFFECT_SCALE, 0.7f, EFFECT_REVERT } } },
+    { "Ball Big",     RGB(255, 255, 0),  600, true,  { { EFFECT_BALL_RADIUS, EFFECT_SET, 1.5f, 1.f },
+                                                       { EFFECT_BALL_PENETRATION, EFFECT_SET, 2.f, 0.f } } },
+    { "Ball Small",   RGB(0, 0, 255),    600, false, { { EFFECT_BALL_RADIUS, EFFECT_SET, 0.7f, 1.f },
+                                                       { EFFECT_BALL_PENETRATION, EFFECT_SET, 0.f, EFFECT_KEEP } } },
+    { "Ball Spin",    RGB(255, 165, 0),  600, false, { { EFFECT_SPIN, EFFECT_SET, 1.f, 0.f } } },
+    { "Multi Ball",   RGB(128, 0, 128),  0,   true,  { { EFFECT_BALL_COUNT, EFFECT_SET, 3.f, EFFECT_KEEP } } },
+    { "Multi Rare",   RGB(75, 0, 130),   0,   true,  { { EFFECT_BALL_COUNT, EFFECT_SET, 6.f, EFFECT_KEEP } } },
+    { "Wreaking Ball",RGB(255, 20, 147), 0,   true,  { { EFFECT_BALL_RADIUS, EFFECT_SET, 3.f, EFFECT_KEEP },
+                                                       { EFFECT_BALL_PENETRATION, EFFECT_SET, 100.f, EFFECT_KEEP } } },
+    { "Paddle Wide",  RGB(0, 255, 0),    600, true,  { { EFFECT_PADDLE_WIDTH, EFFECT_SCALE, 1.5f, EFFECT_REVERT } } },
+    { "Paddle Narrow",RGB(255, 140, 0),  600, false, { { EFFECT_PADDLE_WIDTH, EFFECT_SCALE, 0.7f, EFFECT_REVERT } } },
+    { "Sticky Paddle",RGB(34, 139, 34),  600, false, { { EFFECT_STICKY, EFFECT_SET, 1.f, 0.f } } },
+    { "Invulnerable", RGB(255, 215, 0),  600, true,  { { EFFECT_INVULNERABLE, EFFECT_SET, 1.f, 0.f } } },
+    { "Chaos",        RGB(220, 20, 60),  0,   false, { { EFFECT_DROPS, EFFECT_ADD, 20.f, EFFECT_KEEP } } },
+    { "Add Life",     RGB(255, 0, 0),    0,   true,  { { EFFECT_LIVES, EFFECT_ADD, 1.f, EFFECT_KEEP } } },
+};
+
+const int g_powerUpCount = sizeof(g_powerUps) / sizeof(g_powerUps[0]);
+
+// Drops every falling and timed power-up without running revert functions;
+// only for starting a fresh session.
+void ResetPowerUps(GameState& g)
+{
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+        g.fallingPowerUps[i] = FallingPowerUp();
+    for (int i = 0; i < MAX_ACTIVE_POWERUPS; ++i)
+        g.activePowerUps[i] = ActivePowerUp();
+    g.spin = false;
+    g.stickyPaddle = false;
+    g.invulnerable = false;
+}
+
+int RandomPowerUpIndex(GameState& g)
+{
+    return GameRand(g) % g_powerUpCount;
+}
+
+void SpawnPowerUp(GameState& g, float x, float y)
+{
+    int slot = -1;
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+    {
+        if (!g.fallingPowerUps[i].alive)
+        {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == -1) return; // no free slot
+
+    g.fallingPowerUps[slot].alive = true;
+    g.fallingPowerUps[slot].x = x;
+    g.fallingPowerUps[slot].y = y;
+    g.fallingPowerUps[slot].index = RandomPowerUpIndex(g);
+    if (g.hooks.telemetry) g.hooks.telemetry->spawned[g.fallingPowerUps[slot].index]++;
+}
+
+void SpawnPowerUp(GameState& g, float x, float y, int index)
+{
+    if (index < 0 || index >= g_powerUpCount) return;
+
+    int slot = -1;
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+    {
+        if (!g.fallingPowerUps[i].alive)
+        {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == -1) return;
+
+    g.fallingPowerUps[slot].alive = true;
+    g.fallingPowerUps[slot].x = x;
+    g.fallingPowerUps[slot].y = y;
+    g.fallingPowerUps[slot].index = index;
+    if (g.hooks.telemetry) g.hooks.telemetry->spawned[index]++;
+}
+
+ActivePowerUp* FindActivePowerUp(GameState& g, const PowerUpDef* def)
+{
+    for (int i = 0; i < MAX_ACTIVE_POWERUPS; ++i)
+    {
+        if (g.activePowerUps[i].def == def && g.activePowerUps[i].timer > 0)
+            return &g.activePowerUps[i];
+    }
+    return nullptr;
+}
+
+void ApplyPowerUp(GameState& g, int index)
+{
+    if (index < 0 || index >= g_powerUpCount) return;
+    const PowerUpDef* def = &g_powerUps[index];
+
+	// Instant effect
+    if (def->durationFrames == 0)
+    {
+        RunEffects(g, *def, false);
+        return;
+    }
+
+    // Timed effect
+    ActivePowerUp* existing = FindActivePowerUp(g, def);
+    if (existing)
+    {
+        // refresh timer only
+        existing->timer = def->durationFrames;
+        return;
+    }
+
+    // find empty slot
+    for (int i = 0; i < MAX_ACTIVE_POWERUPS; ++i)
+    {
+        if (g.activePowerUps[i].timer <= 0)
+        {
+            g.activePowerUps[i].def = def;
+            g.activePowerUps[i].timer = def->durationFrames;
+            RunEffects(g, *def, false);
+            break;
+        }
+    }
+}
+
+void UpdateFallingPowerUps(GameState& g)
+{
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+    {
+        FallingPowerUp& pu = g.fallingPowerUps[i];
+        if (!pu.alive) continue;
+
+        pu.y += POWERUP_FALL_SPEED;
+
+        RECT paddleRect = { (LONG)g.paddle.x, (LONG)g.paddle.y,
+                            (LONG)(g.paddle.x + g.paddle.w), (LONG)(g.paddle.y + g.paddle.h) };
+
+        // Nothing is caught once the game is over (an Add Life would bring
+        // it back with lives left)
+        if (!g.gameOver && CircleRectIntersect(pu.x, pu.y, 8.f, paddleRect))
+        {
+            if (g.hooks.telemetry) g.hooks.telemetry->caught[pu.index]++;
+            if (g.hooks.audio) QueueSound(g, SOUND_POWERUP, pu.x);
+            ApplyPowerUp(g, pu.index);
+            pu.alive = false;
+        }
+
+        // Remove if it falls off screen
+        if (pu.y > g.worldH + 10.f)
+        {
+            if (g.hooks.telemetry && pu.alive) g.hooks.telemetry->missed[pu.index]++;
+            pu.alive = false;
+        }
+    }
+}
+
+void UpdateActivePowerUps(GameState& g)
+{
+    for (int i = 0; i < MAX_ACTIVE_POWERUPS; ++i)
+    {
+        ActivePowerUp& apu = g.activePowerUps[i];
+        if (apu.timer > 0)
+        {
+            apu.timer--;
+            if (apu.timer == 0)
+            {
+                // Remove effect when timer ends
+                if (g.hooks.telemetry && apu.def) g.hooks.telemetry->expired[apu.def - g_powerUps]++;
+                if (apu.def)
+                    RunEffects(g, *apu.def, true);
+
+                apu.def = nullptr;
+            }
+        }
+    }
+}
+
+// ============================================================
+// Worker Pool
+// ============================================================
+
+// 0 or 1 threads = tasks run on the calling thread only. The planner runs
+// rollouts as tasks; a tick itself always runs on one thread.
+
+struct WorkerPool
+{
+    TaggedVector<std::thread, MEM_THREADS> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    ParallelTask task = nullptr;
+    void* ctx = nullptr;
+    int taskCount = 0;
+    std::atomic<int> nextTask{ 0 };
+    int busy = 0;
+    unsigned int generation = 0;
+    bool quit = false;
+};
+
+static WorkerPool g_pool;
+static thread_local bool g_inParallelTask = false;
+int g_simThreads = 0;
+
+void DrainParallelTasks()
+{
+    g_inParallelTask = true;
+    for (;;)
+    {
+        int i = g_pool.nextTask.fetch_add(1);
+        if (i >= g_pool.taskCount) break;
+        g_pool.task(g_pool.ctx, i);
+    }
+    g_inParallelTask = false;
+}
+
+void WorkerLoop()
+{
+    unsigned int seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(g_pool.mutex);
+            g_pool.wake.wait(lock, [&] { return g_pool.quit || g_pool.generation != seen; });
+            if (g_pool.quit) return;
+            seen = g_pool.generation;
+        }
+
+        DrainParallelTasks();
+
+        std::lock_guard<std::mutex> lock(g_pool.mutex);
+        if (--g_pool.busy == 0)
+            g_pool.done.notify_one();
+    }
+}
+
+void StopWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_pool.mutex);
+        g_pool.quit = true;
+    }
+    g_pool.wake.notify_all();
+    for (size_t i = 0; i < g_pool.threads.size(); ++i)
+        g_pool.threads[i].join();
+    g_pool.threads.clear();
+    g_pool.quit = false;
+}
+
+void SetSimulationThreads(int threads)
+{
+    StopWorkerPool();
+    g_simThreads = threads;
+    for (int i = 1; i < threads; ++i)
+        g_pool.threads.push_back(std::thread(WorkerLoop));
+}
+
+void RunParallel(ParallelTask task, void* ctx, int count)
+{
+    if (g_inParallelTask)
+    {
+        for (int i = 0; i < count; ++i) task(ctx, i);
+        return;
+    }
+
+    g_pool.task = task;
+    g_pool.ctx = ctx;
+    g_pool.taskCount = count;
+    g_pool.nextTask = 0;
+
+    if (!g_pool.threads.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(g_pool.mutex);
+            g_pool.busy = (int)g_pool.threads.size();
+            g_pool.generation++;
+        }
+        g_pool.wake.notify_all();
+    }
+
+    DrainParallelTasks();
+
+    if (!g_pool.threads.empty())
+    {
+        std::unique_lock<std::mutex> lock(g_pool.mutex);
+        g_pool.done.wait(lock, [] { return g_pool.busy == 0; });
+    }
+}
+
+// ============================================================
+// Update / Game Logic
+// ============================================================
+
+void HandleInput(GameState& g, const TickInput& in)
+{
+    g.paddlePrevX = g.paddle.x;
+    g.paddle.x += in.paddleMove;
+    g.paddle.x = Clamp(g.paddle.x, 0.f, (float)g.worldW - g.paddle.w);
+    g.paddleVX = g.paddle.x - g.paddlePrevX;
+}
+
+void HandleLaunchInput(GameState& g, const TickInput& in)
+{
+    if (g.gameOver && in.restart)
+        InitGame(g);
+
+    if (!g.gameOver && !g.ballLaunched && in.launch){
+
+        g.ballLaunched = true;
+    }
+}
+
+template<class Board>
+void UpdateBall(GameState& g)
+{
+    int aliveCount = 0;
+
+    if (g.ballLaunched)
+    {
+        for (int i = 0; i < Board::balls(g); ++i)
+        {
+            Ball& b = Board::ball(g, i);
+            if (b.alive && b.stuck)
+            {
+                b.stuck = false;
+                //Force launch direction and velocity
+				b.vx = (i & 1) ? BASE_BALL_SPEED * 0.5f : BASE_BALL_SPEED * 0.7f;
+				b.vy = -BASE_BALL_SPEED;
+            }
+        }
+    }
+    for (int i = 0; i < Board::balls(g); ++i)
+    {
+        Ball& b = Board::ball(g, i);
+        if (!b.alive) continue;
+
+        // --- Sticky paddle hold ---
+        if (b.stuck || !g.ballLaunched)
+        {
+            b.x = g.paddle.x + g.paddle.w * 0.5f;
+            b.y = g.paddle.y - b.r - 1.f;
+            continue; // skip motion
+        }
+
+        // Apply spin curve (it only ever adds to vx, so it can run a fast ball
+        // past the limit)
+        b.vx += b.spin * SPIN_ACCEL;
+        if (b.vx * b.vx + b.vy * b.vy > MAX_BALL_SPEED * MAX_BALL_SPEED)
+            LimitBallSpeed(b);
+        // Spin decay
+        b.spin *= SPIN_DECAY;
+ 
+        // --- Normal movement ---
+        b.prevX = b.x;
+        b.prevY = b.y;
+        b.x += b.vx;
+        b.y += b.vy;
+        // Left / Right walls
+        if (b.x - b.r < 0)
+        {
+            b.x = b.r;
+            b.vx = -b.vx;
+        }
+        else if (b.x + b.r > g.worldW)
+        {
+            b.x = g.worldW - b.r;
+            b.vx = -b.vx;
+        }
+        // Top wall
+        if (b.y - b.r < 0)
+        {
+            b.y = b.r;
+            b.vy = -b.vy;
+        }
+        // Bottom (ball lost)
+        if (b.y - b.r > g.worldH)
+        {
+            b.alive = false;
+            if (g.hooks.telemetry) TelemetryBallLost(g, i);
+            continue;
+        }
+        // Only count balls that are alive and on-screen
+		aliveCount++;
+    }
+    // If ALL balls are gone ? lose life
+    if (aliveCount == 0 && g.ballLaunched)
+    {
+        g.lives--;
+
+        if (g.lives <= 0)
+        {
+            g.lives = 0;
+            g.gameOver = true;
+            g.ballLaunched = false;
+        }
+        else
+        {
+			KillAllBalls(g);
+            InitBall(g);       // respawn base balls
+            g.ballLaunched = false;
+        }
+    }
+}
+
+template<class Board>
+void HandlePaddleCollision(GameState& g)
+{
+    if (!g.ballLaunched) return;
+
+    RECT paddleRect = { (LONG)g.paddle.x, (LONG)g.paddle.y,
+                        (LONG)(g.paddle.x + g.paddle.w), (LONG)(g.paddle.y + g.paddle.h) };
+
+    for (int i = 0; i < Board::balls(g); ++i)
+    {
+        Ball& ball = Board::ball(g, i);
+        if (!ball.alive) continue;
+        if (ball.vy <= 0.f) continue;
+
+        if (!CircleRectIntersect(ball.x, ball.y, ball.r, paddleRect))
+            continue;
+
+        // Sticky paddle: stop ball until relaunch
+        if (g.stickyPaddle)
+        {
+		    ball.stuck = true;
+            g.ballLaunched = false;
+            continue;
+        }
+        // Calculate hit position (-1 .. 1)
+        float hit =
+            (ball.x - (g.paddle.x + g.paddle.w * 0.5f)) /
+            (g.paddle.w * 0.5f);
+        if (g.hooks.telemetry) TelemetryPaddleContact(g, hit);
+        if (g.hooks.particles) EmitPaddleSparks(g, ball);
+        if (g.hooks.audio) QueueSound(g, SOUND_PADDLE, ball.x);
+
+        PaddleBounce(hit, ball.vx, ball.vy);
+
+        if (g.spin)
+        {
+            ball.spin += g.paddleVX * 0.05f;
+            ball.spin = Clamp(ball.spin, -1.f, 1.f);
+        }
+    }
+}
+
+// Resolves one ball/brick contact: damage, score, power-up drop and the
+// reflection. Both board policies funnel through here, in the same
+// (ball, brick) order, so they stay interchangeable.
+template<class Board>
+inline void ApplyBrickHit(GameState& g, Ball& ball, float& ballY, int row, int col, const LevelDef& lvl)
+{
+    int i = row * Board::cols(g) + col;
+    uint8_t& hits = Board::hits(g, row, col);
+    const RECT rc = BrickRect(g, row, col);
+    if (g.hooks.brickLog) g.hooks.brickLog->push_back(i);
+    if (g.hooks.telemetry) TelemetryBrickHit(g, i);
+    if (g.hooks.particles && (hits == 1 || ball.penetrateCount > 0)) EmitBrickDebris(g, rc, hits);
+    if (g.hooks.audio) QueueSound(g, (hits == 1 || ball.penetrateCount > 0) ? SOUND_BRICK_KILL : SOUND_BRICK_HIT, ball.x);
+
+    // Handle brick penetration and destruction
+    if (ball.penetrateCount > 0) {
+        hits = 0;
+        OnBrickDestroyed(g, i);
+        ball.penetrateCount--; // decrement penetration
+        g.score += 100;
+        return;
+    }
+
+    //Handle normal brick hits
+    hits--;
+    if (hits == 0)
+    {
+        OnBrickDestroyed(g, i);
+        g.score += 100;
+    }
+    else
+    {
+        g.score += 25;
+    }
+    if (hits == 0) {
+        // Get the power-up rule for this brick
+        int puRule = -1;
+        if (row < lvl.rows && col < lvl.cols)
+        { puRule = lvl.mustDropPowerUp[row][col];}
+
+        // Decide which power-up to spawn, if any
+        bool shouldDrop = false;
+
+        if (puRule > 0){
+                shouldDrop = true;
+        }
+        else if (puRule == 0) {
+            shouldDrop = (GameRand(g) % 5) == 0; // 20%
+           }
+        else {shouldDrop = false;}
+
+        if (shouldDrop)
+        {
+            float px = (rc.left + rc.right) * 0.5f;
+            float py = (rc.top + rc.bottom) * 0.5f + g.brickOffsetY;
+
+            if (puRule > 0) {
+                SpawnPowerUp(g, px, py, puRule - 1);
+            }
+            else {
+                SpawnPowerUp(g, px, py);
+            }
+        }
+    }
+
+    // Reflect ball only if no penetrateCount left
+    if (ball.penetrateCount == 0)
+    {
+        // The face it came in through: of the two it is moving into
+        // (relative to the board, which may have just come down onto it),
+        // the one it crossed last
+        float relVY = ball.vy - g.boardShiftY;
+        bool fromLeft = ball.vx > 0.f, fromAbove = relVY > 0.f;
+        float depthX = fromLeft ? ball.x + ball.r - rc.left : rc.right - (ball.x - ball.r);
+        float depthY = fromAbove ? ballY + ball.r - rc.top : rc.bottom - (ballY - ball.r);
+        bool sideHit = ball.vx != 0.f && (relVY == 0.f || depthX * fabsf(relVY) < depthY * fabsf(ball.vx));
+
+        // Leave moving away from that face (so two contacts on the same side
+        // can't cancel out)
+        if (sideHit) { ball.vx = fromLeft ? -fabsf(ball.vx) : fabsf(ball.vx); }
+        else
+        {
+            ball.vy = fromAbove ? -fabsf(ball.vy) : fabsf(ball.vy);
+            ball.vx += ball.spin * 0.2f;
+            if (ball.vx * ball.vx + ball.vy * ball.vy > MAX_BALL_SPEED * MAX_BALL_SPEED)
+                LimitBallSpeed(ball);
+        }
+
+        // and put it back just outside that face, so it can't hit the brick
+        // again from inside
+        const float SEPARATION = 0.01f;
+        if (sideHit)
+            ball.x = fromLeft ? rc.left - ball.r - SEPARATION : rc.right + ball.r + SEPARATION;
+        else
+            ballY = fromAbove ? rc.top - ball.r - SEPARATION : rc.bottom + ball.r + SEPARATION;
+
+        ball.y = ballY + g.brickOffsetY;
+        KeepBallInWalls(g, ball);
+        ballY = ball.y - g.brickOffsetY;
+        ball.penetrateCount = ball.penetrateMax; // reset penetrate count after reflection
+    }
+}
+
+// Gaps between bricks are narrower than a ball, so putting a ball back out
+// of one brick can put it into the next. A ball that was moved gets a few
+// more rounds against whatever it touches now, and if it is still wedged
+// it goes back to where its move started (keeping the bounce). A ball that
+// grew this tick can be wedged there too, and breaks whatever it still
+// touches. As in the first pass, a round's contacts are the bricks the ball
+// touched where the round started and still touches, so they never depend
+// on how many cells the broadphase looked at. Every board policy runs this
+// after a ball's contacts, so they still agree.
+template<class Board>
+inline void SettleBall(GameState& g, Ball& ball, float& ballY, const LevelDef& lvl)
+{
+    const int ROUNDS = 3;
+    for (int round = 0; ball.penetrateCount == 0; ++round)
+    {
+        const float startX = ball.x, startY = ballY;
+        int c0, c1, r0, r1;
+        BrickCellsNear<Board>(g, startX, startY, ball.r, c0, c1, r0, r1);
+        bool touching = false;
+        for (int r = r0; r <= r1 && !(touching && round == ROUNDS); ++r)
+        {
+            for (int c = c0; c <= c1; ++c)
+            {
+                if (!Board::hits(g, r, c)) continue;
+                RECT rc = BrickRect(g, r, c);
+                if (!CircleRectIntersect(startX, startY, ball.r, rc) || !CircleRectIntersect(ball.x, ballY, ball.r, rc)) continue;
+                touching = true;
+                if (round == ROUNDS) break;
+                ApplyBrickHit<Board>(g, ball, ballY, r, c, lvl);
+            }
+        }
+        if (!touching) return;
+        if (round == ROUNDS)
+        {
+            ball.x = ball.prevX;
+            ball.y = ball.prevY;
+            ballY = ball.y - g.brickOffsetY;
+
+            const float backX = ball.x, backY = ballY;
+            BrickCellsNear<Board>(g, backX, backY, ball.r, c0, c1, r0, r1);
+            for (int r = r0; r <= r1; ++r)
+                for (int c = c0; c <= c1; ++c)
+                    if (Board::hits(g, r, c) && CircleRectIntersect(backX, backY, ball.r, BrickRect(g, r, c)) &&
+                        CircleRectIntersect(ball.x, ballY, ball.r, BrickRect(g, r, c)))
+                    {
+                        ball.penetrateCount = 1; // a penetrating hit: destroyed, no bounce
+                        ApplyBrickHit<Board>(g, ball, ballY, r, c, lvl);
+                    }
+            return;
+        }
+    }
+}
+
+template<class Board>
+void HandleBrickCollisions(GameState& g)
+{
+    if (!g.ballLaunched) return;
+
+    const LevelDef& lvl = CurrentLevelDef(g);
+
+    for (int b = 0; b < Board::balls(g); ++b)
+    {
+        Ball& ball = Board::ball(g, b);
+        if (!ball.alive) continue;
+
+        // Test in board space so descent never moves the bricks
+        float ballY = ball.y - g.brickOffsetY;
+        const float startX = ball.x, startY = ballY;
+
+        // Contacts are the bricks the ball overlaps where it started the
+        // pass that it still overlaps once earlier contacts have moved it,
+        // so only the cells around the start need looking at
+        int c0, c1, r0, r1;
+        BrickCellsNear<Board>(g, startX, startY, ball.r, c0, c1, r0, r1);
+        for (int r = r0; r <= r1; ++r)
+        {
+            for (int c = c0; c <= c1; ++c)
+            {
+                if (!Board::hits(g, r, c)) continue;
+                RECT rc = BrickRect(g, r, c);
+                if (!CircleRectIntersect(startX, startY, ball.r, rc)) continue;
+                if (!CircleRectIntersect(ball.x, ballY, ball.r, rc)) continue;
+
+                ApplyBrickHit<Board>(g, ball, ballY, r, c, lvl);
+            }
+        }
+        if (ball.x != startX || ballY != startY)
+            SettleBall<Board>(g, ball, ballY, lvl);
+    }
+}
+
+// ------------------------------------------------------------
+// Ball / ball collisions (optional)
+// ------------------------------------------------------------
+// Equal-mass elastic bounces between balls in flight, for when multiball
+// clones shouldn't pass through each other. The broadphase is sort-and-sweep
+// on x: ball slots stay sorted by left edge across ticks and are re-sorted
+// with an insertion sort, which is near O(n) since the order barely changes
+// between ticks, and only balls whose x spans overlap are tested. Ties go by
+// slot, so the order (and the outcome) depends only on the game, not on
+// what was sorted last.
+
+static const float MIN_BALL_VY = BALL_SPEED * 0.2f; // nothing rattles sideways forever
+
+// Overlapping pairs of balls in flight into scratch.ballPairs, in sweep order
+void FindBallPairs(GameState& g)
+{
+    const int n = g.ballCap;
+    if ((int)g.scratch.sweepOrder.size() != n)
+    {
+        g.scratch.sweepOrder.resize(n);
+        for (int i = 0; i < n; ++i) g.scratch.sweepOrder[i] = i;
+    }
+    g.scratch.sweepLeft.resize(n);
+    for (int i = 0; i < n; ++i)
+    {
+        const Ball& b = g.ball[i];
+        g.scratch.sweepLeft[i] = (b.alive && !b.stuck) ? b.x - b.r : INFINITY;
+    }
+
+    int* order = g.scratch.sweepOrder.data();
+    const float* left = g.scratch.sweepLeft.data();
+    for (int i = 1; i < n; ++i)
+    {
+        int slot = order[i];
+        float key = left[slot];
+        int j = i;
+        for (; j > 0; --j)
+        {
+            int prev = order[j - 1];
+            if (left[prev] < key || (left[prev] == key && prev < slot)) break;
+            order[j] = prev;
+        }
+        order[j] = slot;
+    }
+
+    g.scratch.ballPairs.clear();
+    for (int i = 0; i < n && left[order[i]] != INFINITY; ++i)
+    {
+        const Ball& a = g.ball[order[i]];
+        float right = a.x + a.r;
+        for (int j = i + 1; j < n && left[order[j]] <= right; ++j)
+        {
+            const Ball& b = g.ball[order[j]];
+            float dx = b.x - a.x, dy = b.y - a.y, rr = a.r + b.r;
+            if (dx * dx + dy * dy < rr * rr)
+                g.scratch.ballPairs.push_back(std::make_pair(order[i], order[j]));
+        }
+    }
+}
+
+// Speed back in range and not too flat
+void KeepBallPlayable(Ball& b)
+{
+    if (fabsf(b.vy) < MIN_BALL_VY) b.vy = (b.vy < 0.f) ? -MIN_BALL_VY : MIN_BALL_VY;
+    float speed2 = b.vx * b.vx + b.vy * b.vy;
+    if (speed2 > MAX_BALL_SPEED * MAX_BALL_SPEED || speed2 < MIN_BALL_SPEED * MIN_BALL_SPEED)
+        LimitBallSpeed(b);
+}
+
+void ResolveBallPair(const GameState& g, Ball& a, Ball& b)
+{
+    float dx = b.x - a.x, dy = b.y - a.y, rr = a.r + b.r;
+    float d2 = dx * dx + dy * dy;
+    if (d2 >= rr * rr) return; // an earlier pair already moved them apart
+
+    // Clones share a position; split those sideways
+    float d = sqrtf(d2);
+    float nx = 1.f, ny = 0.f;
+    if (d > 0.f) { nx = dx / d; ny = dy / d; }
+
+    // Equal masses: swap the velocity components along the normal, if closing
+    float closing = (a.vx - b.vx) * nx + (a.vy - b.vy) * ny;
+    if (closing > 0.f)
+    {
+        a.vx -= closing * nx; a.vy -= closing * ny;
+        b.vx += closing * nx; b.vy += closing * ny;
+        KeepBallPlayable(a);
+        KeepBallPlayable(b);
+    }
+
+    // and move each half the overlap apart
+    const float SEPARATION = 0.01f;
+    float push = (rr - d) * 0.5f + SEPARATION;
+    a.x -= nx * push; a.y -= ny * push;
+    b.x += nx * push; b.y += ny * push;
+    KeepBallInWalls(g, a);
+    KeepBallInWalls(g, b);
+}
+
+// Before the paddle and brick passes, which resolve whatever this pushes a
+// ball into
+void HandleBallCollisions(GameState& g)
+{
+    FindBallPairs(g);
+    for (size_t i = 0; i < g.scratch.ballPairs.size(); ++i)
+        ResolveBallPair(g, g.ball[g.scratch.ballPairs[i].first], g.ball[g.scratch.ballPairs[i].second]);
+}
+
+bool AreAllBricksCleared(const GameState& g)
+{
+    return g.lowestLiveRow < 0;
+}
+
+// Brick descent pressure: every descendIntervalFrames of play the board moves
+// down by descendAmount. Only the lowest live row can reach the paddle line,
+// and every brick in a row shares the same rect, so the check is O(1).
+void UpdateBrickDescent(GameState& g)
+{
+    g.boardShiftY = 0;
+    if (g.gameOver || !g.ballLaunched) return;
+
+    const LevelDef& lvl = CurrentLevelDef(g);
+    if (lvl.descendIntervalFrames <= 0 || g.lowestLiveRow < 0) return;
+
+    if (++g.descendTimer < lvl.descendIntervalFrames) return;
+    g.descendTimer = 0;
+    g.brickOffsetY += lvl.descendAmount;
+    g.boardShiftY = lvl.descendAmount;
+
+    int lowestBottom = BrickRect(g, g.lowestLiveRow, 0).bottom + g.brickOffsetY;
+    if (lowestBottom >= (int)g.paddle.y)
+    {
+        g.gameOver = true;
+        g.ballLaunched = false;
+    }
+}
+
+void CheckLevelCompletion(GameState& g)
+{
+    if (g.gameOver) return;
+
+    if (!g.levelAdvancePending && AreAllBricksCleared(g))
+    {
+        g.levelAdvancePending = true;
+        g.ballLaunched = false;
+    }
+
+    if (g.levelAdvancePending && !g.ballLaunched)
+    {
+        g.level++;
+        InitBricksForLevel(g, g.level);
+		KillAllBalls(g);
+        InitBall(g);
+        g.levelAdvancePending = false;
+    }
+}
+
+// One simulation tick after input has been applied.
+template<class Board>
+void StepSimulationOn(GameState& g)
+{
+    UpdateBall<Board>(g);
+
+    // Whatever moves bricks or grows balls goes before the collision passes,
+    // so they resolve its overlaps in the same tick
+    UpdateBrickDescent(g);
+    UpdateFallingPowerUps(g);      // <--- added
+    UpdateActivePowerUps(g);       // <--- added
+
+    if (g.ballLaunched)
+    {
+        if (g.ballCollisions) HandleBallCollisions(g);
+        HandlePaddleCollision<Board>(g);
+        HandleBrickCollisions<Board>(g);
+    }
+    CheckLevelCompletion(g);
+    if (g.hooks.telemetry) TelemetryTick(g, *g.hooks.telemetry);
+}
+
+template<class Board>
+void UpdateGameOn(GameState& g, const TickInput& in)
+{
+    HandleInput(g, in);
+    HandleLaunchInput(g, in);
+    StepSimulationOn<Board>(g);
+}
+
+template void StepSimulationOn<DefaultBoard>(GameState& g);
+template void StepSimulationOn<RuntimeBoard>(GameState& g);
+template void UpdateGameOn<DefaultBoard>(GameState& g, const TickInput& in);
+template void UpdateGameOn<RuntimeBoard>(GameState& g, const TickInput& in);
+template void StepSimulationOn<BruteForceBoard>(GameState& g);
+template void UpdateGameOn<BruteForceBoard>(GameState& g, const TickInput& in);
+
+void StepSimulation(GameState& g)
+{
+    if (DefaultBoard::Matches(g))
+        StepSimulationOn<DefaultBoard>(g);
+    else
+        StepSimulationOn<RuntimeBoard>(g);
+}
+
+// A restart can reshape the board, so the policy is picked per tick
+void UpdateGame(GameState& g, const TickInput& in)
+{
+    if (DefaultBoard::Matches(g))
+        UpdateGameOn<DefaultBoard>(g, in);
+    else
+        UpdateGameOn<RuntimeBoard>(g, in);
+}
+
+// ============================================================
+// Invariants
+// ============================================================
+
+// Structural checks on a game after a tick. Returns how many
+// invariants are broken and describes the first in 'what' (if given).
+// O(balls + bricks); meant for soak runs and fuzzing, not every frame.
+int CheckInvariants(const GameState& g, const char** what)
+{
+    int broken = 0;
+    auto fail = [&](const char* msg)
+    {
+        if (broken++ == 0 && what) *what = msg;
+    };
+
+    if (!(g.paddle.x >= 0.f && g.paddle.x <= g.worldW - g.paddle.w + 0.001f))
+        fail("paddle outside the world");
+    if (g.lives < 0) fail("negative lives");
+    if (g.ballMax < 1 || g.ballMax > g.ballCap) fail("active ball count out of range");
+
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        const Ball& b = g.ball[i];
+        if (!b.alive) continue;
+        if (i >= g.ballMax) fail("ball alive past the active count");
+        if (!isfinite(b.x) || !isfinite(b.y) || !isfinite(b.vx) || !isfinite(b.vy))
+        {
+            fail("ball state not finite");
+            continue;
+        }
+        if (b.x < b.r - 0.001f || b.x > g.worldW - b.r + 0.001f || b.y < b.r - 0.001f)
+            fail("ball outside the walls");
+        if (b.penetrateCount < 0 || b.penetrateCount > b.penetrateMax)
+            fail("ball penetration count out of range");
+        if (b.stuck || !g.ballLaunched) continue;
+
+        // In flight
+        float speed = sqrtf(b.vx * b.vx + b.vy * b.vy);
+        if (speed > MAX_BALL_SPEED + 0.001f) fail("ball faster than MAX_BALL_SPEED");
+        if (b.vy == 0.f) fail("ball not moving vertically");
+
+        // A ball that bounces off bricks must have been put back outside them
+        if (b.penetrateCount > 0) continue;
+        float ballY = b.y - g.brickOffsetY;
+        int c0, c1, r0, r1;
+        BrickCellsNear(g, b.x, ballY, b.r, c0, c1, r0, r1);
+        for (int r = r0; r <= r1; ++r)
+            for (int c = c0; c <= c1; ++c)
+                if (BrickHits(g, r, c) && CircleRectIntersect(b.x, ballY, b.r, BrickRect(g, r, c)))
+                    fail("ball inside a live brick");
+    }
+
+    int lowest = -1, total = 0;
+    for (int r = 0; r < g.boardRows; ++r)
+    {
+        int live = 0;
+        for (int c = 0; c < g.boardCols; ++c)
+        {
+            int hits = BrickHits(g, r, c);
+            if (hits > 5) fail("brick with more than 5 hits");
+            live += hits > 0;
+        }
+        if (live != g.rowLiveCount[r]) fail("row live count out of sync");
+        if (live) lowest = r;
+        total += live;
+    }
+    if (lowest != g.lowestLiveRow) fail("lowest live row out of sync");
+
+    // Tile cells past the board edge must stay empty
+    int stored = 0;
+    for (size_t i = 0; i < g.brickHits.size(); ++i) stored += g.brickHits[i] > 0;
+    if (stored != total) fail("brick outside the board");
+
+    for (int i = 0; i < MAX_ACTIVE_POWERUPS; ++i)
+        if (g.activePowerUps[i].timer < 0) fail("negative power-up timer");
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+    {
+        const FallingPowerUp& pu = g.fallingPowerUps[i];
+        if (pu.alive && (pu.index < 0 || pu.index >= g_powerUpCount)) fail("falling power-up of unknown type");
+    }
+    return broken;
+}
+
+// ============================================================
+// Autoplayer
+// ============================================================
+
+// Steers the paddle under the ball that will reach the paddle line first,
+// and detours for helpful power-ups when that can't cost the ball. Landing
+// points come from unrolling UpdateBall's flight rules in closed form, one
+// wall-to-wall segment at a time; bricks are ignored, the prediction is
+// simply redone every tick.
+
+static const float SPIN_GAIN = SPIN_ACCEL / (1.f - SPIN_DECAY); // vx gained as spin decays to 0
+static const float SPIN_TAIL = SPIN_DECAY / (1.f - SPIN_DECAY);
+
+// x after k ticks of free flight. With spin s, vx(k) = vx + G s (1 - d^k),
+// summed over ticks 1..k.
+inline float FlightX(float x, float vx, float spin, float k)
+{
+    if (spin == 0.f) return x + k * vx;
+    return x + k * vx + SPIN_GAIN * spin * (k - SPIN_TAIL * (1.f - powf(SPIN_DECAY, k)));
+}
+
+inline float FlightVX(float vx, float spin, float k)
+{
+    if (spin == 0.f) return vx;
+    return vx + SPIN_GAIN * spin * (1.f - powf(SPIN_DECAY, k));
+}
+
+// First tick in (lo, hi] at which a path that is monotone over [lo, hi]
+// and inside the walls at lo crosses one; 0 if it doesn't.
+int FirstWallTick(float x, float vx, float spin, int lo, int hi, float minX, float maxX)
+{
+    bool rising = FlightX(x, vx, spin, (float)hi) > FlightX(x, vx, spin, (float)lo);
+    auto outside = [&](int k)
+    {
+        float p = FlightX(x, vx, spin, (float)k);
+        return rising ? p > maxX : p < minX;
+    };
+
+    if (!outside(hi)) return 0;
+    while (hi - lo > 1)
+    {
+        int mid = (lo + hi) / 2;
+        if (outside(mid)) hi = mid;
+        else lo = mid;
+    }
+    return hi;
+}
+
+// Advances x/vx/spin by 'ticks' of UpdateBall's horizontal motion: spin
+// curve, and on the tick a wall is crossed the ball is put back on it with
+// vx negated.
+void FlyHorizontally(const GameState& g, float& x, float& vx, float& spin, int ticks, float r)
+{
+    const float minX = r, maxX = g.worldW - r;
+
+    for (int segment = 0; ticks > 0 && segment < 64; ++segment)
+    {
+        int hit = 0;
+        if (spin == 0.f)
+        {
+            // Straight line: the crossing tick is direct
+            if (vx < 0.f) hit = (int)((x - minX) / -vx) + 1;
+            else if (vx > 0.f) hit = (int)((maxX - x) / vx) + 1;
+            if (hit > ticks) hit = 0;
+        }
+        else
+        {
+            // Curved: split where vx turns around so each part is monotone
+            int turn = ticks;
+            float q = 1.f + vx / (SPIN_GAIN * spin); // d^k at which vx(k) == 0
+            if (q > 0.f && q < 1.f)
+            {
+                float k = logf(q) / logf(SPIN_DECAY);
+                if (k >= 1.f && k < (float)ticks) turn = (int)k;
+            }
+            hit = FirstWallTick(x, vx, spin, 0, turn, minX, maxX);
+            if (!hit && turn < ticks) hit = FirstWallTick(x, vx, spin, turn, ticks, minX, maxX);
+        }
+
+        if (!hit)
+        {
+            float k = (float)ticks;
+            x = FlightX(x, vx, spin, k);
+            vx = FlightVX(vx, spin, k);
+            if (spin != 0.f) spin *= powf(SPIN_DECAY, k);
+            return;
+        }
+
+        float k = (float)hit;
+        float vxAtHit = FlightVX(vx, spin, k);
+        x = (vxAtHit < 0.f) ? minX : maxX; // by direction: rounding can leave x right on the wall
+        vx = -vxAtHit;
+        if (spin != 0.f) spin *= powf(SPIN_DECAY, k);
+        ticks -= hit;
+    }
+}
+
+// Where and when a ball in flight gets down to lineY (the paddle top).
+// Goes up to the top wall first if it is rising.
+bool PredictLanding(const GameState& g, const Ball& b, float lineY, BallLanding& out)
+{
+    if (!b.alive || b.stuck || b.vy == 0.f) return false;
+
+    float x = b.x, vx = b.vx, spin = b.spin;
+    float y = b.y, vy = b.vy;
+    int ticks = 0;
+
+    if (vy < 0.f)
+    {
+        int up = (int)((y - b.r) / -vy) + 1; // tick the top wall is crossed
+        FlyHorizontally(g, x, vx, spin, up, b.r);
+        ticks += up;
+        y = b.r;
+        vy = -vy;
+    }
+
+    float gap = lineY - b.r - y;
+    if (gap < -g.paddle.h) return false; // already below the paddle
+    int down = (gap > 0.f) ? (int)ceilf(gap / vy) : 0;
+    FlyHorizontally(g, x, vx, spin, down, b.r);
+
+    out.x = x;
+    out.ticks = ticks + down;
+    return true;
+}
+
+// The ball that lands first, or false if none is in flight.
+bool PredictThreat(const GameState& g, BallLanding& threat)
+{
+    bool found = false;
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        BallLanding landing;
+        if (!PredictLanding(g, g.ball[i], g.paddle.y, landing)) continue;
+        landing.ball = i;
+        if (!found || landing.ticks < threat.ticks) threat = landing;
+        found = true;
+    }
+    return found;
+}
+
+// Where on the paddle (-1 .. 1) to meet a ball landing at landingX so it
+// leaves straight for the nearest brick of the lowest live row (nothing
+// below that row can block the shot). Inverts BounceAngleFactor.
+float AutoplayAimHit(const GameState& g, float landingX)
+{
+    if (g.lowestLiveRow < 0) return 0.f;
+
+    const int row = g.lowestLiveRow;
+    int target = -1;
+    float targetX = 0.f;
+    for (int c = 0; c < g.boardCols; ++c)
+    {
+        if (!BrickHits(g, row, c)) continue;
+        RECT rc = BrickRect(g, row, c);
+        float x = (rc.left + rc.right) * 0.5f;
+        if (target < 0 || fabsf(x - landingX) < fabsf(targetX - landingX)) { target = c; targetX = x; }
+    }
+    if (target < 0) return 0.f;
+
+    float dy = g.paddle.y - (float)(BrickRect(g, row, target).bottom + g.brickOffsetY);
+    float factor = Clamp(atan2f(targetX - landingX, dy) / BOUNCE_MAX_ANGLE, -1.f, 1.f);
+    float mag = fabsf(factor);
+    if (mag < BOUNCE_DEAD_ZONE * 0.25f) mag *= 4.f;
+    else mag = BOUNCE_DEAD_ZONE + sqrtf(mag) * (1.f - BOUNCE_DEAD_ZONE);
+    return copysignf(mag < 0.9f ? mag : 0.9f, factor); // keep off the very edge
+}
+
+TickInput AutoplayInput(const GameState& g)
+{
+    TickInput in;
+    in.launch = true;
+    in.restart = g.gameOver;
+
+    const float half = g.paddle.w * 0.5f;
+    const float center = g.paddle.x + half;
+    float target = center;
+
+    BallLanding threat;
+    bool haveThreat = PredictThreat(g, threat);
+    if (haveThreat && g.ball[threat.ball].vy < 0.f)
+    {
+        // Still rising: any brick may send it straight back, so wait midway
+        // between that landing and the one off the top wall
+        Ball back = g.ball[threat.ball];
+        back.vy = -back.vy;
+        BallLanding early;
+        target = PredictLanding(g, back, g.paddle.y, early) ? (threat.x + early.x) * 0.5f : threat.x;
+    }
+    else if (haveThreat)
+    {
+        // Aim if there's time to get there, otherwise just get under it
+        target = threat.x - AutoplayAimHit(g, threat.x) * half;
+        if (fabsf(target - center) > PADDLE_SPEED * threat.ticks)
+            target = Clamp(center, threat.x - 0.9f * half, threat.x + 0.9f * half);
+    }
+
+    // Detour for the earliest helpful power-up we can catch and still make it back
+    int best = -1;
+    float bestTicks = 0.f;
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+    {
+        const FallingPowerUp& pu = g.fallingPowerUps[i];
+        if (!pu.alive || !g_powerUps[pu.index].helpful) continue;
+
+        float ticks = (g.paddle.y - pu.y) / POWERUP_FALL_SPEED;
+        if (ticks < 0.f) continue;
+        float reach = PADDLE_SPEED * ticks + half;
+        if (fabsf(pu.x - center) > reach) continue;
+        if (haveThreat)
+        {
+            float back = fabsf(target - pu.x) - half;
+            if (ticks > threat.ticks || back > PADDLE_SPEED * (threat.ticks - ticks)) continue;
+        }
+        if (best < 0 || ticks < bestTicks) { best = i; bestTicks = ticks; }
+    }
+    if (best >= 0)
+        target = g.fallingPowerUps[best].x;
+
+    in.paddleMove = Clamp(target - center, -PADDLE_SPEED, PADDLE_SPEED);
+    return in;
+}
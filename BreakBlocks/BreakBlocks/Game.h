@@ -0,0 +1,560 @@
+// ============================================================
+// BreakBlocks simulation
+//
+// What a game is and how a tick advances it: the GameState, the level and
+// power-up tables, the worker pool the tools split their games across, the
+// update itself and the autoplayer. Every host (the window, the server, the
+// tools) drives games through InitGameState and UpdateGame.
+// ============================================================
+
+#pragma once
+
+#include "Platform.h"
+#include "MemoryTags.h"
+
+// ============================================================
+// Constants / Configuration
+// ============================================================
+
+static constexpr int SCREEN_W = 800;
+static constexpr int SCREEN_H = 600;
+
+static const float PADDLE_W = 100.f;
+static const float PADDLE_H = 15.f;
+static const float PADDLE_SPEED = 6.f;
+static const float MOUSE_PADDLE_SCALE = 1.f; // paddle pixels per raw mouse count
+
+static const float BALL_RADIUS = 6.f;
+static const float BALL_SPEED = 5.5f;
+static const float SPIN_ACCEL = 0.02f; // vx gained per tick per unit of spin
+static const float SPIN_DECAY = 0.995f;
+static const float MIN_BALL_SPEED = BALL_SPEED * 0.5f;
+static const float MAX_BALL_SPEED = PADDLE_H; // any faster and a ball can step over the paddle
+static constexpr int BALL_CAP = 6;
+
+static constexpr int BRICK_ROWS = 5;
+static constexpr int BRICK_COLS = 10;
+static const int BRICK_W = 70;
+static const int BRICK_H = 20;
+static const int BRICK_GAP = 6;
+
+static const float POWERUP_FALL_SPEED = 2.f;
+
+static const int TICK_HZ = 60;
+
+// Base values for reset/restoration
+static const float BASE_BALL_SPEED = BALL_SPEED;
+static const float BASE_BALL_RADIUS = BALL_RADIUS;
+
+// ============================================================
+// Math / Utility Functions
+// ============================================================
+
+float Clamp(float v, float min, float max);
+bool CircleRectIntersect(float cx, float cy, float r, const RECT& rc);
+double QpcSeconds();
+COLORREF GetBrickColor(int hits);
+
+// ============================================================
+// Paddle Bounce
+// ============================================================
+
+void InitPaddleBounceTable();
+void PaddleBounce(float hit, float& vx, float& vy);
+void PaddleBounceReference(float hit, float& vx, float& vy);
+
+// ============================================================
+// Enums / Structs
+// ============================================================
+
+struct Paddle
+{
+    float x, y, w, h;
+};
+
+struct Ball
+{
+    float x, y, vx, vy, r;
+    float prevX = 0.f, prevY = 0.f; // where this tick's move started
+    float spin = 0.f;
+	int penetrateMax = 0; // max number of bricks it can penetrate
+	int penetrateCount = 0; // number of bricks it can penetrate per hit
+	bool stuck = false;
+	bool alive = false;
+};
+
+// ============================================================
+// Game State
+// ============================================================
+
+// Bricks are one byte each, the hits left (0 = no brick); the rect follows
+// from the cell and the color from the hits. Cells are stored in
+// BRICK_TILE x BRICK_TILE tiles, row-major within a tile and tiles row-major,
+// so the cells around a ball are a few cache lines on any board size. Brick
+// indices outside the storage (brick log, wire format, telemetry) stay
+// row-major: row * boardCols + col.
+static const int BRICK_TILE_SHIFT = 3;
+static const int BRICK_TILE = 1 << BRICK_TILE_SHIFT;
+static const int MAX_BOARD_DIM = 1000; // rows or columns, stress boards
+
+struct PowerUpDef;
+
+struct ActivePowerUp
+{
+    const PowerUpDef * def = nullptr;
+    int timer = 0;
+};
+
+static constexpr int MAX_ACTIVE_POWERUPS = 10; // concurrent timed power-ups
+
+struct FallingPowerUp
+{
+    int index = -1;   // which power-up type
+    float x = 0.f;
+    float y = 0.f;
+    bool alive = false;
+};
+
+static constexpr int MAX_FALLING_POWERUPS = 20;
+
+// When set, every brick a hit changes is appended here (server deltas)
+typedef TaggedVector<int, MEM_GAME> BrickLog;
+
+struct Telemetry;
+struct ParticlePool;
+struct AudioMixer;
+
+// What watches a game: set on the GameState that is being played and never
+// read back by the simulation. A copy of a game starts unwatched and
+// assigning one keeps the target's hooks, so a what-if copy (planner,
+// fuzzer) can't report into the original's log, telemetry or effects.
+struct GameHooks
+{
+    BrickLog* brickLog = nullptr;
+    Telemetry* telemetry = nullptr;
+    ParticlePool* particles = nullptr;
+    AudioMixer* audio = nullptr;
+
+    GameHooks() {}
+    GameHooks(const GameHooks&) {}
+    GameHooks& operator=(const GameHooks&) { return *this; }
+};
+
+// Working buffers of the ball/ball collision pass. Nothing in them outlives
+// a tick that matters to the game, so like the hooks they stay with the
+// object: copies start empty and grow their own once.
+struct CollisionScratch
+{
+    TaggedVector<int, MEM_GAME> sweepOrder;  // ball slots by left edge
+    TaggedVector<float, MEM_GAME> sweepLeft; // left edge per slot; +inf if not in flight
+    TaggedVector<std::pair<int, int>, MEM_GAME> ballPairs;
+
+    CollisionScratch() {}
+    CollisionScratch(const CollisionScratch&) {}
+    CollisionScratch& operator=(const CollisionScratch&) { return *this; }
+};
+
+// Ball and brick storage. Up to N elements live in 'fixed', inside the
+// game itself, which holds the whole default board; bigger boards (stress,
+// custom packs) spill to 'heap'. StaticBoard reads 'fixed' directly, with
+// its size known at compile time, everything else goes through data().
+template<class T, size_t N, MemTag Tag>
+struct BoardArray
+{
+    std::array<T, N> fixed = {};
+    TaggedVector<T, Tag> heap;
+
+    BoardArray() : p(fixed.data()), n(0) {}
+    BoardArray(const BoardArray& o) : fixed(o.fixed), heap(o.heap), n(o.n) { Point(); }
+    BoardArray(BoardArray&& o) : fixed(o.fixed), heap(std::move(o.heap)), n(o.n)
+    {
+        Point();
+        o.n = 0;
+        o.Point();
+    }
+    BoardArray& operator=(const BoardArray& o)
+    {
+        fixed = o.fixed;
+        heap = o.heap;
+        n = o.n;
+        Point();
+        return *this;
+    }
+    BoardArray& operator=(BoardArray&& o)
+    {
+        fixed = o.fixed;
+        heap.swap(o.heap);
+        n = o.n;
+        Point();
+        o.n = 0;
+        o.Point();
+        return *this;
+    }
+
+    // A board that fits keeps whatever heap capacity it had
+    void assign(size_t count, const T& value)
+    {
+        n = count;
+        if (count <= N)
+        {
+            heap.clear();
+            std::fill(fixed.begin(), fixed.begin() + count, value);
+        }
+        else
+            heap.assign(count, value);
+        Point();
+    }
+
+    T& operator[](size_t i) { return p[i]; }
+    const T& operator[](size_t i) const { return p[i]; }
+    T* data() { return p; }
+    const T* data() const { return p; }
+    T* begin() { return p; }
+    T* end() { return p + n; }
+    const T* begin() const { return p; }
+    const T* end() const { return p + n; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    bool inlined() const { return n <= N; }
+
+    bool operator==(const BoardArray& o) const { return n == o.n && std::equal(begin(), end(), o.begin()); }
+    bool operator!=(const BoardArray& o) const { return !(*this == o); }
+
+private:
+    void Point() { p = n <= N ? fixed.data() : heap.data(); }
+
+    T* p;
+    size_t n;
+};
+
+static constexpr int BoardTiles(int cells) { return (cells + BRICK_TILE - 1) >> BRICK_TILE_SHIFT; }
+static constexpr int BRICK_SLOTS = BoardTiles(BRICK_ROWS) * BoardTiles(BRICK_COLS) * BRICK_TILE * BRICK_TILE;
+
+// Everything one game owns. The simulation works on the GameState it is
+// handed, so any number of games live side by side (server sessions, env
+// instances, planner nodes, fuzz runs) and copying one snapshots it.
+struct GameState
+{
+    Paddle paddle = {};
+    float paddleVX = 0.f;
+    float paddlePrevX = 0.f;
+    // Ball and brick storage is sized by ConfigureBoard(g); the default is
+    // BRICK_ROWS x BRICK_COLS with BALL_CAP balls, which fits inline.
+    BoardArray<Ball, BALL_CAP, MEM_GAME> ball;
+    int ballCap = 0;
+    int ballMax = 1; // current number of active balls
+    bool ballLaunched = false;
+
+    BoardArray<uint8_t, BRICK_SLOTS, MEM_GAME> brickHits; // tiled, see BrickSlot()
+    int boardTilesX = 0;
+    int boardRows = 0;
+    int boardCols = 0;
+    int boardOriginX = 0; // top-left of brick (0, 0), board space
+    int boardOriginY = 0;
+    int boardEpoch = 0; // bumped by every LayoutBoard(g)
+
+    // Brick descent: the whole board is shifted by one vertical offset
+    // instead of moving every brick. Live bricks are counted per row so the
+    // lowest live row (the only one that can reach the paddle) is known
+    // without a scan.
+    int brickOffsetY = 0;
+    int boardShiftY = 0; // how far the board came down this tick
+    int descendTimer = 0;
+    TaggedVector<int, MEM_GAME> rowLiveCount;
+    int lowestLiveRow = -1; // -1 = board cleared
+
+    // Playfield size the simulation runs in, in logical units: SCREEN_W x
+    // SCREEN_H, or larger for stress boards. It never follows the window;
+    // the render side maps it onto the window with a ViewTransform.
+    int worldW = SCREEN_W;
+    int worldH = SCREEN_H;
+
+    int score = 0;
+    int lives = 3;
+    int level = 1;
+    // Per-game random stream (xorshift32), so a seed replays a game exactly
+    // and games don't disturb each other
+    uint32_t rngState = 2463534242u;
+    bool gameOver = false;
+    bool spin = false;
+    bool stickyPaddle = false;
+    bool invulnerable = false;
+    bool levelAdvancePending = false;
+    bool ballCollisions = false; // balls bounce off each other (optional mode)
+
+    ActivePowerUp activePowerUps[MAX_ACTIVE_POWERUPS];
+    FallingPowerUp fallingPowerUps[MAX_FALLING_POWERUPS];
+
+    GameHooks hooks;
+    CollisionScratch scratch;
+};
+
+void SeedGameRand(GameState& g, uint32_t seed);
+int GameRand(GameState& g);
+int RollBrickHits(GameState& g, int level);
+
+// ============================================================
+// Board Configuration
+// ============================================================
+
+// Where cell (r, c) lives in tiled brick storage 'tilesX' tiles wide
+inline size_t BrickSlot(int r, int c, int tilesX)
+{
+    size_t tile = (size_t)(r >> BRICK_TILE_SHIFT) * tilesX + (c >> BRICK_TILE_SHIFT);
+    return (tile << (2 * BRICK_TILE_SHIFT)) |
+           ((r & (BRICK_TILE - 1)) << BRICK_TILE_SHIFT) | (c & (BRICK_TILE - 1));
+}
+
+inline size_t BrickSlot(const GameState& g, int r, int c)
+{
+    return BrickSlot(r, c, g.boardTilesX);
+}
+
+inline uint8_t& BrickHits(GameState& g, int r, int c)
+{
+    return g.brickHits[BrickSlot(g, r, c)];
+}
+
+inline uint8_t BrickHits(const GameState& g, int r, int c)
+{
+    return g.brickHits[BrickSlot(g, r, c)];
+}
+
+// By row-major brick index
+inline uint8_t& BrickHits(GameState& g, int index)
+{
+    return BrickHits(g, index / g.boardCols, index % g.boardCols);
+}
+
+inline uint8_t BrickHits(const GameState& g, int index)
+{
+    return BrickHits(g, index / g.boardCols, index % g.boardCols);
+}
+
+// Cell (r, c) in board space (before descent)
+inline RECT BrickRect(const GameState& g, int r, int c)
+{
+    int x = g.boardOriginX + c * (BRICK_W + BRICK_GAP);
+    int y = g.boardOriginY + r * (BRICK_H + BRICK_GAP);
+    RECT rc = { x, y, x + BRICK_W, y + BRICK_H };
+    return rc;
+}
+
+// Board-config policies. The per-tick ball and brick loops are templated on
+// one of these: StaticBoard has the dimensions as constants and reads the
+// inline std::array storage, so trip counts and brick slots are known at
+// compile time; RuntimeBoard reads whatever ConfigureBoard(g) set up
+// (custom packs, stress boards). Ball loops stop at ballMax (balls past it
+// are never alive), which StaticBoard also bounds by its constant cap:
+// looping to the cap outright measured slower, as most ticks have one ball.
+// BruteForceBoard is the fuzzer's reference: RuntimeBoard with the brick
+// broadphase turned off, so every pass tests every cell.
+template<int Rows, int Cols, int BallCap>
+struct StaticBoard
+{
+    static_assert(BallCap <= BALL_CAP &&
+        BoardTiles(Rows) * BoardTiles(Cols) * BRICK_TILE * BRICK_TILE <= BRICK_SLOTS,
+        "a static board must fit the inline storage");
+    static const int TILES_X = BoardTiles(Cols);
+    static const bool EVERY_CELL = false;
+
+    static constexpr int rows(const GameState&) { return Rows; }
+    static constexpr int cols(const GameState&) { return Cols; }
+    static int balls(const GameState& g) { return min(g.ballMax, BallCap); }
+    static Ball& ball(GameState& g, int i) { return g.ball.fixed[i]; }
+    static uint8_t& hits(GameState& g, int r, int c) { return g.brickHits.fixed[BrickSlot(r, c, TILES_X)]; }
+
+    static bool Matches(const GameState& g)
+    {
+        return g.boardRows == Rows && g.boardCols == Cols && g.ballCap == BallCap;
+    }
+};
+
+struct RuntimeBoard
+{
+    static const bool EVERY_CELL = false;
+    static int rows(const GameState& g) { return g.boardRows; }
+    static int cols(const GameState& g) { return g.boardCols; }
+    static int balls(const GameState& g) { return g.ballMax; }
+    static Ball& ball(GameState& g, int i) { return g.ball[i]; }
+    static uint8_t& hits(GameState& g, int r, int c) { return BrickHits(g, r, c); }
+};
+
+struct BruteForceBoard : RuntimeBoard
+{
+    static const bool EVERY_CELL = true;
+};
+
+typedef StaticBoard<BRICK_ROWS, BRICK_COLS, BALL_CAP> DefaultBoard;
+
+// ============================================================
+// Initialization
+// ============================================================
+
+void InitBall(GameState& g);
+void KillAllBalls(GameState& g);
+
+struct LevelDef
+{
+    int rows;
+    int cols;
+    int brickPattern[BRICK_ROWS][BRICK_COLS];
+
+    // Power-up rule per brick
+    // -1  = no power-up
+    //  0  = guaranteed random power-up
+    // >0  = guaranteed specific power-up index
+    int mustDropPowerUp[BRICK_ROWS][BRICK_COLS];
+
+    // Brick descent pressure
+    int descendIntervalFrames;   // 0 = no descent
+    int descendAmount;           // pixels per descent
+};
+
+extern const int g_levelCount;
+const LevelDef& CurrentLevelDef(const GameState& g);
+void InitBricksForLevel(GameState& g, int level);
+void InitGame(GameState& g);
+void InitStressGame(GameState& g, int rows, int cols, int balls);
+void InitGameState(GameState& g, uint32_t seed);
+
+// ============================================================
+// PowerUp / Effect Logic
+// ============================================================
+
+// A power-up's effect is data: rows that each change one target by an
+// operation and a magnitude. Catching it runs the rows in order; a timed
+// power-up runs them backwards when it expires, as each row's 'undo' says:
+// EFFECT_KEEP leaves the target alone, EFFECT_REVERT runs the inverse
+// operation (a scale divides back out, an add subtracts) and any other
+// value is what a set restores. New power-ups are new table rows.
+enum EffectTarget : uint8_t
+{
+    EFFECT_NONE,             // ends a row list
+    EFFECT_BALL_SPEED,       // scale, then kept within the speed limits
+    EFFECT_BALL_RADIUS,      // set, in BASE_BALL_RADIUS units
+    EFFECT_BALL_PENETRATION, // set, bricks a ball goes through per hit
+    EFFECT_BALL_COUNT,       // set, balls in play up to the cap
+    EFFECT_PADDLE_WIDTH,     // scale
+    EFFECT_SPIN,             // set, 0 or 1
+    EFFECT_STICKY,           // set, 0 or 1; clearing it launches stuck balls
+    EFFECT_INVULNERABLE,     // set, 0 or 1
+    EFFECT_LIVES,            // add
+    EFFECT_DROPS,            // add: random power-ups falling from the top
+};
+
+enum EffectOp : uint8_t
+{
+    EFFECT_SCALE,
+    EFFECT_SET,
+    EFFECT_ADD,
+};
+
+static const int MAX_EFFECT_ROWS = 2;
+
+struct EffectRow
+{
+    EffectTarget target;
+    EffectOp op;
+    float magnitude;
+    float undo; // EFFECT_KEEP, EFFECT_REVERT or, for a set, the value to restore
+};
+
+struct PowerUpDef
+{
+    const char* name;                     // For debugging / display
+    COLORREF color;                       // Display color
+    int durationFrames;                    // 0 = instant, >0 = timed
+    bool helpful;                          // the autoplayer goes for it
+    EffectRow effects[MAX_EFFECT_ROWS];    // up to the first EFFECT_NONE
+};
+
+bool HasEffect(const PowerUpDef& def, EffectTarget target);
+extern PowerUpDef g_powerUps[];
+extern const int g_powerUpCount;
+void ResetPowerUps(GameState& g);
+void SpawnPowerUp(GameState& g, float x, float y);
+void SpawnPowerUp(GameState& g, float x, float y, int index);
+void ApplyPowerUp(GameState& g, int index);
+void UpdateActivePowerUps(GameState& g);
+
+// ============================================================
+// Worker Pool
+// ============================================================
+
+// Persistent threads for splitting work. RunParallel hands out task
+// indices 0..count-1 to the workers and the calling thread, and returns when
+// all of them are done; called from inside a task it runs them inline.
+typedef void (*ParallelTask)(void* ctx, int index);
+
+extern int g_simThreads;
+void StopWorkerPool();
+void SetSimulationThreads(int threads);
+void RunParallel(ParallelTask task, void* ctx, int count);
+
+// ============================================================
+// Update / Game Logic
+// ============================================================
+
+// What one tick of input amounts to. Also the seam for headless drivers.
+struct TickInput
+{
+    float paddleMove = 0.f; // pixels, keys and mouse combined
+    bool launch = false;
+    bool restart = false;
+};
+
+// Cells whose rect can reach a ball's bounding box (board space), clipped
+// to the board; empty when c0 > c1 or r0 > r1. The whole board for
+// BruteForceBoard.
+template<class Board = RuntimeBoard>
+inline void BrickCellsNear(const GameState& g, float x, float y, float r, int& c0, int& c1, int& r0, int& r1)
+{
+    if (Board::EVERY_CELL)
+    {
+        c0 = r0 = 0;
+        c1 = Board::cols(g) - 1;
+        r1 = Board::rows(g) - 1;
+        return;
+    }
+    const float pitchX = (float)(BRICK_W + BRICK_GAP);
+    const float pitchY = (float)(BRICK_H + BRICK_GAP);
+    c0 = (int)floorf((x - r - BRICK_W - g.boardOriginX) / pitchX);
+    c1 = (int)floorf((x + r - g.boardOriginX) / pitchX);
+    r0 = (int)floorf((y - r - BRICK_H - g.boardOriginY) / pitchY);
+    r1 = (int)floorf((y + r - g.boardOriginY) / pitchY);
+    if (c0 < 0) c0 = 0;
+    if (r0 < 0) r0 = 0;
+    if (c1 > Board::cols(g) - 1) c1 = Board::cols(g) - 1;
+    if (r1 > Board::rows(g) - 1) r1 = Board::rows(g) - 1;
+}
+
+void FindBallPairs(GameState& g);
+
+// StepSimulation and UpdateGame run a game on DefaultBoard when it has the
+// default shape and on RuntimeBoard otherwise; the On forms force a policy
+// (all three are instantiated), which the bench and the fuzzer compare.
+template<class Board> void StepSimulationOn(GameState& g);
+template<class Board> void UpdateGameOn(GameState& g, const TickInput& in);
+void StepSimulation(GameState& g);
+void UpdateGame(GameState& g, const TickInput& in);
+
+// ============================================================
+// Invariants
+// ============================================================
+
+int CheckInvariants(const GameState& g, const char** what);
+
+// ============================================================
+// Autoplayer
+// ============================================================
+
+struct BallLanding
+{
+    float x;   // ball center when it reaches the paddle line
+    int ticks; // from now
+    int ball;  // ball slot (PredictThreat)
+};
+
+bool PredictThreat(const GameState& g, BallLanding& threat);
+TickInput AutoplayInput(const GameState& g);
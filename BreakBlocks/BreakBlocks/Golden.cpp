@@ -0,0 +1,666 @@
+#include "Tools.h"
+#ifdef __linux__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// ============================================================
+// Golden Traces (breakblocks --golden record | check [corpus])
+// ============================================================
+
+// A corpus of seeded sessions recorded on a trusted build: how each one was
+// set up, the input it got every tick, and the state after every tick.
+// Checking replays the inputs on this build and stops each session at the
+// first tick that comes out differently, naming the fields, so a change
+// meant to be faster can show it hasn't changed a game.
+//
+// A tick stores a 32-bit hash of the whole state, which finds the
+// divergence, and 8 bits per field, only read once it is found. Tolerance
+// mode (check with a tolerance > 0) passes paddle and ball floats that have
+// drifted by no more than the tolerance, for an approved change of
+// arithmetic; the tick stores those floats as well. Everything else, and
+// every float once the drift turns into a different game, still has to
+// match exactly.
+//
+// The corpus is a flat file in the machine's byte order (little-endian on
+// every target this builds for). Sessions are checked in parallel by forked
+// workers on Linux, serially elsewhere.
+//
+// The reference corpus is committed as golden/breakblocks.bbg, recorded
+// with the defaults in Tools.h, and both modes default to it (paths are relative
+// to this directory, the project's working directory). Any change to the
+// simulation runs
+//   breakblocks --golden check        (BreakBlocks.exe /golden)
+// before it goes in. A change that is meant to alter games records the
+// corpus again, on a build that has been played and trusted, and commits
+// it with the change. Corpora recorded anywhere else are scratch and are
+// not committed.
+
+enum GoldenField
+{
+    GOLDEN_PADDLE,
+    GOLDEN_PADDLE_SIZE,
+    GOLDEN_BALL_COUNT,
+    GOLDEN_BALL_FLAGS,
+    GOLDEN_BALL_POSITION,
+    GOLDEN_BALL_VELOCITY,
+    GOLDEN_BALL_SIZE,
+    GOLDEN_BOARD_EPOCH,
+    GOLDEN_BRICKS,
+    GOLDEN_DESCENT,
+    GOLDEN_ROW_COUNTS,
+    GOLDEN_SCORE,
+    GOLDEN_LIVES_LEVEL,
+    GOLDEN_RNG,
+    GOLDEN_POWERUP_FLAGS,
+    GOLDEN_ACTIVE_POWERUPS,
+    GOLDEN_FALLING_POWERUPS,
+    GOLDEN_FIELDS
+};
+
+struct GoldenFieldDef
+{
+    const char* name;
+    bool floats; // may drift in tolerance mode
+};
+
+static const GoldenFieldDef g_goldenFields[GOLDEN_FIELDS] =
+{
+    { "paddle position", true },
+    { "paddle size", false },
+    { "ball count", false },
+    { "ball alive/stuck", false },
+    { "ball position", true },
+    { "ball velocity", true },
+    { "ball radius/penetration", false },
+    { "board epoch", false },
+    { "brick", false },
+    { "descent", false },
+    { "row counts", false },
+    { "score", false },
+    { "lives/level", false },
+    { "rng", false },
+    { "power-up flags", false },
+    { "active power-up", false },
+    { "falling power-up", false },
+};
+
+static const uint32_t GOLDEN_MAGIC = 0x54474242; // "BBGT"
+static const uint32_t GOLDEN_VERSION = 1;
+static const int GOLDEN_PADDLE_FLOATS = 3; // x, vx, prevX
+static const int GOLDEN_BALL_FLOATS = 7;   // x, y, prevX, prevY, vx, vy, spin
+
+struct GoldenFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t fields; // GOLDEN_FIELDS when recorded
+    uint32_t sessions;
+};
+
+// A stress board when rows > 0, the default board at 'level' otherwise.
+// 'bytes' of tick records follow it in the file.
+struct GoldenSession
+{
+    uint32_t seed;
+    int32_t level;
+    int32_t rows, cols, balls;
+    uint32_t ballCollisions;
+    uint32_t ticks;
+    uint32_t bytes;
+};
+
+// What a tick is compared on
+struct GoldenTick
+{
+    uint32_t hash;
+    uint8_t field[GOLDEN_FIELDS];
+    std::vector<float> values; // paddle, then each live ball
+};
+
+struct Fnv
+{
+    uint32_t h = 2166136261u;
+
+    void Mix(const void* p, size_t n)
+    {
+        const unsigned char* bytes = (const unsigned char*)p;
+        for (size_t i = 0; i < n; ++i) { h ^= bytes[i]; h *= 16777619u; }
+    }
+    template<class T> void Add(const T& v) { Mix(&v, sizeof(v)); }
+};
+
+// Hashes 'g' field by field, member by member (never padding).
+// Active power-ups hash their table index, not the pointer.
+void CaptureGoldenTick(const GameState& g, GoldenTick& t)
+{
+    Fnv f[GOLDEN_FIELDS];
+    f[GOLDEN_PADDLE].Add(g.paddle.x);
+    f[GOLDEN_PADDLE].Add(g.paddleVX);
+    f[GOLDEN_PADDLE].Add(g.paddlePrevX);
+    f[GOLDEN_PADDLE_SIZE].Add(g.paddle.y);
+    f[GOLDEN_PADDLE_SIZE].Add(g.paddle.w);
+    f[GOLDEN_PADDLE_SIZE].Add(g.paddle.h);
+
+    t.values.clear();
+    t.values.push_back(g.paddle.x);
+    t.values.push_back(g.paddleVX);
+    t.values.push_back(g.paddlePrevX);
+
+    f[GOLDEN_BALL_COUNT].Add(g.ballCap);
+    f[GOLDEN_BALL_COUNT].Add(g.ballMax);
+    f[GOLDEN_BALL_COUNT].Add(g.ballLaunched);
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        const Ball& b = g.ball[i];
+        f[GOLDEN_BALL_FLAGS].Add(b.alive);
+        f[GOLDEN_BALL_FLAGS].Add(b.stuck);
+        if (!b.alive) continue;
+        const float position[] = { b.x, b.y, b.prevX, b.prevY };
+        const float velocity[] = { b.vx, b.vy, b.spin };
+        f[GOLDEN_BALL_POSITION].Add(position);
+        f[GOLDEN_BALL_VELOCITY].Add(velocity);
+        f[GOLDEN_BALL_SIZE].Add(b.r);
+        f[GOLDEN_BALL_SIZE].Add(b.penetrateMax);
+        f[GOLDEN_BALL_SIZE].Add(b.penetrateCount);
+        t.values.insert(t.values.end(), position, position + 4);
+        t.values.insert(t.values.end(), velocity, velocity + 3);
+    }
+
+    f[GOLDEN_BOARD_EPOCH].Add(g.boardEpoch);
+    f[GOLDEN_BRICKS].Add(g.boardTilesX);
+    f[GOLDEN_BRICKS].Mix(g.brickHits.data(), g.brickHits.size());
+    f[GOLDEN_DESCENT].Add(g.brickOffsetY);
+    f[GOLDEN_DESCENT].Add(g.descendTimer);
+    f[GOLDEN_ROW_COUNTS].Mix(g.rowLiveCount.data(), g.rowLiveCount.size() * sizeof(int));
+    f[GOLDEN_ROW_COUNTS].Add(g.lowestLiveRow);
+
+    f[GOLDEN_SCORE].Add(g.score);
+    f[GOLDEN_LIVES_LEVEL].Add(g.lives);
+    f[GOLDEN_LIVES_LEVEL].Add(g.level);
+    f[GOLDEN_LIVES_LEVEL].Add(g.gameOver);
+    f[GOLDEN_LIVES_LEVEL].Add(g.levelAdvancePending);
+    f[GOLDEN_RNG].Add(g.rngState);
+    f[GOLDEN_POWERUP_FLAGS].Add(g.spin);
+    f[GOLDEN_POWERUP_FLAGS].Add(g.stickyPaddle);
+    f[GOLDEN_POWERUP_FLAGS].Add(g.invulnerable);
+    f[GOLDEN_POWERUP_FLAGS].Add(g.ballCollisions);
+
+    for (int i = 0; i < MAX_ACTIVE_POWERUPS; ++i)
+    {
+        const ActivePowerUp& pu = g.activePowerUps[i];
+        int index = pu.def ? (int)(pu.def - g_powerUps) : -1;
+        f[GOLDEN_ACTIVE_POWERUPS].Add(index);
+        f[GOLDEN_ACTIVE_POWERUPS].Add(pu.timer);
+    }
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+    {
+        const FallingPowerUp& pu = g.fallingPowerUps[i];
+        f[GOLDEN_FALLING_POWERUPS].Add(pu.alive);
+        if (!pu.alive) continue;
+        f[GOLDEN_FALLING_POWERUPS].Add(pu.index);
+        f[GOLDEN_FALLING_POWERUPS].Add(pu.x);
+        f[GOLDEN_FALLING_POWERUPS].Add(pu.y);
+    }
+
+    Fnv all;
+    for (int i = 0; i < GOLDEN_FIELDS; ++i)
+    {
+        all.Add(f[i].h);
+        t.field[i] = (uint8_t)(f[i].h ^ (f[i].h >> 8) ^ (f[i].h >> 16) ^ (f[i].h >> 24));
+    }
+    t.hash = all.h;
+}
+
+// Tick records are packed: input, hash, field bytes, float count, floats
+template<class T>
+inline void PutGolden(std::vector<uint8_t>& out, const T& v)
+{
+    const uint8_t* p = (const uint8_t*)&v;
+    out.insert(out.end(), p, p + sizeof(v));
+}
+
+template<class T>
+inline bool GetGolden(const uint8_t*& p, const uint8_t* end, T& v)
+{
+    if ((size_t)(end - p) < sizeof(v)) return false;
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return true;
+}
+
+// From a blank GameState, so that nothing carries over from the session
+// before (the board epoch counts up across games) and sessions can be
+// checked in any order
+void StartGoldenSession(GameState& g, const GoldenSession& s)
+{
+    g = GameState();
+    SeedGameRand(g, s.seed);
+    if (s.rows > 0)
+        InitStressGame(g, s.rows, s.cols, s.balls);
+    else
+    {
+        InitGame(g);
+        if (s.level > 1)
+        {
+            g.level = s.level;
+            InitBricksForLevel(g, g.level);
+        }
+    }
+    g.ballCollisions = s.ballCollisions != 0;
+}
+
+// Session i of a corpus cycles through GOLDEN_KINDS kinds: the default
+// board on every level, with and without ball collisions, and stress boards
+// of every size up to 12x24 with up to 8 balls, with and without. Sessions
+// past level 1 run GOLDEN_DESCENT_TICKS times as long, so that the board
+// comes down (every 480 ticks of play), and every GOLDEN_LONG_EVERY-th is
+// played GOLDEN_LONG_TICKS times as long, long enough to clear level 1 and
+// go on to level 2.
+static const int GOLDEN_KINDS = 4;
+static const int GOLDEN_DESCENT_TICKS = 2;
+static const int GOLDEN_LONG_EVERY = 64;
+static const int GOLDEN_LONG_TICKS = 20;
+
+GoldenSession MakeGoldenSession(int i, uint32_t seed, int ticks)
+{
+    GoldenSession s = {};
+    s.seed = seed + (uint32_t)i;
+    s.level = 1;
+    s.ticks = (uint32_t)ticks;
+    const int round = i / GOLDEN_KINDS;
+    switch (i % GOLDEN_KINDS)
+    {
+    case 0:
+    case 1:
+        s.level = 1 + round % g_levelCount;
+        s.ballCollisions = i % 2;
+        break;
+    case 2:
+    case 3:
+        s.rows = 4 + round % 9;
+        s.cols = 8 + round % 17;
+        s.balls = 1 + round % 8;
+        s.ballCollisions = i % 2;
+        break;
+    }
+    if (s.level > 1) s.ticks *= GOLDEN_DESCENT_TICKS;
+    if (i % GOLDEN_LONG_EVERY == 0) s.ticks *= GOLDEN_LONG_TICKS;
+    return s;
+}
+
+// The autoplayer, with stretches of random input so that sessions also miss
+// balls, lose games and restart
+TickInput GoldenInput(const GameState& g, uint32_t& noise, int& sloppy)
+{
+    auto next = [&noise]()
+    {
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        return noise;
+    };
+    if (sloppy == 0 && next() % 200 == 0) sloppy = 20 + (int)(next() % 100);
+    if (sloppy == 0) return AutoplayInput(g);
+
+    sloppy--;
+    TickInput in;
+    in.paddleMove = ((int)(next() % 17) - 8) * (PADDLE_SPEED / 8.f);
+    in.launch = next() % 8 == 0;
+    in.restart = g.gameOver;
+    return in;
+}
+
+// What the recorded sessions went through, so a corpus can be seen to
+// cover what it is meant to: sessions that did each at least once
+struct GoldenCoverage
+{
+    int level2 = 0, descended = 0, cleared = 0, lostBall = 0, gameOver = 0, collisions = 0, stress = 0;
+};
+
+void RecordGoldenSession(GoldenSession& s, std::vector<uint8_t>& out, GoldenCoverage& cover)
+{
+    GameState g;
+    StartGoldenSession(g, s);
+    uint32_t noise = s.seed * 2654435761u | 1;
+    int sloppy = 0;
+    size_t start = out.size();
+    GoldenTick tick;
+    bool level2 = false, descended = false, cleared = false, lostBall = false, gameOver = false;
+
+    for (uint32_t t = 0; t < s.ticks; ++t)
+    {
+        TickInput in = GoldenInput(g, noise, sloppy);
+        const int level = g.level, lives = g.lives;
+        UpdateGame(g, in);
+        CaptureGoldenTick(g, tick);
+        level2 |= g.level >= 2;
+        descended |= g.boardShiftY > 0;
+        cleared |= g.level > level;
+        lostBall |= g.lives < lives;
+        gameOver |= g.gameOver;
+
+        uint8_t buttons = (in.launch ? 1 : 0) | (in.restart ? 2 : 0);
+        uint16_t count = (uint16_t)tick.values.size();
+        PutGolden(out, in.paddleMove);
+        PutGolden(out, buttons);
+        PutGolden(out, tick.hash);
+        out.insert(out.end(), tick.field, tick.field + GOLDEN_FIELDS);
+        PutGolden(out, count);
+        for (float v : tick.values) PutGolden(out, v);
+    }
+    s.bytes = (uint32_t)(out.size() - start);
+    cover.level2 += level2;
+    cover.descended += descended;
+    cover.cleared += cleared;
+    cover.lostBall += lostBall;
+    cover.gameOver += gameOver;
+    cover.collisions += s.ballCollisions != 0;
+    cover.stress += s.rows > 0;
+}
+
+// How a session's check came out; plain data, so forked workers can send it
+// back through a pipe
+struct GoldenResult
+{
+    int32_t session;
+    int32_t tick;      // first divergent tick, 1-based; 0 = replayed exactly (or within tolerance)
+    int32_t field;     // first divergent field, or -1 if the tick record was unreadable
+    int32_t others;    // further fields divergent on that tick
+    float drift;       // tolerance mode: largest float difference accepted
+    int32_t driftField;
+};
+
+// Largest difference in a float field between the recorded values and the
+// replayed ones (laid out as CaptureGoldenTick stores them)
+float GoldenDrift(int field, const uint8_t* recorded, const std::vector<float>& now)
+{
+    auto diff = [&](size_t i)
+    {
+        float v;
+        memcpy(&v, recorded + i * sizeof(float), sizeof(float));
+        return fabsf(v - now[i]);
+    };
+
+    float worst = 0.f;
+    if (field == GOLDEN_PADDLE)
+    {
+        for (int i = 0; i < GOLDEN_PADDLE_FLOATS; ++i) worst = max(worst, diff(i));
+        return worst;
+    }
+    int from = (field == GOLDEN_BALL_POSITION) ? 0 : 4; // x, y, prevX, prevY | vx, vy, spin
+    int to = (field == GOLDEN_BALL_POSITION) ? 4 : GOLDEN_BALL_FLOATS;
+    for (size_t ball = GOLDEN_PADDLE_FLOATS; ball + GOLDEN_BALL_FLOATS <= now.size(); ball += GOLDEN_BALL_FLOATS)
+        for (int i = from; i < to; ++i) worst = max(worst, diff(ball + i));
+    return worst;
+}
+
+GoldenResult CheckGoldenSession(int index, const GoldenSession& s, const uint8_t* p, float tolerance)
+{
+    GoldenResult r = { index, 0, -1, 0, 0.f, -1 };
+    const uint8_t* end = p + s.bytes;
+    GameState g;
+    StartGoldenSession(g, s);
+    GoldenTick now;
+    uint8_t recorded[GOLDEN_FIELDS];
+
+    for (uint32_t t = 1; t <= s.ticks; ++t)
+    {
+        TickInput in;
+        uint8_t buttons = 0;
+        uint32_t hash = 0;
+        uint16_t count = 0;
+        if (!GetGolden(p, end, in.paddleMove) || !GetGolden(p, end, buttons) || !GetGolden(p, end, hash) ||
+            (size_t)(end - p) < GOLDEN_FIELDS)
+        {
+            r.tick = (int)t;
+            return r;
+        }
+        memcpy(recorded, p, GOLDEN_FIELDS);
+        p += GOLDEN_FIELDS;
+        if (!GetGolden(p, end, count) || (size_t)(end - p) < count * sizeof(float))
+        {
+            r.tick = (int)t;
+            return r;
+        }
+        const uint8_t* values = p;
+        p += count * sizeof(float);
+
+        in.launch = (buttons & 1) != 0;
+        in.restart = (buttons & 2) != 0;
+        UpdateGame(g, in);
+        CaptureGoldenTick(g, now);
+        if (now.hash == hash) continue;
+
+        // Which fields; floats within the tolerance don't count
+        int first = -1, others = 0;
+        for (int f = 0; f < GOLDEN_FIELDS; ++f)
+        {
+            if (now.field[f] == recorded[f]) continue;
+            if (tolerance > 0.f && g_goldenFields[f].floats && count == now.values.size())
+            {
+                float worst = GoldenDrift(f, values, now.values);
+                if (worst <= tolerance)
+                {
+                    if (worst > r.drift) { r.drift = worst; r.driftField = f; }
+                    continue;
+                }
+            }
+            if (first < 0) first = f;
+            else others++;
+        }
+        // A different whole-state hash with every field byte agreeing is a
+        // field byte collision; the state still differs
+        if (first < 0 && tolerance <= 0.f) first = GOLDEN_FIELDS;
+        if (first >= 0)
+        {
+            r.tick = (int)t;
+            r.field = first;
+            r.others = others;
+            return r;
+        }
+    }
+    return r;
+}
+
+const char* GoldenFieldName(int field)
+{
+    if (field < 0) return "a truncated tick record";
+    return field < GOLDEN_FIELDS ? g_goldenFields[field].name : "the state hash alone";
+}
+
+void DescribeGoldenSession(const GoldenSession& s, char* buf, size_t size)
+{
+    if (s.rows > 0)
+        sprintf_s(buf, size, "seed %u, %dx%d stress board, %d balls%s", s.seed, s.rows, s.cols, s.balls,
+            s.ballCollisions ? ", ball collisions" : "");
+    else
+        sprintf_s(buf, size, "seed %u, level %d%s", s.seed, s.level, s.ballCollisions ? ", ball collisions" : "");
+}
+
+// 'sessions' sessions of at least 'ticks' ticks, from seed onward
+int RunGoldenRecord(const char* path, int sessions, int ticks, uint32_t seed)
+{
+    bool ownConsole = OpenConsole();
+    if (sessions <= 0) sessions = GOLDEN_SESSIONS;
+    if (ticks <= 0) ticks = GOLDEN_TICKS;
+    printf("golden: recording %d sessions of %d ticks or more from seed %u into %s\n", sessions, ticks, seed, path);
+
+    const double start = QpcSeconds();
+    std::vector<GoldenSession> headers(sessions);
+    std::vector<std::vector<uint8_t>> records(sessions);
+    GoldenCoverage cover;
+    for (int i = 0; i < sessions; ++i)
+    {
+        headers[i] = MakeGoldenSession(i, seed, ticks);
+        RecordGoldenSession(headers[i], records[i], cover);
+    }
+    printf("  %d on stress boards, %d with ball collisions; %d reached level 2, %d descended, %d cleared a level,\n"
+           "  %d lost a ball, %d ended a game\n",
+        cover.stress, cover.collisions, cover.level2, cover.descended, cover.cleared, cover.lostBall, cover.gameOver);
+
+    FILE* f = NULL;
+    int result = 1;
+    if (fopen_s(&f, path, "wb") == 0 && f)
+    {
+        GoldenFileHeader header = { GOLDEN_MAGIC, GOLDEN_VERSION, GOLDEN_FIELDS, (uint32_t)sessions };
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+        size_t bytes = sizeof(header);
+        for (int i = 0; ok && i < sessions; ++i)
+        {
+            ok = fwrite(&headers[i], sizeof(GoldenSession), 1, f) == 1 &&
+                 fwrite(records[i].data(), 1, records[i].size(), f) == records[i].size();
+            bytes += sizeof(GoldenSession) + records[i].size();
+        }
+        ok = (fclose(f) == 0) && ok;
+        if (ok)
+        {
+            printf("%d sessions, %.1f MB in %.1f s\n", sessions, bytes / 1e6, QpcSeconds() - start);
+            result = 0;
+        }
+    }
+    if (result) printf("  couldn't write %s\n", path);
+
+    CloseConsole(ownConsole);
+    return result;
+}
+
+// Replays the corpus at 'path'; tolerance 0 is bit-exact
+int RunGoldenCheck(const char* path, float tolerance)
+{
+    bool ownConsole = OpenConsole();
+    std::vector<uint8_t> file;
+    FILE* f = NULL;
+    if (fopen_s(&f, path, "rb") == 0 && f)
+    {
+        uint8_t chunk[65536];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) file.insert(file.end(), chunk, chunk + n);
+        fclose(f);
+    }
+
+    GoldenFileHeader header = {};
+    const uint8_t* p = file.data();
+    const uint8_t* end = p + file.size();
+    if (!GetGolden(p, end, header) || header.magic != GOLDEN_MAGIC || header.version != GOLDEN_VERSION)
+    {
+        printf("golden: %s is not a golden trace corpus\n", path);
+        CloseConsole(ownConsole);
+        return 1;
+    }
+    if (header.fields != GOLDEN_FIELDS)
+    {
+        printf("golden: %s was recorded with %u state fields, this build hashes %d; record it again\n",
+            path, header.fields, GOLDEN_FIELDS);
+        CloseConsole(ownConsole);
+        return 1;
+    }
+
+    // Index the sessions; a short file keeps the sessions that are whole
+    std::vector<GoldenSession> sessions;
+    std::vector<const uint8_t*> records;
+    for (uint32_t i = 0; i < header.sessions; ++i)
+    {
+        GoldenSession s;
+        if (!GetGolden(p, end, s) || (size_t)(end - p) < s.bytes) break;
+        sessions.push_back(s);
+        records.push_back(p);
+        p += s.bytes;
+    }
+    const int count = (int)sessions.size();
+    uint64_t ticks = 0;
+    for (const GoldenSession& s : sessions) ticks += s.ticks;
+
+    int workers = 1;
+#ifdef __linux__
+    workers = (int)min((unsigned)max(count, 1), max(1u, std::thread::hardware_concurrency()));
+#endif
+    if (tolerance > 0.f)
+        printf("golden: %d sessions, %llu ticks from %s, floats within %g\n", count, (unsigned long long)ticks, path, tolerance);
+    else
+        printf("golden: %d sessions, %llu ticks from %s, bit-exact\n", count, (unsigned long long)ticks, path);
+    fflush(stdout);
+
+    const double start = QpcSeconds();
+    std::vector<GoldenResult> results(count);
+    std::vector<char> done(count, 0);
+    if (workers <= 1)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            results[i] = CheckGoldenSession(i, sessions[i], records[i], tolerance);
+            done[i] = 1;
+        }
+    }
+#ifdef __linux__
+    else
+    {
+        // Worker k checks sessions k, k + workers, ... and writes a result per
+        // session down its pipe. A worker that crashes leaves its remaining
+        // sessions without results, and they are reported as such.
+        std::vector<int> pipes(workers, -1);
+        std::vector<pid_t> pids(workers, -1);
+        for (int k = 0; k < workers; ++k)
+        {
+            int fds[2];
+            if (pipe(fds) != 0) break;
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                close(fds[0]);
+                for (int i = k; i < count; i += workers)
+                {
+                    GoldenResult r = CheckGoldenSession(i, sessions[i], records[i], tolerance);
+                    if (write(fds[1], &r, sizeof(r)) != (ssize_t)sizeof(r)) break;
+                }
+                _exit(0);
+            }
+            close(fds[1]);
+            if (pid < 0) { close(fds[0]); break; }
+            pipes[k] = fds[0];
+            pids[k] = pid;
+        }
+        for (int k = 0; k < workers; ++k)
+        {
+            if (pipes[k] < 0) continue;
+            GoldenResult r;
+            while (read(pipes[k], &r, sizeof(r)) == (ssize_t)sizeof(r))
+                if (r.session >= 0 && r.session < count) { results[r.session] = r; done[r.session] = 1; }
+            close(pipes[k]);
+            waitpid(pids[k], NULL, 0);
+        }
+    }
+#endif
+    const double elapsed = QpcSeconds() - start;
+
+    int diverged = 0, missing = 0;
+    float drift = 0.f;
+    int driftField = -1;
+    char what[96];
+    for (int i = 0; i < count; ++i)
+    {
+        DescribeGoldenSession(sessions[i], what, sizeof(what));
+        if (!done[i])
+        {
+            if (missing++ < 20) printf("  session %d (%s): no result, its worker died\n", i, what);
+            continue;
+        }
+        const GoldenResult& r = results[i];
+        if (r.drift > drift) { drift = r.drift; driftField = r.driftField; }
+        if (r.tick == 0) continue;
+        if (diverged++ < 20)
+        {
+            printf("  session %d (%s): tick %d diverges in %s", i, what, r.tick, GoldenFieldName(r.field));
+            if (r.others) printf(" and %d more field%s", r.others, r.others > 1 ? "s" : "");
+            printf("\n");
+        }
+    }
+    if (tolerance > 0.f && driftField >= 0)
+        printf("  largest accepted drift: %g in %s\n", drift, g_goldenFields[driftField].name);
+    printf("%d of %d sessions diverged%s in %.2f s (%d worker%s, %.1f M ticks/s)\n", diverged, count,
+        missing ? ", some unchecked" : "", elapsed, workers, workers > 1 ? "s" : "",
+        elapsed > 0.0 ? ticks / elapsed / 1e6 : 0.0);
+
+    CloseConsole(ownConsole);
+    return (diverged || missing || count == 0) ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+#include "MemoryTags.h"
+#ifdef _WIN32
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib") // GetProcessMemoryInfo
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// ============================================================
+// Memory
+// ============================================================
+
+const char* const MEM_TAG_NAMES[MEM_TAGS] =
+{
+    "game", "telemetry", "scores", "particles", "audio", "render", "export", "server",
+    "env", "planner", "threads",
+};
+
+MemCounters g_mem[MEM_TAGS];
+std::atomic<uint64_t> g_allocCount{ 0 };
+
+inline void RaiseTo(std::atomic<int64_t>& peak, int64_t value)
+{
+    int64_t was = peak.load(std::memory_order_relaxed);
+    while (value > was && !peak.compare_exchange_weak(was, value, std::memory_order_relaxed)) {}
+}
+
+void* MemAlloc(MemTag tag, size_t bytes)
+{
+    void* p = ::operator new(bytes);
+    MemCounters& m = g_mem[tag];
+    RaiseTo(m.peak, m.bytes.fetch_add((int64_t)bytes, std::memory_order_relaxed) + (int64_t)bytes);
+    m.allocs.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+void MemFree(MemTag tag, void* p, size_t bytes)
+{
+    if (!p) return;
+    MemCounters& m = g_mem[tag];
+    m.bytes.fetch_sub((int64_t)bytes, std::memory_order_relaxed);
+    m.frees.fetch_add(1, std::memory_order_relaxed);
+    ::operator delete(p);
+}
+
+#if !defined(BREAKBLOCKS_LIBRARY) && !defined(BREAKBLOCKS_FUZZER)
+// Counted global allocation. Not in the library, where it would replace
+// the host process's operator new, nor under libFuzzer's sanitizers.
+void* operator new(size_t n)
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // free() of what our operator new malloc'd
+#endif
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#ifdef __cpp_aligned_new
+// Over-aligned types (alignas above the default) come here under C++17
+void* operator new(size_t n, std::align_val_t align)
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    size_t a = max((size_t)align, sizeof(void*));
+#ifdef _WIN32
+    if (void* p = _aligned_malloc(n ? n : 1, a)) return p;
+#else
+    void* p = NULL;
+    if (posix_memalign(&p, a, n ? n : 1) == 0) return p;
+#endif
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n, std::align_val_t align) { return operator new(n, align); }
+#ifdef _WIN32
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+#endif
+void operator delete[](void* p, std::align_val_t align) noexcept { operator delete(p, align); }
+void operator delete(void* p, size_t, std::align_val_t align) noexcept { operator delete(p, align); }
+void operator delete[](void* p, size_t, std::align_val_t align) noexcept { operator delete(p, align); }
+#endif
+#endif
+
+// Resident set size, or 0 where unknown. Linux reads /proc/self/statm
+// with plain read() so that sampling doesn't allocate.
+size_t ResidentBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return pmc.WorkingSetSize;
+#elif defined(__linux__)
+    char buf[128];
+    int fd = open("/proc/self/statm", O_RDONLY);
+    if (fd < 0) return 0;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buf[n] = 0;
+    char* p = buf;
+    strtoul(p, &p, 10);                   // total program size
+    unsigned long pages = strtoul(p, NULL, 10); // resident
+    return (size_t)pages * (size_t)sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+std::atomic<size_t> g_rssBytes{ 0 };
+std::atomic<size_t> g_rssPeak{ 0 };
+
+struct RssSampler
+{
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool quit = false;
+};
+
+static RssSampler g_rssSampler;
+
+void SampleResident()
+{
+    size_t now = ResidentBytes();
+    g_rssBytes.store(now, std::memory_order_relaxed);
+    size_t was = g_rssPeak.load(std::memory_order_relaxed);
+    while (now > was && !g_rssPeak.compare_exchange_weak(was, now, std::memory_order_relaxed)) {}
+}
+
+// Samples the resident set every 'seconds' on a thread of its own until
+// StopRssSampler
+void StartRssSampler(double seconds)
+{
+    RssSampler& s = g_rssSampler;
+    if (s.thread.joinable()) return;
+    SampleResident();
+    s.quit = false;
+    s.thread = std::thread([seconds]()
+    {
+        RssSampler& s = g_rssSampler;
+        std::unique_lock<std::mutex> hold(s.lock);
+        while (!s.wake.wait_for(hold, std::chrono::duration<double>(seconds), [&s] { return s.quit; }))
+            SampleResident();
+    });
+}
+
+void StopRssSampler()
+{
+    RssSampler& s = g_rssSampler;
+    if (!s.thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> hold(s.lock);
+        s.quit = true;
+    }
+    s.wake.notify_one();
+    s.thread.join();
+}
+
+uint64_t TaggedAllocations()
+{
+    uint64_t n = 0;
+    for (int i = 0; i < MEM_TAGS; ++i) n += g_mem[i].allocs.load(std::memory_order_relaxed);
+    return n;
+}
+
+// The counters as one JSON object, with the resident set as of now
+void WriteMemoryJson(FILE* f)
+{
+    SampleResident();
+    uint64_t all = g_allocCount.load(std::memory_order_relaxed), tagged = TaggedAllocations();
+    fprintf(f, "{\n  \"rss_bytes\": %zu,\n  \"rss_peak_bytes\": %zu,\n",
+        g_rssBytes.load(std::memory_order_relaxed), g_rssPeak.load(std::memory_order_relaxed));
+    fprintf(f, "  \"allocations\": %llu,\n  \"untagged_allocations\": %llu,\n  \"tags\": {\n",
+        (unsigned long long)all, (unsigned long long)(all > tagged ? all - tagged : 0));
+    for (int i = 0; i < MEM_TAGS; ++i)
+    {
+        const MemCounters& m = g_mem[i];
+        fprintf(f, "    \"%s\": { \"bytes\": %lld, \"peak_bytes\": %lld, \"allocations\": %llu, \"frees\": %llu }%s\n",
+            MEM_TAG_NAMES[i], (long long)m.bytes.load(std::memory_order_relaxed),
+            (long long)m.peak.load(std::memory_order_relaxed),
+            (unsigned long long)m.allocs.load(std::memory_order_relaxed),
+            (unsigned long long)m.frees.load(std::memory_order_relaxed), i + 1 < MEM_TAGS ? "," : "");
+    }
+    fprintf(f, "  }\n}\n");
+}
+
+bool WriteMemoryJson(const char* path)
+{
+    FILE* f = NULL;
+    if (fopen_s(&f, path, "w") != 0 || !f) return false;
+    WriteMemoryJson(f);
+    return fclose(f) == 0;
+}
@@ -0,0 +1,90 @@
+// ============================================================
+// BreakBlocks memory accounting
+//
+// Where the process's memory goes. Subsystems allocate through tags: their
+// containers use TaggedAllocator (or TaggedVector), and whole objects like
+// pools go through MemAlloc/MemFree, so each tag keeps live bytes, a
+// high-water mark and allocation counts. Everything else still shows up in
+// g_allocCount, which the replaced operator new bumps for every allocation
+// in the process; the steady-state benchmark uses it to prove that ticks
+// don't allocate. Counters are relaxed atomics: any thread may allocate.
+// The resident set is sampled by StartRssSampler.
+// ============================================================
+
+#pragma once
+
+#include "Platform.h"
+
+enum MemTag
+{
+    MEM_GAME,      // balls, bricks, row counts, collision scratch (GameStates)
+    MEM_TELEMETRY,
+    MEM_SCORES,
+    MEM_PARTICLES,
+    MEM_AUDIO,
+    MEM_RENDER,    // render snapshots
+    MEM_EXPORT,    // frame export buffers
+    MEM_SERVER,
+    MEM_ENV,       // vectorized environment
+    MEM_PLANNER,
+    MEM_THREADS,   // worker pool thread handles
+    MEM_TAGS
+};
+
+extern const char* const MEM_TAG_NAMES[MEM_TAGS];
+
+struct MemCounters
+{
+    std::atomic<int64_t> bytes{ 0 };
+    std::atomic<int64_t> peak{ 0 };
+    std::atomic<uint64_t> allocs{ 0 };
+    std::atomic<uint64_t> frees{ 0 };
+};
+
+extern MemCounters g_mem[MEM_TAGS];
+extern std::atomic<uint64_t> g_allocCount; // every operator new in the process, tagged or not
+
+void* MemAlloc(MemTag tag, size_t bytes);
+void MemFree(MemTag tag, void* p, size_t bytes);
+
+// std::allocator for a tag; containers of the same tag compare equal, so
+// they can swap buffers
+template<class T, MemTag Tag>
+struct TaggedAllocator
+{
+    typedef T value_type;
+    template<class U> struct rebind { typedef TaggedAllocator<U, Tag> other; };
+
+    TaggedAllocator() {}
+    template<class U> TaggedAllocator(const TaggedAllocator<U, Tag>&) {}
+
+    T* allocate(size_t n) { return (T*)MemAlloc(Tag, n * sizeof(T)); }
+    void deallocate(T* p, size_t n) { MemFree(Tag, p, n * sizeof(T)); }
+};
+
+template<class T, class U, MemTag Tag>
+inline bool operator==(const TaggedAllocator<T, Tag>&, const TaggedAllocator<U, Tag>&) { return true; }
+template<class T, class U, MemTag Tag>
+inline bool operator!=(const TaggedAllocator<T, Tag>&, const TaggedAllocator<U, Tag>&) { return false; }
+
+template<class T, MemTag Tag>
+using TaggedVector = std::vector<T, TaggedAllocator<T, Tag>>;
+
+// Class-level operator new/delete for objects allocated whole under a tag
+#define MEM_TAGGED_NEW(tag) \
+    static void* operator new(size_t n) { return MemAlloc(tag, n); } \
+    static void operator delete(void* p, size_t n) { MemFree(tag, p, n); }
+
+#if !defined(BREAKBLOCKS_LIBRARY) && !defined(BREAKBLOCKS_FUZZER)
+static const bool COUNTING_ALLOCATIONS = true;
+#else
+static const bool COUNTING_ALLOCATIONS = false;
+#endif
+
+extern std::atomic<size_t> g_rssBytes;
+extern std::atomic<size_t> g_rssPeak;
+void SampleResident();
+void StartRssSampler(double seconds);
+void StopRssSampler();
+void WriteMemoryJson(FILE* f);
+bool WriteMemoryJson(const char* path);
@@ -0,0 +1,101 @@
+#include "Particles.h"
+#include <xmmintrin.h>
+
+// ============================================================
+// Particles
+// ============================================================
+
+static const float PARTICLE_GRAVITY = 0.15f;
+static const float TRAIL_SPEED = MAX_BALL_SPEED * 0.75f; // balls this fast leave a trail
+
+inline float ParticleRand(ParticlePool& p) // -1 .. 1
+{
+    p.rng ^= p.rng << 13;
+    p.rng ^= p.rng >> 17;
+    p.rng ^= p.rng << 5;
+    return (float)(p.rng >> 8) * (2.f / 16777216.f) - 1.f;
+}
+
+// 'n' particles from (x, y) at up to 'speed' in any direction, drifting
+// with (vx, vy), living 'life' ticks give or take a quarter
+void EmitParticles(ParticlePool& p, float x, float y, float vx, float vy, int n, float speed, float life, uint32_t color)
+{
+    n = min(n, PARTICLE_CAP - p.count);
+    for (int k = 0; k < n; ++k)
+    {
+        int i = p.count++;
+        p.x[i] = x;
+        p.y[i] = y;
+        p.vx[i] = vx + ParticleRand(p) * speed;
+        p.vy[i] = vy + ParticleRand(p) * speed;
+        p.life[i] = life * (1.f + 0.25f * ParticleRand(p));
+        p.color[i] = color;
+    }
+}
+
+// Scalar form of MoveParticles, kept for the benchmark to check it against
+void MoveParticlesReference(ParticlePool& p)
+{
+    for (int i = 0; i < p.count; ++i)
+    {
+        p.vy[i] += PARTICLE_GRAVITY;
+        p.x[i] += p.vx[i];
+        p.y[i] += p.vy[i];
+        p.life[i] -= 1.f;
+    }
+}
+
+void MoveParticles(ParticlePool& p)
+{
+    // Arrays run to a multiple of 4, so the last group can overrun count
+    const __m128 gravity = _mm_set1_ps(PARTICLE_GRAVITY), one = _mm_set1_ps(1.f);
+    for (int i = 0; i < p.count; i += 4)
+    {
+        __m128 vy = _mm_add_ps(_mm_load_ps(p.vy + i), gravity);
+        _mm_store_ps(p.vy + i, vy);
+        _mm_store_ps(p.x + i, _mm_add_ps(_mm_load_ps(p.x + i), _mm_load_ps(p.vx + i)));
+        _mm_store_ps(p.y + i, _mm_add_ps(_mm_load_ps(p.y + i), vy));
+        _mm_store_ps(p.life + i, _mm_sub_ps(_mm_load_ps(p.life + i), one));
+    }
+}
+
+// One tick: trails behind fast balls, motion, then dead and off-world
+// particles are swapped out with the last live one.
+void AdvanceParticles(const GameState& g, ParticlePool& p)
+{
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        const Ball& b = g.ball[i];
+        if (b.alive && !b.stuck && b.vx * b.vx + b.vy * b.vy > TRAIL_SPEED * TRAIL_SPEED)
+            EmitParticles(p, b.x, b.y, 0.f, -PARTICLE_GRAVITY * 4.f, 2, 0.3f, 8.f, 0xA0C0FF);
+    }
+
+    MoveParticles(p);
+
+    const float bottom = (float)g.worldH;
+    for (int i = 0; i < p.count;)
+    {
+        if (p.life[i] > 0.f && p.y[i] < bottom) { ++i; continue; }
+        int last = --p.count;
+        p.x[i] = p.x[last];
+        p.y[i] = p.y[last];
+        p.vx[i] = p.vx[last];
+        p.vy[i] = p.vy[last];
+        p.life[i] = p.life[last];
+        p.color[i] = p.color[last];
+    }
+}
+
+// Plots every particle as a 2x2 dot into the w x h view of a 32-bit top-down
+// pixel buffer 'pitch' pixels wide, in one pass.
+void DrawParticles(const float* x, const float* y, const uint32_t* color, int count,
+                   uint32_t* pixels, int pitch, int w, int h, const ViewTransform& view)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        int px = (int)(x[i] * view.scale) + view.x, py = (int)(y[i] * view.scale) + view.y;
+        if ((unsigned)px >= (unsigned)(w - 1) || (unsigned)py >= (unsigned)(h - 1)) continue;
+        uint32_t* row = pixels + (size_t)py * pitch + px;
+        row[0] = row[1] = row[pitch] = row[pitch + 1] = color[i];
+    }
+}
@@ -0,0 +1,78 @@
+// ============================================================
+// BreakBlocks particles
+//
+// Debris from destroyed bricks, sparks off the paddle and trails behind
+// fast balls. Purely visual: the simulation emits into a game's
+// hooks.particles when it is set (the window sets it; headless modes leave
+// it null and skip all of this) and nothing reads them back, and they draw
+// their randomness from their own stream, not GameRand. The pool is a
+// fixed-capacity struct of arrays advanced four at a time with SSE; new
+// particles past capacity are dropped rather than allocated.
+// ============================================================
+
+#pragma once
+
+#include "Game.h"
+
+static const int PARTICLE_CAP = 1 << 17;
+
+struct alignas(16) ParticlePool
+{
+    float x[PARTICLE_CAP], y[PARTICLE_CAP];
+    float vx[PARTICLE_CAP], vy[PARTICLE_CAP];
+    float life[PARTICLE_CAP];    // ticks left
+    uint32_t color[PARTICLE_CAP]; // 0x00RRGGBB, as the back buffer stores it
+    int count = 0;
+    uint32_t rng = 0x9E3779B9u;
+
+    MEM_TAGGED_NEW(MEM_PARTICLES)
+};
+
+inline uint32_t PixelColor(COLORREF c)
+{
+    return (c & 0xFF) << 16 | (c & 0xFF00) | (c >> 16 & 0xFF);
+}
+
+void EmitParticles(ParticlePool& p, float x, float y, float vx, float vy, int n, float speed, float life, uint32_t color);
+
+inline void EmitBrickDebris(const GameState& g, const RECT& rc, int hits)
+{
+    float x = (rc.left + rc.right) * 0.5f, y = (rc.top + rc.bottom) * 0.5f + g.brickOffsetY;
+    EmitParticles(*g.hooks.particles, x, y, 0.f, -1.f, 24, 3.f, 40.f, PixelColor(GetBrickColor(hits)));
+}
+
+inline void EmitPaddleSparks(const GameState& g, const Ball& b)
+{
+    EmitParticles(*g.hooks.particles, b.x, b.y + b.r, 0.f, -2.f, 12, 2.5f, 20.f, 0xFFF080);
+}
+
+void MoveParticlesReference(ParticlePool& p);
+void MoveParticles(ParticlePool& p);
+void AdvanceParticles(const GameState& g, ParticlePool& p);
+
+// World to pixels: p * scale + origin. FitView letterboxes the whole world
+// into a w x h view, centered, scaled up or down as the view needs.
+struct ViewTransform
+{
+    float scale;
+    int x, y;
+};
+
+inline ViewTransform FitView(int worldW, int worldH, int w, int h)
+{
+    ViewTransform v;
+    v.scale = min((float)w / worldW, (float)h / worldH);
+    v.x = (w - (int)(worldW * v.scale)) / 2;
+    v.y = (h - (int)(worldH * v.scale)) / 2;
+    return v;
+}
+
+// Text grows with the view (HiDPI) but never shrinks below 1:1, so the HUD
+// over a scaled-down stress board stays readable
+inline float HudScale(const ViewTransform& v)
+{
+    return max(1.f, v.scale);
+}
+
+void DrawParticles(const float* x, const float* y, const uint32_t* color, int count,
+                   uint32_t* pixels, int pitch, int w, int h, const ViewTransform& view);
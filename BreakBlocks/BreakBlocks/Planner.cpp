@@ -0,0 +1,353 @@
+#include "Tools.h"
+
+// ============================================================
+// Planner (BreakBlocks.exe /plan [rollouts per move])
+// ============================================================
+
+// Monte-Carlo tree search over paddle moves for the fewest ticks that clear
+// each level in g_levels, as a yardstick for level design. A node is a
+// whole GameState one move after its parent's. Every decision runs a budget
+// of UCT iterations from the current root, commits the most visited move
+// and keeps that child's subtree for the next one.
+//
+// Iterations go in batches: selection and backup are serial, while the new
+// children and their rollouts (the autoplayer for PLAN_ROLLOUT_TICKS) are
+// worker pool tasks, each on its own copy of the state. Batches don't depend
+// on the thread count, so neither does the plan. States live in a pool that
+// recycles freed nodes by copy-assignment, so once it is warm neither
+// cloning nor stepping allocates.
+
+static const int PLAN_STEP_TICKS = 8;               // ticks each decision holds its move
+static const int PLAN_MOVES = 3;                    // left, stay, right
+static const int PLAN_MAX_TICKS = 5 * 60 * TICK_HZ; // give up on a level after this
+static const int PLAN_ROLLOUT_TICKS = 384;
+static const int PLAN_BATCH = 16;                   // leaves per parallel batch
+static const double PLAN_EXPLORE = 0.7;
+
+struct PlanNode
+{
+    int parent = -1;
+    int child[PLAN_MOVES] = { -1, -1, -1 };
+    int8_t move = 0;      // -1, 0, 1
+    int depth = 0;        // moves from the level start
+    int visits = 0;       // including batches still in flight
+    double value = 0.0;   // sum over finished visits
+    int cleared = 0;      // tick within this move the level was cleared on
+    bool ready = false;   // state simulated
+    bool over = false;    // game over: nothing below it
+};
+
+struct PlanTask
+{
+    int node;
+    double value;
+    unsigned long long ticks;
+};
+
+struct PlanSearch
+{
+    TaggedVector<PlanNode, MEM_PLANNER> nodes;
+    TaggedVector<GameState, MEM_PLANNER> states;   // one per node
+    TaggedVector<GameState, MEM_PLANNER> rollouts; // one per batch slot
+    TaggedVector<int, MEM_PLANNER> freeNodes;
+    TaggedVector<int, MEM_PLANNER> stack;
+    TaggedVector<PlanTask, MEM_PLANNER> batch;
+    int used = 0;                      // nodes handed out since the level began
+    int level = 0, lives = 0, hits = 0; // the level's start
+    unsigned long long ticks = 0;      // simulated, for throughput
+};
+
+// Fresh game sitting at the start of 'level', ball on the paddle.
+void InitPlanLevel(GameState& g, int level, uint32_t seed)
+{
+    InitGameState(g, seed);
+    g.level = level;
+    InitBricksForLevel(g, level);
+    KillAllBalls(g);
+    InitBall(g);
+}
+
+// Runs 'count' ticks of 'move' on 'g'; returns the tick (1-based)
+// the level was cleared on, or 0.
+int PlanAdvance(GameState& g, int move, int count, int level)
+{
+    TickInput in;
+    in.paddleMove = move * PADDLE_SPEED;
+    in.launch = true;
+    for (int t = 1; t <= count; ++t)
+    {
+        UpdateGame(g, in);
+        if (g.level != level) return t;
+        if (g.gameOver) break;
+    }
+    return 0;
+}
+
+// 0 .. 1, the same scale from every node. Clearing beats any progress and
+// clearing sooner beats later; short of that, the share of the level's
+// hits removed, halved for every life lost.
+double PlanValue(const PlanSearch& ps, const GameState& g, int clearedTick)
+{
+    if (clearedTick) return 0.5 + 0.5 * (1.0 - (double)clearedTick / PLAN_MAX_TICKS);
+    if (g.gameOver) return 0.0;
+    int hits = 0;
+    for (size_t i = 0; i < g.brickHits.size(); ++i)
+        hits += g.brickHits[i];
+    return 0.5 * (1.0 - (double)hits / max(ps.hits, 1)) * ldexp(1.0, min(g.lives - ps.lives, 0));
+}
+
+int AllocPlanNode(PlanSearch& ps)
+{
+    int n;
+    if (!ps.freeNodes.empty())
+    {
+        n = ps.freeNodes.back();
+        ps.freeNodes.pop_back();
+    }
+    else
+    {
+        n = ps.used++;
+        if (n == (int)ps.nodes.size())
+        {
+            ps.nodes.push_back(PlanNode());
+            ps.states.push_back(GameState());
+        }
+    }
+    ps.nodes[n] = PlanNode();
+    return n;
+}
+
+// Frees 'root' and everything below it except 'keep'.
+void FreePlanSubtree(PlanSearch& ps, int root, int keep)
+{
+    ps.stack.clear();
+    ps.stack.push_back(root);
+    while (!ps.stack.empty())
+    {
+        int n = ps.stack.back();
+        ps.stack.pop_back();
+        for (int m = 0; m < PLAN_MOVES; ++m)
+            if (ps.nodes[n].child[m] >= 0 && ps.nodes[n].child[m] != keep)
+                ps.stack.push_back(ps.nodes[n].child[m]);
+        ps.freeNodes.push_back(n);
+    }
+}
+
+// Task: simulate the new node's move, then roll the autoplayer out from it.
+void RunPlanTask(void* ctx, int index)
+{
+    PlanSearch& ps = *(PlanSearch*)ctx;
+    PlanTask& task = ps.batch[index];
+    PlanNode& node = ps.nodes[task.node];
+    GameState& g = ps.states[task.node];
+    task.ticks = 0;
+
+    if (!node.ready)
+    {
+        g = ps.states[node.parent];
+        node.cleared = PlanAdvance(g, node.move, PLAN_STEP_TICKS, ps.level);
+        node.over = g.gameOver;
+        task.ticks += node.cleared ? node.cleared : PLAN_STEP_TICKS;
+    }
+    int at = (node.depth - 1) * PLAN_STEP_TICKS;
+    if (node.cleared || node.over)
+    {
+        task.value = PlanValue(ps, g, node.cleared ? at + node.cleared : 0);
+        return;
+    }
+
+    GameState& r = ps.rollouts[index];
+    r = g;
+    int cleared = 0;
+    for (int t = 1; t <= PLAN_ROLLOUT_TICKS && !r.gameOver; ++t)
+    {
+        UpdateGame(r, AutoplayInput(r));
+        task.ticks++;
+        if (r.level != ps.level) { cleared = at + PLAN_STEP_TICKS + t; break; }
+    }
+    task.value = PlanValue(ps, r, cleared);
+}
+
+// UCT with each node's children's means rescaled to 0 .. 1, since values
+// between siblings differ by a brick or two. Returns -1 for a node that
+// can't take another visit this batch.
+int SelectPlanChild(const PlanSearch& ps, int n)
+{
+    const PlanNode& node = ps.nodes[n];
+    double lo = 1e30, hi = -1e30;
+    for (int m = 0; m < PLAN_MOVES; ++m)
+    {
+        if (node.child[m] < 0) return m; // untried move first
+        const PlanNode& c = ps.nodes[node.child[m]];
+        double mean = c.value / c.visits;
+        lo = min(lo, mean);
+        hi = max(hi, mean);
+    }
+
+    int best = -1;
+    double bestScore = 0.0;
+    for (int m = 0; m < PLAN_MOVES; ++m)
+    {
+        const PlanNode& c = ps.nodes[node.child[m]];
+        if (!c.ready || c.over) continue;
+        double mean = (hi > lo) ? (c.value / c.visits - lo) / (hi - lo) : 0.5;
+        double score = mean + PLAN_EXPLORE * sqrt(log((double)node.visits) / c.visits);
+        if (best < 0 || score > bestScore) { best = m; bestScore = score; }
+    }
+    return best;
+}
+
+// Fewest ticks found to clear 'start' (a game at the start of a level), or
+// 0 if the search found no clear within PLAN_MAX_TICKS. 'plan' receives the
+// moves, one per PLAN_STEP_TICKS.
+int PlanLevel(PlanSearch& ps, const GameState& start, int rollouts, TaggedVector<int8_t, MEM_PLANNER>& plan)
+{
+    ps.used = 0;
+    ps.freeNodes.clear();
+    ps.rollouts.resize(PLAN_BATCH);
+    ps.batch.resize(PLAN_BATCH);
+    ps.level = start.level;
+    ps.lives = start.lives;
+    ps.hits = 0;
+    for (size_t i = 0; i < start.brickHits.size(); ++i)
+        ps.hits += start.brickHits[i];
+
+    int root = AllocPlanNode(ps);
+    ps.nodes[root].ready = true;
+    ps.states[root] = start;
+    plan.clear();
+
+    while ((int)plan.size() < PLAN_MAX_TICKS / PLAN_STEP_TICKS)
+    {
+        for (int done = 0; done < rollouts;)
+        {
+            // Pick leaves; the visits they add steer the rest of the batch away
+            int count = 0;
+            while (count < PLAN_BATCH && done + count < rollouts)
+            {
+                int n = root;
+                for (;;)
+                {
+                    const PlanNode& node = ps.nodes[n];
+                    if (!node.ready || node.cleared || node.over) break;
+                    int m = SelectPlanChild(ps, n);
+                    if (m < 0) { n = -1; break; }
+                    if (node.child[m] < 0)
+                    {
+                        int c = AllocPlanNode(ps);
+                        ps.nodes[c].parent = n;
+                        ps.nodes[c].move = (int8_t)(m - 1);
+                        ps.nodes[c].depth = ps.nodes[n].depth + 1;
+                        ps.nodes[n].child[m] = c;
+                        n = c;
+                        break;
+                    }
+                    n = node.child[m];
+                }
+                if (n < 0 || (ps.nodes[n].visits > 0 && !ps.nodes[n].ready)) break; // all in flight
+                for (int v = n; v >= 0; v = ps.nodes[v].parent)
+                    ps.nodes[v].visits++;
+                ps.batch[count++].node = n;
+            }
+            if (count == 0) break; // every line ends in a game over
+
+            RunParallel(RunPlanTask, &ps, count);
+            for (int i = 0; i < count; ++i)
+            {
+                const PlanTask& task = ps.batch[i];
+                ps.nodes[task.node].ready = true;
+                ps.ticks += task.ticks;
+                for (int v = task.node; v >= 0; v = ps.nodes[v].parent)
+                    ps.nodes[v].value += task.value;
+            }
+            done += count;
+        }
+
+        // Commit the most visited move that doesn't end the game
+        int best = -1;
+        for (int m = 0; m < PLAN_MOVES; ++m)
+        {
+            int c = ps.nodes[root].child[m];
+            if (c < 0 || !ps.nodes[c].ready || ps.nodes[c].over) continue;
+            if (best < 0 || ps.nodes[c].visits > ps.nodes[best].visits) best = c;
+        }
+        if (best < 0) break;
+
+        plan.push_back(ps.nodes[best].move);
+        FreePlanSubtree(ps, root, best);
+        root = best;
+        ps.nodes[root].parent = -1;
+        if (ps.nodes[root].cleared)
+            return ((int)plan.size() - 1) * PLAN_STEP_TICKS + ps.nodes[root].cleared;
+    }
+    return 0;
+}
+
+// Plans every level in g_levels from the same seed and prints the clear
+// times next to the autoplayer's. Each plan is replayed from the level's
+// start to check the clone captured everything the simulation depends on.
+int RunPlanner(int rollouts)
+{
+    bool ownConsole = OpenConsole();
+    if (rollouts <= 0) rollouts = 64;
+    SetSimulationThreads((int)max(1u, std::thread::hardware_concurrency()));
+
+    const uint32_t seed = 1;
+    printf("planner: %d rollouts per move, %d ticks per move, %d threads, seed %u\n", rollouts, PLAN_STEP_TICKS,
+        g_simThreads, seed);
+
+    PlanSearch ps;
+    GameState start, game;
+    TaggedVector<int8_t, MEM_PLANNER> plan;
+    int mismatches = 0;
+    const double begin = QpcSeconds();
+
+    for (int level = 1; level <= g_levelCount; ++level)
+    {
+        InitPlanLevel(start, level, seed);
+
+        game = start;
+        int autoTicks = 0;
+        while (game.level == level && !game.gameOver && autoTicks < PLAN_MAX_TICKS)
+        {
+            UpdateGame(game, AutoplayInput(game));
+            autoTicks++;
+        }
+        if (game.level == level) autoTicks = 0;
+
+        const double levelBegin = QpcSeconds();
+        const unsigned long long levelTicks = ps.ticks;
+        int best = PlanLevel(ps, start, rollouts, plan);
+        const double levelSecs = QpcSeconds() - levelBegin;
+
+        char autoText[32], bestText[32];
+        sprintf_s(autoText, sizeof(autoText), autoTicks ? "%d" : "-", autoTicks);
+        sprintf_s(bestText, sizeof(bestText), best ? "%d" : "-", best);
+        printf("level %2d  best %6s ticks  autoplayer %6s  searched %9llu ticks in %6.2f s",
+            level, bestText, autoText, ps.ticks - levelTicks, levelSecs);
+
+        if (best)
+        {
+            game = start;
+            int replayed = 0;
+            for (size_t i = 0; i < plan.size() && !replayed; ++i)
+            {
+                int tick = PlanAdvance(game, plan[i], PLAN_STEP_TICKS, level);
+                if (tick) replayed = (int)i * PLAN_STEP_TICKS + tick;
+            }
+
+            if (replayed != best) mismatches++;
+            printf(replayed == best ? "  replayed\n" : "  REPLAY MISMATCH (%d)\n", replayed);
+        }
+        else
+            printf("\n");
+        fflush(stdout);
+    }
+
+    double secs = QpcSeconds() - begin;
+    printf("%llu ticks simulated in %.2f s: %.2f M ticks/s\n", ps.ticks, secs, ps.ticks / secs * 1e-6);
+
+    SetSimulationThreads(0);
+    CloseConsole(ownConsole);
+    return mismatches ? 1 : 0;
+}
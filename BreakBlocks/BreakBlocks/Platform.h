@@ -0,0 +1,47 @@
+// ============================================================
+// BreakBlocks platform layer
+//
+// The system headers every part of the game uses, and on headless builds
+// the handful of Win32 names the simulation itself uses.
+// ============================================================
+
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <new>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#ifndef _WIN32
+using std::min;
+using std::max;
+typedef long LONG;
+typedef unsigned int COLORREF;
+struct RECT { LONG left, top, right, bottom; };
+#define RGB(r, g, b) ((COLORREF)((r) | ((g) << 8) | ((b) << 16)))
+#define VK_SPACE 0x20
+#define VK_LEFT 0x25
+#define VK_RIGHT 0x27
+#define sprintf_s snprintf
+inline int fopen_s(FILE** f, const char* name, const char* mode)
+{
+    *f = fopen(name, mode);
+    return *f ? 0 : 1;
+}
+#endif
@@ -0,0 +1,281 @@
+#include "Render.h"
+#include "Particles.h"
+
+// ============================================================
+// Render Snapshots
+// ============================================================
+
+// Lock-free triple buffer. The simulation fills 'back', then swaps it with
+// 'middle' and marks it fresh; the renderer swaps 'middle' into 'front' only
+// when it is fresh. Neither side ever waits for the other, and the renderer
+// always gets the latest complete tick.
+static const int SNAPSHOT_FRESH = 4;
+static RenderSnapshot g_snapshots[3];
+static int g_snapshotBack = 0;  // simulation thread only
+static int g_snapshotFront = 1; // render thread only
+static std::atomic<int> g_snapshotMiddle{ 2 };
+unsigned int g_simTick = 0;
+
+// Latency probe: the newest input event applied so far (CollectTickInput),
+// carried in snapshots
+double g_lastInputTime = 0.0;
+unsigned int g_lastInputSeq = 0;
+
+void CaptureSnapshot(const GameState& g, RenderSnapshot& snap)
+{
+    snap.tick = g_simTick;
+    snap.worldW = g.worldW;
+    snap.worldH = g.worldH;
+    snap.boardRows = g.boardRows;
+    snap.boardCols = g.boardCols;
+    snap.boardTilesX = g.boardTilesX;
+    snap.boardOriginX = g.boardOriginX;
+    snap.boardOriginY = g.boardOriginY;
+    snap.brickOffsetY = g.brickOffsetY;
+
+    snap.brickHits.assign(g.brickHits.begin(), g.brickHits.end());
+
+    // Room for as many balls and particles as there can be, so captures stop
+    // allocating once a board has been seen
+    snap.balls.clear();
+    snap.balls.reserve(g.ballCap);
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        const Ball& b = g.ball[i];
+        if (!b.alive) continue;
+        RenderBall rb = { b.x, b.y, b.r };
+        snap.balls.push_back(rb);
+    }
+
+    snap.powerUpCount = 0;
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+    {
+        const FallingPowerUp& pu = g.fallingPowerUps[i];
+        if (!pu.alive) continue;
+        RenderPowerUp& rp = snap.powerUps[snap.powerUpCount++];
+        rp.x = pu.x;
+        rp.y = pu.y;
+        rp.color = g_powerUps[pu.index].color;
+    }
+
+    int particles = g.hooks.particles ? g.hooks.particles->count : 0;
+    if (particles)
+    {
+        snap.particleX.reserve(PARTICLE_CAP);
+        snap.particleY.reserve(PARTICLE_CAP);
+        snap.particleColor.reserve(PARTICLE_CAP);
+        snap.particleX.assign(g.hooks.particles->x, g.hooks.particles->x + particles);
+        snap.particleY.assign(g.hooks.particles->y, g.hooks.particles->y + particles);
+        snap.particleColor.assign(g.hooks.particles->color, g.hooks.particles->color + particles);
+    }
+    else
+    {
+        snap.particleX.clear();
+        snap.particleY.clear();
+        snap.particleColor.clear();
+    }
+
+    snap.paddleX = g.paddle.x;
+    snap.paddleY = g.paddle.y;
+    snap.paddleW = g.paddle.w;
+    snap.paddleH = g.paddle.h;
+    snap.score = g.score;
+    snap.lives = g.lives;
+    snap.level = g.level;
+    snap.gameOver = g.gameOver;
+    snap.inputTime = g_lastInputTime;
+    snap.inputSeq = g_lastInputSeq;
+}
+
+void PublishSnapshot(const GameState& g)
+{
+    CaptureSnapshot(g, g_snapshots[g_snapshotBack]);
+    g_snapshotBack = g_snapshotMiddle.exchange(g_snapshotBack | SNAPSHOT_FRESH) & 3;
+}
+
+// Latest published snapshot, or NULL if nothing new since the last call.
+const RenderSnapshot* AcquireSnapshot()
+{
+    if (!(g_snapshotMiddle.load() & SNAPSHOT_FRESH)) return NULL;
+    g_snapshotFront = g_snapshotMiddle.exchange(g_snapshotFront) & 3;
+    return &g_snapshots[g_snapshotFront];
+}
+
+// ============================================================
+// Software Rendering
+// ============================================================
+
+// Render without a DC: the same layout, colors, scaling and draw order into
+// a top-down 0x00RRGGBB pixel buffer, GDI's black pen outlines included, so
+// frames can be made with no window (frame export). Text uses a built-in
+// 3x5 font, in capitals, since there is no system font to borrow.
+
+struct Canvas
+{
+    uint32_t* pixels;
+    int w, h;
+    ViewTransform view;
+    int dot; // pixels per font dot
+};
+
+static const int FONT_SCALE = 2; // pixels per font dot at 1:1
+static const char FONT_CHARS[] = "0123456789ACEGILMOPRSTV:!";
+static const uint16_t FONT_GLYPHS[] = // a row of 3 dots per octal digit, top row first
+{
+    075557, 026227, 071747, 071717, 055711, 074717, 074757, 071111, 075757, 075717,
+    025755, 074447, 074647, 074557, 072227, 044447, 057755, 075557, 075744, 065655,
+    074717, 072222, 055552, 002020, 022202,
+};
+
+// Pixels [x0, x1) x [y0, y1), clipped
+void CanvasFill(Canvas& c, int x0, int y0, int x1, int y1, uint32_t color)
+{
+    x0 = max(x0, 0); y0 = max(y0, 0);
+    x1 = min(x1, c.w); y1 = min(y1, c.h);
+    for (int y = y0; y < y1; ++y)
+    {
+        uint32_t* row = c.pixels + (size_t)y * c.w;
+        for (int x = x0; x < x1; ++x) row[x] = color;
+    }
+}
+
+// GDI's Rectangle with the default pen: a black outline around 'fill',
+// right and bottom edges excluded. World coordinates.
+void CanvasRectangle(Canvas& c, float l, float t, float r, float b, uint32_t fill)
+{
+    const ViewTransform& v = c.view;
+    int x0 = (int)(l * v.scale) + v.x, y0 = (int)(t * v.scale) + v.y;
+    int x1 = (int)(r * v.scale) + v.x, y1 = (int)(b * v.scale) + v.y;
+    CanvasFill(c, x0, y0, x1, y1, 0);
+    CanvasFill(c, x0 + 1, y0 + 1, x1 - 1, y1 - 1, fill);
+}
+
+// GDI's Ellipse likewise, inscribed in l, t, r, b
+void CanvasEllipse(Canvas& c, float l, float t, float r, float b, uint32_t fill)
+{
+    const ViewTransform& v = c.view;
+    int x0 = (int)(l * v.scale) + v.x, y0 = (int)(t * v.scale) + v.y;
+    int x1 = (int)(r * v.scale) + v.x, y1 = (int)(b * v.scale) + v.y;
+    float cx = (x0 + x1) * 0.5f, cy = (y0 + y1) * 0.5f;
+    float rx = (x1 - x0) * 0.5f, ry = (y1 - y0) * 0.5f;
+    if (rx <= 0.f || ry <= 0.f) return;
+
+    float inX = max(rx - 1.f, 0.001f), inY = max(ry - 1.f, 0.001f);
+    for (int y = max(y0, 0); y < min(y1, c.h); ++y)
+    {
+        uint32_t* row = c.pixels + (size_t)y * c.w;
+        float dy = y + 0.5f - cy;
+        for (int x = max(x0, 0); x < min(x1, c.w); ++x)
+        {
+            float dx = x + 0.5f - cx;
+            if ((dx * dx) / (rx * rx) + (dy * dy) / (ry * ry) > 1.f) continue;
+            row[x] = ((dx * dx) / (inX * inX) + (dy * dy) / (inY * inY) > 1.f) ? 0 : fill;
+        }
+    }
+}
+
+// Pixel coordinates, like TextOutA after the transform is reset
+void CanvasText(Canvas& c, int x, int y, const char* text, uint32_t color)
+{
+    const int dot = c.dot;
+    for (; *text; ++text, x += 4 * dot)
+    {
+        char ch = *text;
+        if (ch >= 'a' && ch <= 'z') ch -= 'a' - 'A';
+        const char* at = (ch != ' ') ? strchr(FONT_CHARS, ch) : NULL;
+        if (!at || !*at) continue;
+
+        uint16_t glyph = FONT_GLYPHS[at - FONT_CHARS];
+        for (int row = 0; row < 5; ++row)
+            for (int col = 0; col < 3; ++col)
+                if (glyph >> ((4 - row) * 3 + (2 - col)) & 1)
+                    CanvasFill(c, x + col * dot, y + row * dot,
+                        x + (col + 1) * dot, y + (row + 1) * dot, color);
+    }
+}
+
+// Render's bricks, tile by tile (see RenderBricks)
+void RasterizeBricks(Canvas& c, const RenderSnapshot& snap)
+{
+    const int TILE_CELLS = BRICK_TILE * BRICK_TILE;
+    const int pitchX = BRICK_W + BRICK_GAP, pitchY = BRICK_H + BRICK_GAP;
+    const bool blocks = BRICK_W * c.view.scale < 3.f;
+    const int viewBottom = (int)((c.h - c.view.y) / c.view.scale);
+
+    uint32_t colors[6];
+    for (int i = 0; i < 6; ++i) colors[i] = PixelColor(GetBrickColor(i + 1));
+
+    int tilesY = (snap.boardRows + BRICK_TILE - 1) >> BRICK_TILE_SHIFT;
+    for (int ty = 0; ty < tilesY; ++ty)
+    {
+        int top = snap.boardOriginY + ty * BRICK_TILE * pitchY + snap.brickOffsetY;
+        if (top > viewBottom) break;
+        for (int tx = 0; tx < snap.boardTilesX; ++tx)
+        {
+            const uint8_t* tile = &snap.brickHits[(size_t)(ty * snap.boardTilesX + tx) * TILE_CELLS];
+            int left = snap.boardOriginX + tx * BRICK_TILE * pitchX;
+
+            if (blocks)
+            {
+                int strongest = 0;
+                for (int i = 0; i < TILE_CELLS; ++i) strongest = max(strongest, (int)tile[i]);
+                if (strongest == 0) continue;
+                CanvasRectangle(c, (float)left, (float)top, (float)(left + BRICK_TILE * pitchX - BRICK_GAP),
+                    (float)(top + BRICK_TILE * pitchY - BRICK_GAP), colors[min(strongest, 6) - 1]);
+                continue;
+            }
+
+            for (int i = 0; i < TILE_CELLS; ++i)
+            {
+                if (tile[i] == 0) continue;
+                int x = left + (i & (BRICK_TILE - 1)) * pitchX;
+                int y = top + (i >> BRICK_TILE_SHIFT) * pitchY;
+                CanvasRectangle(c, (float)x, (float)y, (float)(x + BRICK_W), (float)(y + BRICK_H),
+                    colors[min((int)tile[i], 6) - 1]);
+            }
+        }
+    }
+}
+
+// One frame of 'snap', as Render would draw it into a w x h back buffer
+void RasterizeSnapshot(const RenderSnapshot& snap, uint32_t* pixels, int w, int h)
+{
+    ViewTransform view = FitView(snap.worldW, snap.worldH, w, h);
+    const float hud = HudScale(view);
+    Canvas c = { pixels, w, h, view, (int)(FONT_SCALE * hud) };
+    memset(pixels, 0, (size_t)w * h * sizeof(uint32_t));
+
+    RasterizeBricks(c, snap);
+    CanvasRectangle(c, snap.paddleX, snap.paddleY, snap.paddleX + snap.paddleW, snap.paddleY + snap.paddleH, 0xFFFFFF);
+    for (size_t i = 0; i < snap.balls.size(); ++i)
+    {
+        const RenderBall& ball = snap.balls[i];
+        CanvasEllipse(c, ball.x - ball.r, ball.y - ball.r, ball.x + ball.r, ball.y + ball.r, 0xFFFFFF);
+    }
+    for (int i = 0; i < snap.powerUpCount; ++i)
+    {
+        const RenderPowerUp& pu = snap.powerUps[i];
+        CanvasEllipse(c, pu.x - 8, pu.y - 8, pu.x + 8, pu.y + 8, PixelColor(pu.color));
+    }
+    if (!snap.particleX.empty())
+        DrawParticles(snap.particleX.data(), snap.particleY.data(), snap.particleColor.data(),
+            (int)snap.particleX.size(), pixels, w, w, h, view);
+
+    char buf[64];
+    const uint32_t text = PixelColor(RGB(250, 250, 250));
+    const int top = view.y + (int)(10 * hud);
+    sprintf_s(buf, sizeof(buf), "Score: %d", snap.score);
+    CanvasText(c, view.x + (int)(10 * hud), top, buf, text);
+    sprintf_s(buf, sizeof(buf), "Lives: %d", snap.lives);
+    CanvasText(c, view.x + (int)(170 * hud), top, buf, text);
+    sprintf_s(buf, sizeof(buf), "Level: %d", snap.level);
+    CanvasText(c, view.x + (int)(340 * hud), top, buf, text);
+
+    if (snap.gameOver)
+    {
+        const char* msg = "GAME OVER! Press R to Restart";
+        int len = (int)strlen(msg);
+        CanvasText(c, view.x + (int)(snap.worldW * view.scale) / 2 - len * 2 * c.dot,
+            view.y + (int)(snap.worldH * view.scale) / 2, msg, text);
+    }
+}
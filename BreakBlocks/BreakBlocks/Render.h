@@ -0,0 +1,61 @@
+// ============================================================
+// BreakBlocks render snapshots
+//
+// The simulation thread copies what a frame needs out of the game once a
+// tick; the window draws the latest copy with GDI, and exports and
+// benchmarks rasterize copies in software. Neither reads live game state.
+// ============================================================
+
+#pragma once
+
+#include "Game.h"
+
+// ============================================================
+// Render Snapshots
+// ============================================================
+
+// Everything Render needs from one tick, copied out by the simulation
+// thread so the renderer never reads live game state.
+struct RenderBall
+{
+    float x, y, r;
+};
+
+struct RenderPowerUp
+{
+    float x, y;
+    COLORREF color;
+};
+
+struct RenderSnapshot
+{
+    unsigned int tick = 0;
+    int worldW = 0, worldH = 0;
+    int boardRows = 0, boardCols = 0, boardTilesX = 0;
+    int boardOriginX = 0, boardOriginY = 0;
+    int brickOffsetY = 0;
+    TaggedVector<uint8_t, MEM_RENDER> brickHits; // tiled, like GameState::brickHits
+    TaggedVector<RenderBall, MEM_RENDER> balls;
+    RenderPowerUp powerUps[MAX_FALLING_POWERUPS];
+    int powerUpCount = 0;
+    TaggedVector<float, MEM_RENDER> particleX, particleY;
+    TaggedVector<uint32_t, MEM_RENDER> particleColor;
+    float paddleX = 0.f, paddleY = 0.f, paddleW = 0.f, paddleH = 0.f;
+    int score = 0, lives = 0, level = 0;
+    bool gameOver = false;
+    double inputTime = 0.0;     // arrival of the newest input applied
+    unsigned int inputSeq = 0;  // changes whenever inputTime does
+};
+
+extern unsigned int g_simTick;
+extern double g_lastInputTime;
+extern unsigned int g_lastInputSeq;
+void CaptureSnapshot(const GameState& g, RenderSnapshot& snap);
+void PublishSnapshot(const GameState& g);
+const RenderSnapshot* AcquireSnapshot();
+
+// ============================================================
+// Software Rendering
+// ============================================================
+
+void RasterizeSnapshot(const RenderSnapshot& snap, uint32_t* pixels, int w, int h);
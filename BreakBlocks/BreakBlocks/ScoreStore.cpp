@@ -0,0 +1,268 @@
+#include "ScoreStore.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// ============================================================
+// Score Store
+// ============================================================
+
+static_assert(sizeof(StoreRecord) == 32, "log records are 32 bytes");
+
+static const double STORE_SYNC_SECONDS = 0.05;    // appends gathered into one fsync
+static const uint64_t STORE_COMPACT_MIN = 4096;   // log records before compaction is considered
+
+ScoreStore* g_scores = nullptr; // the player's results, if kept
+
+uint32_t Crc32(const void* data, size_t n)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; ++i)
+    {
+        crc ^= bytes[i];
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// Adds a record to the in-memory index. Under 'lock' once the writer runs.
+void IndexRecord(ScoreStore& s, const StoreRecord& r)
+{
+    if (r.kind == RECORD_GAME)
+    {
+        if (s.top.size() == STORE_TOP && r.score <= s.top.back().score) return;
+        auto at = std::upper_bound(s.top.begin(), s.top.end(), r,
+            [](const StoreRecord& a, const StoreRecord& b) { return a.score > b.score; });
+        s.top.insert(at, r);
+        if (s.top.size() > STORE_TOP) s.top.pop_back();
+    }
+    else if (r.kind == RECORD_LEVEL && r.level >= 1)
+    {
+        if (s.bestLevel.size() < r.level) s.bestLevel.resize(r.level, StoreRecord());
+        StoreRecord& best = s.bestLevel[r.level - 1];
+        if (best.ticks == 0 || r.ticks < best.ticks) best = r;
+    }
+}
+
+// Everything the index holds, in log order for a rewrite
+void IndexedRecords(const ScoreStore& s, TaggedVector<StoreRecord, MEM_SCORES>& out)
+{
+    out.assign(s.top.begin(), s.top.end());
+    for (size_t i = 0; i < s.bestLevel.size(); ++i)
+        if (s.bestLevel[i].ticks) out.push_back(s.bestLevel[i]);
+}
+
+bool SyncFile(FILE* f)
+{
+    if (fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Writer thread: the log becomes just the indexed records, written to a
+// side file and renamed over it so a crash leaves one or the other whole.
+// Appends still queued are covered by the index or weren't worth keeping.
+void CompactScoreStore(ScoreStore& s)
+{
+    TaggedVector<StoreRecord, MEM_SCORES> live;
+    {
+        std::lock_guard<std::mutex> hold(s.lock);
+        IndexedRecords(s, live);
+        s.written += s.pending.size();
+        s.pending.clear();
+    }
+
+    char side[520];
+    sprintf_s(side, sizeof(side), "%s.new", s.path);
+    FILE* f = NULL;
+    if (fopen_s(&f, side, "wb") != 0 || !f) return;
+    bool ok = live.empty() || fwrite(live.data(), sizeof(StoreRecord), live.size(), f) == live.size();
+    ok = SyncFile(f) && ok;
+    fclose(f);
+    if (!ok) { remove(side); return; }
+
+    fclose(s.log);
+#ifdef _WIN32
+    ok = MoveFileExA(side, s.path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    ok = rename(side, s.path) == 0;
+#endif
+    if (fopen_s(&s.log, s.path, "ab") != 0 || !s.log)
+    {
+        s.log = NULL; // later batches count as lost
+        fprintf(stderr, "score store: cannot reopen %s after compaction\n", s.path);
+    }
+    if (ok) s.logRecords = live.size();
+
+    std::lock_guard<std::mutex> hold(s.lock);
+    s.compactions += ok;
+}
+
+// Group commit: sleeps until something is appended, gives the batch
+// STORE_SYNC_SECONDS to grow, then writes and syncs it in one go.
+void ScoreWriterLoop(ScoreStore* s)
+{
+    TaggedVector<StoreRecord, MEM_SCORES> batch;
+    std::unique_lock<std::mutex> hold(s->lock);
+    for (;;)
+    {
+        s->wake.wait(hold, [&] { return s->quit || !s->pending.empty(); });
+        if (!s->quit)
+            s->wake.wait_for(hold, std::chrono::duration<double>(STORE_SYNC_SECONDS), [&] { return s->quit; });
+        batch.swap(s->pending);
+        size_t live = s->top.size() + s->bestLevel.size();
+        bool quit = s->quit;
+        hold.unlock();
+
+        bool synced = false;
+        size_t wrote = 0;
+        if (!batch.empty() && s->log)
+        {
+            wrote = fwrite(batch.data(), sizeof(StoreRecord), batch.size(), s->log);
+            synced = SyncFile(s->log);
+            s->logRecords += wrote;
+        }
+        if (s->log && s->logRecords >= STORE_COMPACT_MIN && s->logRecords > 4 * live)
+            CompactScoreStore(*s);
+
+        hold.lock();
+        s->written += wrote;
+        s->lost += batch.size() - wrote;
+        s->syncs += synced;
+        batch.clear();
+        if (quit && s->pending.empty()) return;
+    }
+}
+
+// Loads the log at 'path' (created if missing) into the index and starts
+// the writer. Records that fail their checksum are skipped, not trusted and
+// not cut: whatever follows them is still read. Only a partial record at
+// the end is cut off.
+bool OpenScoreStore(ScoreStore& s, const char* path)
+{
+    sprintf_s(s.path, sizeof(s.path), "%s", path);
+
+    FILE* f = NULL;
+    long whole = 0, size = 0;
+    if (fopen_s(&f, path, "rb") == 0 && f)
+    {
+        StoreRecord r;
+        while (fread(&r, sizeof(r), 1, f) == 1)
+        {
+            whole += (long)sizeof(r);
+            if (r.crc != RecordCrc(r)) { s.corrupt++; continue; }
+            IndexRecord(s, r);
+            s.recovered++;
+        }
+        fseek(f, 0, SEEK_END);
+        size = ftell(f);
+        fclose(f);
+    }
+    s.logRecords = s.recovered + s.corrupt;
+
+    if (size > whole && fopen_s(&f, path, "r+b") == 0 && f)
+    {
+#ifdef _WIN32
+        _chsize_s(_fileno(f), whole);
+#else
+        if (ftruncate(fileno(f), whole) != 0) whole = size;
+#endif
+        fclose(f);
+        s.tornBytes = (uint64_t)(size - whole);
+    }
+
+    if (fopen_s(&s.log, path, "ab") != 0 || !s.log) return false;
+    s.writer = std::thread(ScoreWriterLoop, &s);
+    return true;
+}
+
+// Writes out what is queued and stops the writer. False if any appended
+// result never made it into the log.
+bool CloseScoreStore(ScoreStore& s)
+{
+    if (!s.writer.joinable()) return true;
+    {
+        std::lock_guard<std::mutex> hold(s.lock);
+        s.quit = true;
+    }
+    s.wake.notify_one();
+    s.writer.join();
+    if (s.log) fclose(s.log);
+    s.log = NULL;
+    return s.lost == 0;
+}
+
+// Game thread. Never waits on the disk: the record is indexed and queued.
+void AppendScore(ScoreStore& s, StoreRecord r)
+{
+    r.crc = RecordCrc(r);
+    bool first;
+    {
+        std::lock_guard<std::mutex> hold(s.lock);
+        IndexRecord(s, r);
+        first = s.pending.empty();
+        s.pending.push_back(r);
+        s.appended++;
+    }
+    if (first) s.wake.notify_one();
+}
+
+// Up to 'n' best scores, best first; returns how many
+int TopScores(ScoreStore& s, StoreRecord* out, int n)
+{
+    std::lock_guard<std::mutex> hold(s.lock);
+    n = min(n, (int)s.top.size());
+    std::copy(s.top.begin(), s.top.begin() + n, out);
+    return n;
+}
+
+// Fastest clear of 'level'; false if it has never been cleared
+bool BestLevelTime(ScoreStore& s, int level, StoreRecord& out)
+{
+    std::lock_guard<std::mutex> hold(s.lock);
+    if (level < 1 || level > (int)s.bestLevel.size() || s.bestLevel[level - 1].ticks == 0) return false;
+    out = s.bestLevel[level - 1];
+    return true;
+}
+
+// ------------------------------------------------------------
+// Results from a running game
+// ------------------------------------------------------------
+
+// Once per tick, after it runs: level clears and game overs as records.
+// A null store still follows the game, it just records nothing.
+void TrackScores(const GameState& g, ScoreStore* store, ScoreTracker& t)
+{
+    t.ticks++;
+    StoreRecord r = {};
+    r.score = g.score;
+    r.seed = t.seed;
+    r.startTick = t.gameStart;
+    r.time = (int64_t)time(NULL);
+
+    if (t.level != 0 && !t.over && !g.gameOver && g.level == t.level + 1)
+    {
+        r.kind = RECORD_LEVEL;
+        r.level = (uint16_t)t.level;
+        r.ticks = t.ticks - t.levelStart;
+        if (store) AppendScore(*store, r);
+        t.levelStart = t.ticks;
+    }
+    if (g.gameOver && !t.over)
+    {
+        r.kind = RECORD_GAME;
+        r.level = (uint16_t)g.level;
+        r.ticks = t.ticks - t.gameStart;
+        if (store) AppendScore(*store, r);
+    }
+    if (t.level == 0 || (t.over && !g.gameOver))
+        t.gameStart = t.levelStart = t.ticks; // first tick, or restarted
+    t.level = g.level;
+    t.over = g.gameOver;
+}
@@ -0,0 +1,85 @@
+// ============================================================
+// BreakBlocks score store
+//
+// High scores and per-level best clear times that outlive the process, each
+// with a replay reference (the session's seed and the tick its game began).
+// The store is an append-only log of fixed-size, checksummed records.
+// Appending only takes a lock and indexes the record in memory; a writer
+// thread writes whatever has queued up, with one fsync per batch, and
+// compacts the log down to what the index still uses once most of it is
+// dead. Opening the log skips records that fail their checksum (the next
+// compaction drops them) and cuts off a partial record at the end, which is
+// all a crash mid-write can leave. The host feeds it through TrackScores,
+// once per tick, like telemetry.
+// ============================================================
+
+#pragma once
+
+#include "Game.h"
+
+enum StoreRecordKind
+{
+    RECORD_GAME = 1,  // a game ended: score and level reached
+    RECORD_LEVEL = 2, // a level was cleared: ticks it took
+};
+
+struct StoreRecord
+{
+    uint32_t crc;       // CRC-32 of the rest of the record
+    uint8_t kind;
+    uint8_t reserved;
+    uint16_t level;     // reached (game) / cleared (level)
+    int32_t score;
+    uint32_t ticks;     // game length / time to clear the level
+    uint32_t seed;      // replay reference: the session's seed...
+    uint32_t startTick; // ...and the tick into it this game began at
+    int64_t time;       // unix seconds
+};
+
+static const size_t STORE_TOP = 100;              // high scores kept
+
+struct ScoreStore
+{
+    char path[512] = {};
+    FILE* log = NULL;
+    std::thread writer;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool quit = false;
+
+    // Under 'lock'
+    TaggedVector<StoreRecord, MEM_SCORES> pending;   // appended, not written yet
+    TaggedVector<StoreRecord, MEM_SCORES> top;       // best score first, at most STORE_TOP
+    TaggedVector<StoreRecord, MEM_SCORES> bestLevel; // [level - 1]; ticks == 0: never cleared
+    uint64_t appended = 0, written = 0, syncs = 0, compactions = 0;
+    uint64_t lost = 0; // appended but never written: the log failed
+
+    // Writer thread (and OpenScoreStore) only
+    uint64_t logRecords = 0;
+    uint64_t recovered = 0, corrupt = 0, tornBytes = 0; // found by OpenScoreStore
+
+    MEM_TAGGED_NEW(MEM_SCORES)
+};
+
+extern ScoreStore* g_scores;
+uint32_t Crc32(const void* data, size_t n);
+
+inline uint32_t RecordCrc(const StoreRecord& r)
+{
+    return Crc32((const char*)&r + sizeof(r.crc), sizeof(r) - sizeof(r.crc));
+}
+
+bool OpenScoreStore(ScoreStore& s, const char* path);
+bool CloseScoreStore(ScoreStore& s);
+void AppendScore(ScoreStore& s, StoreRecord r);
+
+struct ScoreTracker
+{
+    uint32_t seed = 0;  // the session's, for replay references
+    uint32_t ticks = 0; // since the session began
+    uint32_t gameStart = 0, levelStart = 0;
+    int level = 0;      // 0 = not seen yet
+    bool over = false;
+};
+
+void TrackScores(const GameState& g, ScoreStore* store, ScoreTracker& t);
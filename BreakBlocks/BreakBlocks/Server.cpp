@@ -0,0 +1,1072 @@
+#include "Tools.h"
+#include "ScoreStore.h"
+#include "Telemetry.h"
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+// ============================================================
+// Game Server (breakblocks --server [port | unix:path])
+// ============================================================
+
+// Hosts many GameStates on one epoll loop. Every session is advanced by the
+// same fixed-rate tick; after it, each connection gets one frame holding a
+// delta per session it owns, sent with a single write. Inputs arrive as
+// fixed 8-byte messages and are held until the next tick. Every field is
+// little-endian whatever the host; the structs below give the layout and
+// are encoded field by field, never copied raw.
+// Game and level results go to a ScoreStore; its writer thread does the
+// disk I/O, so a tick only pays for an in-memory append.
+
+enum ClientMsgType
+{
+    CLIENT_OPEN = 1,  // start a session; it shows up with DELTA_OPENED
+    CLIENT_INPUT = 2, // held buttons for 'session', plus mouse movement
+    CLIENT_CLOSE = 3,
+};
+
+enum InputButtons
+{
+    BUTTON_LEFT = 1,
+    BUTTON_RIGHT = 2,
+    BUTTON_LAUNCH = 4,
+    BUTTON_RESTART = 8,
+};
+
+struct WireClientMsg
+{
+    uint8_t type;
+    uint8_t buttons;  // held until the next CLIENT_INPUT
+    int16_t mouseDx;  // raw counts, applied on the next tick
+    uint32_t session;
+};
+
+// One per connection per tick, followed by 'sessions' deltas
+struct WireFrameHeader
+{
+    uint32_t bytes; // whole frame, header included
+    uint32_t tick;
+    uint32_t sessions;
+};
+
+enum DeltaFlags
+{
+    DELTA_OPENED = 1,
+    DELTA_CLOSED = 2,    // last delta for this session, nothing follows it
+    DELTA_BOARD = 4,     // WireBoard + hits follow; drop all mirrored bricks and power-ups
+    DELTA_LAUNCHED = 8,
+    DELTA_GAME_OVER = 16,
+};
+
+// Positions are fixed point, 1/4 px, in an int16: anything past +-8191.75 px
+// is clamped. Served sessions are regular SCREEN_W x SCREEN_H games, so that
+// never happens; stress-sized worlds can't be served without widening them.
+struct WireSessionDelta
+{
+    uint32_t session;
+    int32_t score;
+    uint16_t flags;
+    uint16_t level;
+    int16_t lives;
+    int16_t brickOffsetY;
+    int16_t paddleX, paddleW;
+    uint16_t balls;          // WireBall each
+    uint16_t brickChanges;   // uint32 each: index | hits << 24
+    uint16_t powerUpEvents;  // WirePowerUpEvent each
+    uint16_t reserved;
+};
+
+// Followed by rows * cols hit counts (0 = no brick), padded to 4 bytes
+struct WireBoard
+{
+    uint16_t rows, cols;
+    int16_t originX, originY;
+};
+
+struct WireBall
+{
+    int16_t x, y;
+};
+
+enum PowerUpEventKind
+{
+    POWERUP_SPAWN = 1,
+    POWERUP_CAUGHT = 2,
+    POWERUP_LOST = 3, // fell off the bottom
+};
+
+// Falling power-ups move at a fixed rate, so the client only hears about
+// them when they appear or go away.
+struct WirePowerUpEvent
+{
+    uint8_t kind;
+    uint8_t slot;
+    uint8_t type;
+    uint8_t reserved;
+    int16_t x, y;
+};
+
+static const float WIRE_POS_SCALE = 4.f;
+static const size_t SERVER_MAX_BACKLOG = 4 << 20; // unsent bytes before a client is dropped
+static_assert(SCREEN_W * 4 < 32768 && SCREEN_H * 4 < 32768, "wire positions must fit the world");
+static_assert(sizeof(WireClientMsg) == 8 && sizeof(WireFrameHeader) == 12 && sizeof(WireSessionDelta) == 28 &&
+              sizeof(WireBoard) == 8 && sizeof(WireBall) == 4 && sizeof(WirePowerUpEvent) == 8,
+              "struct sizes are the encoded sizes");
+
+// ------------------------------------------------------------
+// Encoding: little-endian, one field at a time
+// ------------------------------------------------------------
+
+inline void StoreWire16(char* p, uint16_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+}
+
+inline void StoreWire32(char* p, uint32_t v)
+{
+    p[0] = (char)v;
+    p[1] = (char)(v >> 8);
+    p[2] = (char)(v >> 16);
+    p[3] = (char)(v >> 24);
+}
+
+inline uint16_t LoadWire16(const char* p)
+{
+    const unsigned char* u = (const unsigned char*)p;
+    return (uint16_t)(u[0] | u[1] << 8);
+}
+
+inline uint32_t LoadWire32(const char* p)
+{
+    const unsigned char* u = (const unsigned char*)p;
+    return (uint32_t)u[0] | (uint32_t)u[1] << 8 | (uint32_t)u[2] << 16 | (uint32_t)u[3] << 24;
+}
+
+void StoreWire(char* p, uint32_t v) { StoreWire32(p, v); }
+void LoadWire(const char* p, uint32_t& v) { v = LoadWire32(p); }
+
+void StoreWire(char* p, const WireClientMsg& m)
+{
+    p[0] = (char)m.type;
+    p[1] = (char)m.buttons;
+    StoreWire16(p + 2, (uint16_t)m.mouseDx);
+    StoreWire32(p + 4, m.session);
+}
+
+void LoadWire(const char* p, WireClientMsg& m)
+{
+    m.type = (uint8_t)p[0];
+    m.buttons = (uint8_t)p[1];
+    m.mouseDx = (int16_t)LoadWire16(p + 2);
+    m.session = LoadWire32(p + 4);
+}
+
+void StoreWire(char* p, const WireFrameHeader& h)
+{
+    StoreWire32(p, h.bytes);
+    StoreWire32(p + 4, h.tick);
+    StoreWire32(p + 8, h.sessions);
+}
+
+void LoadWire(const char* p, WireFrameHeader& h)
+{
+    h.bytes = LoadWire32(p);
+    h.tick = LoadWire32(p + 4);
+    h.sessions = LoadWire32(p + 8);
+}
+
+void StoreWire(char* p, const WireSessionDelta& d)
+{
+    StoreWire32(p, d.session);
+    StoreWire32(p + 4, (uint32_t)d.score);
+    StoreWire16(p + 8, d.flags);
+    StoreWire16(p + 10, d.level);
+    StoreWire16(p + 12, (uint16_t)d.lives);
+    StoreWire16(p + 14, (uint16_t)d.brickOffsetY);
+    StoreWire16(p + 16, (uint16_t)d.paddleX);
+    StoreWire16(p + 18, (uint16_t)d.paddleW);
+    StoreWire16(p + 20, d.balls);
+    StoreWire16(p + 22, d.brickChanges);
+    StoreWire16(p + 24, d.powerUpEvents);
+    StoreWire16(p + 26, d.reserved);
+}
+
+void LoadWire(const char* p, WireSessionDelta& d)
+{
+    d.session = LoadWire32(p);
+    d.score = (int32_t)LoadWire32(p + 4);
+    d.flags = LoadWire16(p + 8);
+    d.level = LoadWire16(p + 10);
+    d.lives = (int16_t)LoadWire16(p + 12);
+    d.brickOffsetY = (int16_t)LoadWire16(p + 14);
+    d.paddleX = (int16_t)LoadWire16(p + 16);
+    d.paddleW = (int16_t)LoadWire16(p + 18);
+    d.balls = LoadWire16(p + 20);
+    d.brickChanges = LoadWire16(p + 22);
+    d.powerUpEvents = LoadWire16(p + 24);
+    d.reserved = LoadWire16(p + 26);
+}
+
+void StoreWire(char* p, const WireBoard& b)
+{
+    StoreWire16(p, b.rows);
+    StoreWire16(p + 2, b.cols);
+    StoreWire16(p + 4, (uint16_t)b.originX);
+    StoreWire16(p + 6, (uint16_t)b.originY);
+}
+
+void LoadWire(const char* p, WireBoard& b)
+{
+    b.rows = LoadWire16(p);
+    b.cols = LoadWire16(p + 2);
+    b.originX = (int16_t)LoadWire16(p + 4);
+    b.originY = (int16_t)LoadWire16(p + 6);
+}
+
+void StoreWire(char* p, const WireBall& b)
+{
+    StoreWire16(p, (uint16_t)b.x);
+    StoreWire16(p + 2, (uint16_t)b.y);
+}
+
+void LoadWire(const char* p, WireBall& b)
+{
+    b.x = (int16_t)LoadWire16(p);
+    b.y = (int16_t)LoadWire16(p + 2);
+}
+
+void StoreWire(char* p, const WirePowerUpEvent& e)
+{
+    p[0] = (char)e.kind;
+    p[1] = (char)e.slot;
+    p[2] = (char)e.type;
+    p[3] = (char)e.reserved;
+    StoreWire16(p + 4, (uint16_t)e.x);
+    StoreWire16(p + 6, (uint16_t)e.y);
+}
+
+void LoadWire(const char* p, WirePowerUpEvent& e)
+{
+    e.kind = (uint8_t)p[0];
+    e.slot = (uint8_t)p[1];
+    e.type = (uint8_t)p[2];
+    e.reserved = (uint8_t)p[3];
+    e.x = (int16_t)LoadWire16(p + 4);
+    e.y = (int16_t)LoadWire16(p + 6);
+}
+
+template<class Buffer, class T>
+void AppendWire(Buffer& out, const T& value)
+{
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    StoreWire(&out[at], value);
+}
+
+struct ServerSession
+{
+    GameState state;
+    FallingPowerUp sentPowerUps[MAX_FALLING_POWERUPS]; // as the client last saw them
+    int sentEpoch = -1;
+    int conn = -1;        // -1 = free slot
+    uint8_t buttons = 0;
+    int mouseDx = 0;
+    bool opened = false;  // DELTA_OPENED not sent yet
+    Telemetry telemetry;  // merged into the server's when the session closes
+    ScoreTracker scores;
+};
+
+struct ServerConnection
+{
+    int fd = -1;
+    TaggedVector<char, MEM_SERVER> in;
+    TaggedVector<char, MEM_SERVER> out;
+    size_t outSent = 0;
+    TaggedVector<uint32_t, MEM_SERVER> sessions;
+    TaggedVector<uint32_t, MEM_SERVER> closed; // closed since the last frame
+    bool wantWrite = false;
+};
+
+struct GameServer
+{
+    int epollFd = -1;
+    int listenFd = -1;
+    TaggedVector<ServerConnection, MEM_SERVER> conns;
+    TaggedVector<ServerSession, MEM_SERVER> sessions;
+    TaggedVector<uint32_t, MEM_SERVER> freeSessions;
+    BrickLog brickLog;
+    unsigned int tick = 0;
+    uint32_t seed = 1; // sessions get seed + id * golden ratio
+
+    // Tick budget, reported by the loop and the loopback test
+    double tickTotal = 0.0, tickWorst = 0.0;
+    int ticksTimed = 0, overruns = 0;
+    size_t bytesQueued = 0;
+
+    Telemetry telemetry;                 // closed sessions
+    const char* telemetryPrefix = NULL; // written there on shutdown, if set
+    ScoreStore* scores = NULL;          // game and level results, if kept
+};
+
+static GameServer g_server;
+static std::atomic<bool> g_serverQuit{ false };
+
+void SetNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+void WatchConnection(int index, bool wantWrite)
+{
+    ServerConnection& c = g_server.conns[index];
+    epoll_event ev = {};
+    ev.events = wantWrite ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    ev.data.u32 = (uint32_t)index;
+    epoll_ctl(g_server.epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+    c.wantWrite = wantWrite;
+}
+
+// "unix:/path" or a TCP port on 127.0.0.1 (0 = any free port).
+// Returns the bound TCP port, 0 for a Unix socket, -1 on failure.
+int StartServer(const char* address)
+{
+    GameServer& sv = g_server;
+    int port = 0;
+    if (strncmp(address, "unix:", 5) == 0)
+    {
+        sockaddr_un sa = {};
+        sa.sun_family = AF_UNIX;
+        strncpy(sa.sun_path, address + 5, sizeof(sa.sun_path) - 1);
+        unlink(sa.sun_path);
+        sv.listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sv.listenFd < 0 || bind(sv.listenFd, (sockaddr*)&sa, sizeof(sa)) != 0)
+            return -1;
+    }
+    else
+    {
+        sockaddr_in sa = {};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sa.sin_port = htons((uint16_t)atoi(address));
+        sv.listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(sv.listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (sv.listenFd < 0 || bind(sv.listenFd, (sockaddr*)&sa, sizeof(sa)) != 0)
+            return -1;
+        socklen_t len = sizeof(sa);
+        getsockname(sv.listenFd, (sockaddr*)&sa, &len);
+        port = ntohs(sa.sin_port);
+    }
+    if (listen(sv.listenFd, 128) != 0) return -1;
+    SetNonBlocking(sv.listenFd);
+
+    signal(SIGPIPE, SIG_IGN);
+    sv.epollFd = epoll_create1(0);
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = 0xFFFFFFFFu; // the listener
+    epoll_ctl(sv.epollFd, EPOLL_CTL_ADD, sv.listenFd, &ev);
+    return port;
+}
+
+uint32_t OpenServerSession(int conn)
+{
+    GameServer& sv = g_server;
+    uint32_t id;
+    if (!sv.freeSessions.empty())
+    {
+        id = sv.freeSessions.back();
+        sv.freeSessions.pop_back();
+    }
+    else
+    {
+        id = (uint32_t)sv.sessions.size();
+        sv.sessions.push_back(ServerSession());
+    }
+
+    ServerSession& s = sv.sessions[id];
+    s = ServerSession();
+    s.scores.seed = sv.seed + id * 2654435761u;
+    InitGameState(s.state, s.scores.seed);
+    s.conn = conn;
+    s.opened = true;
+    sv.conns[conn].sessions.push_back(id);
+    return id;
+}
+
+void CloseServerSession(uint32_t id)
+{
+    ServerSession& s = g_server.sessions[id];
+    MergeTelemetry(g_server.telemetry, s.telemetry);
+    s = ServerSession(); // frees the board
+    g_server.freeSessions.push_back(id);
+}
+
+void CloseConnection(int index)
+{
+    ServerConnection& c = g_server.conns[index];
+    if (c.fd < 0) return;
+    epoll_ctl(g_server.epollFd, EPOLL_CTL_DEL, c.fd, NULL);
+    close(c.fd);
+    for (size_t i = 0; i < c.sessions.size(); ++i)
+        CloseServerSession(c.sessions[i]);
+    c = ServerConnection();
+}
+
+void AcceptConnections()
+{
+    GameServer& sv = g_server;
+    for (;;)
+    {
+        int fd = accept4(sv.listenFd, NULL, NULL, SOCK_NONBLOCK);
+        if (fd < 0) return;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // fails harmlessly on Unix sockets
+
+        int index = -1;
+        for (size_t i = 0; i < sv.conns.size(); ++i)
+            if (sv.conns[i].fd < 0) { index = (int)i; break; }
+        if (index < 0)
+        {
+            index = (int)sv.conns.size();
+            sv.conns.push_back(ServerConnection());
+        }
+        sv.conns[index].fd = fd;
+
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t)index;
+        epoll_ctl(sv.epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void HandleClientMessage(int conn, const WireClientMsg& msg)
+{
+    GameServer& sv = g_server;
+    ServerConnection& c = sv.conns[conn];
+
+    if (msg.type == CLIENT_OPEN)
+    {
+        OpenServerSession(conn);
+        return;
+    }
+
+    // Only sessions this connection owns
+    if (msg.session >= sv.sessions.size() || sv.sessions[msg.session].conn != conn) return;
+    ServerSession& s = sv.sessions[msg.session];
+
+    if (msg.type == CLIENT_INPUT)
+    {
+        s.buttons = msg.buttons;
+        s.mouseDx += msg.mouseDx;
+    }
+    else if (msg.type == CLIENT_CLOSE)
+    {
+        for (size_t i = 0; i < c.sessions.size(); ++i)
+        {
+            if (c.sessions[i] != msg.session) continue;
+            c.sessions[i] = c.sessions.back();
+            c.sessions.pop_back();
+            break;
+        }
+        c.closed.push_back(msg.session);
+        CloseServerSession(msg.session);
+    }
+}
+
+void ReadConnection(int index)
+{
+    ServerConnection& c = g_server.conns[index];
+    char buf[16384];
+    for (;;)
+    {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) { c.in.insert(c.in.end(), buf, buf + n); continue; }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        CloseConnection(index); // EOF or error
+        return;
+    }
+
+    size_t count = c.in.size() / sizeof(WireClientMsg);
+    for (size_t i = 0; i < count; ++i)
+    {
+        WireClientMsg msg;
+        LoadWire(&c.in[i * sizeof(WireClientMsg)], msg);
+        HandleClientMessage(index, msg);
+    }
+    c.in.erase(c.in.begin(), c.in.begin() + count * sizeof(WireClientMsg));
+}
+
+// Sends as much queued output as the socket takes; the rest waits for EPOLLOUT.
+void FlushConnection(int index)
+{
+    ServerConnection& c = g_server.conns[index];
+    while (c.outSent < c.out.size())
+    {
+        ssize_t n = send(c.fd, &c.out[c.outSent], c.out.size() - c.outSent, MSG_NOSIGNAL);
+        if (n > 0) { c.outSent += (size_t)n; continue; }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        CloseConnection(index);
+        return;
+    }
+
+    if (c.outSent == c.out.size())
+    {
+        c.out.clear();
+        c.outSent = 0;
+        if (c.wantWrite) WatchConnection(index, false);
+    }
+    else if (c.out.size() - c.outSent > SERVER_MAX_BACKLOG)
+    {
+        CloseConnection(index); // not keeping up: don't buffer without bound
+    }
+    else if (!c.wantWrite)
+    {
+        WatchConnection(index, true);
+    }
+}
+
+int16_t WirePos(float v)
+{
+    return (int16_t)Clamp(v * WIRE_POS_SCALE, -32768.f, 32767.f);
+}
+
+// Appends the delta for session 'id'.
+void EncodeSessionDelta(TaggedVector<char, MEM_SERVER>& out, uint32_t id, ServerSession& s)
+{
+    const GameState& g = s.state;
+    size_t at = out.size();
+    WireSessionDelta d = {};
+    d.session = id;
+    d.score = g.score;
+    d.level = (uint16_t)g.level;
+    d.lives = (int16_t)g.lives;
+    d.brickOffsetY = (int16_t)g.brickOffsetY;
+    d.paddleX = WirePos(g.paddle.x);
+    d.paddleW = WirePos(g.paddle.w);
+    if (s.opened) d.flags |= DELTA_OPENED;
+    if (g.ballLaunched) d.flags |= DELTA_LAUNCHED;
+    if (g.gameOver) d.flags |= DELTA_GAME_OVER;
+    AppendWire(out, d);
+
+    // Whole board after a relayout; the change log is moot then
+    bool fullBoard = (s.sentEpoch != g.boardEpoch);
+    if (fullBoard)
+    {
+        d.flags |= DELTA_BOARD;
+        s.sentEpoch = g.boardEpoch;
+        for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+            s.sentPowerUps[i] = FallingPowerUp();
+
+        WireBoard wb = { (uint16_t)g.boardRows, (uint16_t)g.boardCols,
+                         (int16_t)g.boardOriginX, (int16_t)g.boardOriginY };
+        AppendWire(out, wb);
+        size_t cells = (size_t)g.boardRows * g.boardCols;
+        size_t start = out.size();
+        out.resize(start + ((cells + 3) & ~(size_t)3), 0);
+        char* row = &out[start];
+        for (int r = 0; r < g.boardRows; ++r, row += g.boardCols)
+            for (int c = 0; c < g.boardCols; ++c)
+                row[c] = (char)BrickHits(g, r, c);
+    }
+
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        const Ball& b = g.ball[i];
+        if (!b.alive) continue;
+        WireBall wb = { WirePos(b.x), WirePos(b.y) };
+        AppendWire(out, wb);
+        d.balls++;
+    }
+
+    if (!fullBoard)
+    {
+        for (size_t i = 0; i < g_server.brickLog.size(); ++i)
+        {
+            int index = g_server.brickLog[i];
+            if (i > 0 && index == g_server.brickLog[i - 1]) continue;
+            uint32_t change = (uint32_t)index | (uint32_t)BrickHits(g, index) << 24;
+            AppendWire(out, change);
+            d.brickChanges++;
+        }
+    }
+
+    for (int i = 0; i < MAX_FALLING_POWERUPS; ++i)
+    {
+        const FallingPowerUp& now = g.fallingPowerUps[i];
+        FallingPowerUp& sent = s.sentPowerUps[i];
+
+        // A slot can be freed and refilled within one tick; a survivor has
+        // only fallen by exactly one step
+        bool respawned = now.alive && sent.alive &&
+                         (now.index != sent.index || now.x != sent.x || now.y != sent.y + 2.f);
+        if (sent.alive && (!now.alive || respawned))
+        {
+            bool lost = sent.y + 2.f > g.worldH + 10.f;
+            WirePowerUpEvent e = { (uint8_t)(lost ? POWERUP_LOST : POWERUP_CAUGHT), (uint8_t)i,
+                                   (uint8_t)sent.index, 0, WirePos(sent.x), WirePos(sent.y) };
+            AppendWire(out, e);
+            d.powerUpEvents++;
+        }
+        if (now.alive && (!sent.alive || respawned))
+        {
+            WirePowerUpEvent e = { POWERUP_SPAWN, (uint8_t)i, (uint8_t)now.index, 0,
+                                   WirePos(now.x), WirePos(now.y) };
+            AppendWire(out, e);
+            d.powerUpEvents++;
+        }
+        sent = now;
+    }
+
+    s.opened = false;
+    StoreWire(&out[at], d); // counts are final now
+}
+
+// Advances every session one tick and queues one frame per connection.
+void ServerTick()
+{
+    GameServer& sv = g_server;
+    double start = QpcSeconds();
+    sv.tick++;
+
+    for (size_t ci = 0; ci < sv.conns.size(); ++ci)
+    {
+        ServerConnection& c = sv.conns[ci];
+        if (c.fd < 0 || (c.sessions.empty() && c.closed.empty())) continue;
+
+        size_t frameStart = c.out.size();
+        WireFrameHeader header = { 0, sv.tick, (uint32_t)(c.sessions.size() + c.closed.size()) };
+        AppendWire(c.out, header);
+
+        for (size_t i = 0; i < c.closed.size(); ++i)
+        {
+            WireSessionDelta d = {};
+            d.session = c.closed[i];
+            d.flags = DELTA_CLOSED;
+            AppendWire(c.out, d);
+        }
+        c.closed.clear();
+
+        for (size_t i = 0; i < c.sessions.size(); ++i)
+        {
+            uint32_t id = c.sessions[i];
+            ServerSession& s = sv.sessions[id];
+
+            TickInput in;
+            float held = (float)((s.buttons & BUTTON_RIGHT) != 0) - (float)((s.buttons & BUTTON_LEFT) != 0);
+            in.paddleMove = held * PADDLE_SPEED + s.mouseDx * MOUSE_PADDLE_SCALE;
+            in.launch = (s.buttons & BUTTON_LAUNCH) != 0;
+            in.restart = (s.buttons & BUTTON_RESTART) != 0;
+            s.mouseDx = 0;
+
+            // Hooks are set per tick: sessions move when the table grows
+            GameState& g = s.state;
+            sv.brickLog.clear();
+            g.hooks.brickLog = &sv.brickLog;
+            AttachTelemetry(g, &s.telemetry);
+            UpdateGame(g, in);
+            TrackScores(g, sv.scores, s.scores);
+            g.hooks.brickLog = nullptr;
+            g.hooks.telemetry = nullptr;
+            EncodeSessionDelta(c.out, id, s);
+        }
+
+        uint32_t bytes = (uint32_t)(c.out.size() - frameStart);
+        StoreWire32(&c.out[frameStart], bytes);
+        sv.bytesQueued += bytes;
+    }
+
+    // One send per connection per tick
+    for (size_t ci = 0; ci < sv.conns.size(); ++ci)
+        if (sv.conns[ci].fd >= 0 && !sv.conns[ci].out.empty()) FlushConnection((int)ci);
+
+    double elapsed = QpcSeconds() - start;
+    sv.tickTotal += elapsed;
+    sv.ticksTimed++;
+    if (elapsed > sv.tickWorst) sv.tickWorst = elapsed;
+    if (elapsed > 1.0 / TICK_HZ) sv.overruns++;
+}
+
+void PollServer(int timeoutMs)
+{
+    GameServer& sv = g_server;
+    epoll_event events[64];
+    int n = epoll_wait(sv.epollFd, events, 64, timeoutMs);
+    for (int i = 0; i < n; ++i)
+    {
+        uint32_t index = events[i].data.u32;
+        if (index == 0xFFFFFFFFu) { AcceptConnections(); continue; }
+        if (sv.conns[index].fd < 0) continue;
+
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            ReadConnection((int)index);
+        if (sv.conns[index].fd >= 0 && (events[i].events & EPOLLOUT))
+            FlushConnection((int)index);
+    }
+}
+
+// Fixed-rate loop: I/O fills the wait between ticks. Returns on g_serverQuit
+// after handing each client what is still queued and closing it.
+void RunServerLoop(bool report)
+{
+    GameServer& sv = g_server;
+    const double tickSeconds = 1.0 / TICK_HZ;
+    double nextTick = QpcSeconds() + tickSeconds;
+    double nextReport = QpcSeconds() + 10.0;
+    uint64_t reportAllocs = g_allocCount.load(std::memory_order_relaxed);
+
+    while (!g_serverQuit)
+    {
+        double wait = nextTick - QpcSeconds();
+        PollServer(wait > 0.0 ? (int)(wait * 1000.0) : 0);
+        if (QpcSeconds() < nextTick) continue;
+
+        ServerTick();
+        nextTick += tickSeconds;
+        double now = QpcSeconds();
+        if (now - nextTick > 0.25) nextTick = now; // hopelessly behind: don't try to catch up
+
+        if (report && now >= nextReport && sv.ticksTimed > 0)
+        {
+            int live = (int)(sv.sessions.size() - sv.freeSessions.size());
+            uint64_t allocs = g_allocCount.load(std::memory_order_relaxed);
+            printf("tick %u: %d sessions, %.3f ms/tick avg, %.3f max, %d overruns, %.1f KB/tick, "
+                   "%.1f allocations/tick, rss %.1f MB\n",
+                sv.tick, live, sv.tickTotal * 1e3 / sv.ticksTimed, sv.tickWorst * 1e3,
+                sv.overruns, sv.bytesQueued / 1024.0 / sv.ticksTimed,
+                (double)(allocs - reportAllocs) / sv.ticksTimed, g_rssBytes.load() / (1024.0 * 1024.0));
+            fflush(stdout);
+            reportAllocs = allocs;
+            sv.tickTotal = sv.tickWorst = 0.0;
+            sv.ticksTimed = sv.overruns = 0;
+            sv.bytesQueued = 0;
+            nextReport = now + 10.0;
+        }
+    }
+
+    for (size_t ci = 0; ci < sv.conns.size(); ++ci)
+    {
+        ServerConnection& c = sv.conns[ci];
+        if (c.fd < 0) continue;
+        fcntl(c.fd, F_SETFL, fcntl(c.fd, F_GETFL, 0) & ~O_NONBLOCK);
+        while (c.outSent < c.out.size())
+        {
+            ssize_t n = send(c.fd, &c.out[c.outSent], c.out.size() - c.outSent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            c.outSent += (size_t)n;
+        }
+        shutdown(c.fd, SHUT_WR);
+    }
+}
+
+// Closes every connection and session.
+void StopServer()
+{
+    GameServer& sv = g_server;
+    for (size_t ci = 0; ci < sv.conns.size(); ++ci)
+        CloseConnection((int)ci);
+    close(sv.listenFd);
+    close(sv.epollFd);
+    if (sv.telemetryPrefix && !WriteTelemetry(sv.telemetry, sv.telemetryPrefix))
+        printf("server: cannot write telemetry to %s_*.csv\n", sv.telemetryPrefix);
+    if (sv.telemetryPrefix)
+    {
+        char path[512];
+        sprintf_s(path, sizeof(path), "%s_memory.json", sv.telemetryPrefix);
+        if (!WriteMemoryJson(path)) printf("server: cannot write %s\n", path);
+    }
+    g_server = GameServer();
+    g_serverQuit = false;
+}
+
+// Ctrl-C / kill: leave the loop so StopServer still runs
+void OnServerSignal(int)
+{
+    g_serverQuit = true;
+}
+
+int RunServer(const char* address, const char* telemetryPrefix, const char* scorePath)
+{
+    InitPaddleBounceTable();
+
+    ScoreStore scores;
+    if (!OpenScoreStore(scores, scorePath))
+    {
+        printf("server: cannot open %s\n", scorePath);
+        return 1;
+    }
+
+    int port = StartServer(address);
+    g_server.seed = (uint32_t)time(NULL);
+    g_server.telemetryPrefix = telemetryPrefix;
+    g_server.scores = &scores;
+    if (port < 0)
+    {
+        printf("server: cannot listen on %s (%s)\n", address, strerror(errno));
+        CloseScoreStore(scores);
+        return 1;
+    }
+    if (port > 0) printf("server: listening on 127.0.0.1:%d\n", port);
+    else printf("server: listening on %s\n", address + 5);
+    fflush(stdout);
+
+    signal(SIGINT, OnServerSignal);
+    signal(SIGTERM, OnServerSignal);
+    StartRssSampler(1.0);
+    RunServerLoop(true);
+    StopRssSampler();
+    StopServer();
+    bool logged = CloseScoreStore(scores);
+    printf("server: %llu results logged to %s\n", (unsigned long long)scores.written, scorePath);
+    if (!logged) printf("server: %llu results LOST, the log failed\n", (unsigned long long)scores.lost);
+    return logged ? 0 : 1;
+}
+
+// ------------------------------------------------------------
+// Loopback client (breakblocks --loopback [sessions] [ticks])
+// ------------------------------------------------------------
+
+// What a client rebuilds from the deltas alone
+struct MirrorSession
+{
+    int rows = 0, cols = 0;
+    std::vector<unsigned char> hits;
+    std::vector<WireBall> balls;
+    bool powerUps[MAX_FALLING_POWERUPS] = {};
+    int powerUpTypes[MAX_FALLING_POWERUPS] = {};
+    int score = 0, lives = 0, level = 0;
+    int paddleX = 0, paddleW = 0;
+    uint16_t flags = 0;
+    bool open = false;
+};
+
+bool RecvAll(int fd, void* dst, size_t n)
+{
+    char* p = (char*)dst;
+    while (n > 0)
+    {
+        ssize_t got = recv(fd, p, n, 0);
+        if (got <= 0) return false;
+        p += got;
+        n -= (size_t)got;
+    }
+    return true;
+}
+
+// Applies one frame; returns false on a malformed one.
+bool ApplyFrame(const std::vector<char>& frame, std::vector<MirrorSession>& mirrors)
+{
+    WireFrameHeader header;
+    LoadWire(frame.data(), header);
+    size_t at = sizeof(header);
+    auto read = [&](auto& dst)
+    {
+        if (at + sizeof(dst) > frame.size()) return false;
+        LoadWire(&frame[at], dst);
+        at += sizeof(dst);
+        return true;
+    };
+
+    for (uint32_t k = 0; k < header.sessions; ++k)
+    {
+        WireSessionDelta d;
+        if (!read(d)) return false;
+        if (d.session >= mirrors.size()) mirrors.resize(d.session + 1);
+        MirrorSession& m = mirrors[d.session];
+        if (d.flags & DELTA_CLOSED) { m = MirrorSession(); continue; }
+
+        m.open = true;
+        m.flags = d.flags;
+        m.score = d.score;
+        m.lives = d.lives;
+        m.level = d.level;
+        m.paddleX = d.paddleX;
+        m.paddleW = d.paddleW;
+
+        if (d.flags & DELTA_BOARD)
+        {
+            WireBoard wb;
+            if (!read(wb)) return false;
+            m.rows = wb.rows;
+            m.cols = wb.cols;
+            m.hits.resize((size_t)wb.rows * wb.cols);
+            size_t padded = (m.hits.size() + 3) & ~(size_t)3;
+            if (at + padded > frame.size()) return false;
+            memcpy(m.hits.data(), &frame[at], m.hits.size());
+            at += padded;
+            for (int i = 0; i < MAX_FALLING_POWERUPS; ++i) m.powerUps[i] = false;
+        }
+
+        m.balls.resize(d.balls);
+        for (int i = 0; i < d.balls; ++i)
+            if (!read(m.balls[i])) return false;
+
+        for (int i = 0; i < d.brickChanges; ++i)
+        {
+            uint32_t change;
+            if (!read(change)) return false;
+            if ((change & 0xFFFFFF) >= m.hits.size()) return false;
+            m.hits[change & 0xFFFFFF] = (unsigned char)(change >> 24);
+        }
+
+        for (int i = 0; i < d.powerUpEvents; ++i)
+        {
+            WirePowerUpEvent e;
+            if (!read(e) || e.slot >= MAX_FALLING_POWERUPS) return false;
+            m.powerUps[e.slot] = (e.kind == POWERUP_SPAWN);
+            m.powerUpTypes[e.slot] = e.type;
+        }
+    }
+    return at == frame.size();
+}
+
+// Starts a server on an ephemeral localhost port, drives 'sessions' games
+// from one client connection for 'ticks' frames, then checks the client's
+// mirrors against the server's own state.
+int RunLoopbackTest(int sessions, int ticks)
+{
+    InitPaddleBounceTable();
+    const char* scorePath = "loopback_scores.bbl";
+    remove(scorePath);
+    ScoreStore scores;
+    OpenScoreStore(scores, scorePath);
+
+    int port = StartServer("0");
+    g_server.seed = 4242;
+    g_server.scores = &scores;
+    if (port <= 0)
+    {
+        printf("loopback: cannot listen (%s)\n", strerror(errno));
+        CloseScoreStore(scores);
+        return 1;
+    }
+    std::thread server([] { RunServerLoop(false); });
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa = {};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = htons((uint16_t)port);
+    if (connect(fd, (sockaddr*)&sa, sizeof(sa)) != 0)
+    {
+        printf("loopback: connect failed (%s)\n", strerror(errno));
+        g_serverQuit = true;
+        server.join();
+        StopServer();
+        CloseScoreStore(scores);
+        return 1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    std::vector<char> msgs;
+    for (int i = 0; i < sessions; ++i)
+    {
+        WireClientMsg msg = { CLIENT_OPEN, 0, 0, 0 };
+        AppendWire(msgs, msg);
+    }
+    send(fd, msgs.data(), msgs.size(), 0);
+
+    printf("loopback server, %d sessions, %d ticks\n", sessions, ticks);
+
+    std::vector<MirrorSession> mirrors;
+    std::vector<char> frame;
+    size_t frameBytes = 0;
+    int frames = 0;
+    bool ok = true;
+    double start = QpcSeconds();
+    for (;;)
+    {
+        char head[sizeof(WireFrameHeader)];
+        if (!RecvAll(fd, head, sizeof(head))) break; // server closed: drained
+        WireFrameHeader header;
+        LoadWire(head, header);
+        frame.resize(max<size_t>(header.bytes, sizeof(head)));
+        memcpy(frame.data(), head, sizeof(head));
+        if (header.bytes < sizeof(header) || !RecvAll(fd, &frame[sizeof(header)], header.bytes - sizeof(header)))
+        {
+            ok = false;
+            break;
+        }
+        ok = ApplyFrame(frame, mirrors) && ok;
+        frameBytes += header.bytes;
+
+        if (++frames == ticks)
+        {
+            g_serverQuit = true; // keep reading until the server hangs up
+            continue;
+        }
+        if (frames > ticks) continue;
+
+        // Autopilot: launch, follow the first ball, restart when it's over
+        msgs.clear();
+        for (size_t id = 0; id < mirrors.size(); ++id)
+        {
+            const MirrorSession& m = mirrors[id];
+            if (!m.open) continue;
+            uint8_t buttons = (m.flags & DELTA_GAME_OVER) ? BUTTON_RESTART : BUTTON_LAUNCH;
+            if (!m.balls.empty())
+            {
+                int center = m.paddleX + m.paddleW / 2;
+                int target = m.balls[0].x + (int)((id % 7) * WIRE_POS_SCALE * 6.f) - (int)(18 * WIRE_POS_SCALE);
+                if (target < center - 8) buttons |= BUTTON_LEFT;
+                if (target > center + 8) buttons |= BUTTON_RIGHT;
+            }
+            WireClientMsg msg = { CLIENT_INPUT, buttons, 0, (uint32_t)id };
+            AppendWire(msgs, msg);
+        }
+        if (!msgs.empty()) send(fd, msgs.data(), msgs.size(), 0);
+    }
+    double elapsed = QpcSeconds() - start;
+    server.join();
+    close(fd);
+
+    // Everything the server sent must reproduce its own state
+    int mismatched = 0, open = 0;
+    for (size_t id = 0; id < g_server.sessions.size(); ++id)
+    {
+        const ServerSession& s = g_server.sessions[id];
+        if (s.conn < 0) continue;
+        open++;
+        const GameState& g = s.state;
+        const MirrorSession* m = (id < mirrors.size()) ? &mirrors[id] : NULL;
+        bool same = m && m->open && m->score == g.score && m->lives == g.lives && m->level == g.level &&
+                    m->hits.size() == (size_t)g.boardRows * g.boardCols;
+        for (int i = 0; same && i < (int)m->hits.size(); ++i)
+            same = m->hits[i] == g.brickHits[BrickSlot(i / g.boardCols, i % g.boardCols, g.boardTilesX)];
+        for (int i = 0; same && i < MAX_FALLING_POWERUPS; ++i)
+            same = m->powerUps[i] == g.fallingPowerUps[i].alive &&
+                   (!m->powerUps[i] || m->powerUpTypes[i] == g.fallingPowerUps[i].index);
+        int balls = 0;
+        for (size_t i = 0; i < g.ball.size(); ++i) balls += g.ball[i].alive;
+        same = same && (int)m->balls.size() == balls;
+        if (!same) mismatched++;
+    }
+
+    printf("  %d frames in %.2f s, %.1f KB/frame, %.1f B/session/tick\n", frames, elapsed,
+        frameBytes / 1024.0 / max(frames, 1), (double)frameBytes / max(frames, 1) / max(sessions, 1));
+    printf("  server tick: %.3f ms avg, %.3f ms max (budget %.3f), %d overruns\n",
+        g_server.tickTotal * 1e3 / max(g_server.ticksTimed, 1), g_server.tickWorst * 1e3,
+        1e3 / TICK_HZ, g_server.overruns);
+    printf("  %d/%d sessions mirrored exactly%s\n", open - mismatched, open, ok ? "" : " (malformed frame)");
+
+    StopServer();
+    bool logged = CloseScoreStore(scores) && scores.written == scores.appended;
+    remove(scorePath);
+    printf("  %llu results logged in %llu syncs%s\n", (unsigned long long)scores.written,
+        (unsigned long long)scores.syncs, logged ? "" : " (LOST RESULTS)");
+    return (ok && logged && mismatched == 0 && open == sessions) ? 0 : 1;
+}
+#endif // __linux__
@@ -0,0 +1,171 @@
+#include "Telemetry.h"
+
+// ============================================================
+// Telemetry
+// ============================================================
+
+void ResetTelemetry(const GameState& g, Telemetry& t)
+{
+    t = Telemetry();
+    t.rows = g.boardRows;
+    t.cols = g.boardCols;
+    t.brickHits.assign((size_t)g_levelCount * t.rows * t.cols, 0);
+    t.levels.assign(g_levelCount, LevelStats());
+    t.spawned.assign(g_powerUpCount, 0);
+    t.caught.assign(g_powerUpCount, 0);
+    t.missed.assign(g_powerUpCount, 0);
+    t.expired.assign(g_powerUpCount, 0);
+}
+
+inline void RecordLifetime(Telemetry& t, uint64_t ticks)
+{
+    int k = 0;
+    while (k < LIFETIME_BUCKETS - 1 && (ticks >> (k + 1)) != 0) k++;
+    t.lifetimes[k]++;
+}
+
+// Points the simulation at 't' (NULL = off). Its counters start over if
+// they were for a board of another shape.
+void AttachTelemetry(GameState& g, Telemetry* t)
+{
+    g.hooks.telemetry = t;
+    if (t && (t->rows != g.boardRows || t->cols != g.boardCols))
+        ResetTelemetry(g, *t);
+}
+
+void RecordBallLost(Telemetry& t, int slot)
+{
+    if ((size_t)slot >= t.ballLaunch.size() || t.ballLaunch[slot] == NOT_IN_FLIGHT) return;
+    RecordLifetime(t, t.ticks - t.ballLaunch[slot]);
+    t.ballLaunch[slot] = NOT_IN_FLIGHT;
+}
+
+// Play started (every live ball takes off) or stopped (every flight ends)
+void RecordLaunchChange(const GameState& g, Telemetry& t)
+{
+    if (t.ballLaunch.size() != (size_t)g.ballCap)
+        t.ballLaunch.assign(g.ballCap, NOT_IN_FLIGHT);
+
+    t.launched = g.ballLaunched;
+    for (int i = 0; i < g.ballCap; ++i)
+    {
+        if (!t.launched) RecordBallLost(t, i);
+        else if (g.ball[i].alive && t.ballLaunch[i] == NOT_IN_FLIGHT) t.ballLaunch[i] = t.ticks;
+    }
+}
+
+void RecordLevelChange(const GameState& g, Telemetry& t)
+{
+    if (t.epoch >= 0 && !t.over)
+    {
+        LevelStats& l = t.levels[t.layout];
+        uint32_t ticks = (uint32_t)(t.ticks - t.levelStart);
+        if (g.gameOver) l.failed++;
+        else if (g.boardEpoch != t.epoch)
+        {
+            l.cleared++;
+            l.clearTicks += ticks;
+            if (l.bestTicks == 0 || ticks < l.bestTicks) l.bestTicks = ticks;
+        }
+    }
+    t.layout = LevelLayout(g);
+    t.epoch = g.boardEpoch;
+    t.over = g.gameOver;
+    t.levelStart = t.ticks;
+}
+
+// Adds a finished session into 'into'. Heatmaps only add up over boards of
+// the same shape; 'from' is dropped from them otherwise.
+void MergeTelemetry(Telemetry& into, const Telemetry& from)
+{
+    if (into.brickHits.empty())
+    {
+        into.rows = from.rows;
+        into.cols = from.cols;
+        into.brickHits.assign(from.brickHits.size(), 0);
+        into.levels.assign(from.levels.size(), LevelStats());
+        into.spawned.assign(from.spawned.size(), 0);
+        into.caught.assign(from.caught.size(), 0);
+        into.missed.assign(from.missed.size(), 0);
+        into.expired.assign(from.expired.size(), 0);
+    }
+    if (from.rows == into.rows && from.cols == into.cols)
+        for (size_t i = 0; i < from.brickHits.size(); ++i)
+            into.brickHits[i] += from.brickHits[i];
+
+    for (size_t i = 0; i < from.levels.size() && i < into.levels.size(); ++i)
+    {
+        LevelStats& l = into.levels[i];
+        const LevelStats& f = from.levels[i];
+        l.cleared += f.cleared;
+        l.failed += f.failed;
+        l.clearTicks += f.clearTicks;
+        if (f.bestTicks && (l.bestTicks == 0 || f.bestTicks < l.bestTicks)) l.bestTicks = f.bestTicks;
+    }
+    for (size_t i = 0; i < from.spawned.size() && i < into.spawned.size(); ++i)
+    {
+        into.spawned[i] += from.spawned[i];
+        into.caught[i] += from.caught[i];
+        into.missed[i] += from.missed[i];
+        into.expired[i] += from.expired[i];
+    }
+    for (int i = 0; i < PADDLE_ZONES; ++i) into.paddleZones[i] += from.paddleZones[i];
+    for (int i = 0; i < LIFETIME_BUCKETS; ++i) into.lifetimes[i] += from.lifetimes[i];
+    into.ticks += from.ticks;
+}
+
+// One CSV per table, named <prefix>_bricks.csv, _levels.csv, _powerups.csv,
+// _paddle.csv and _balls.csv. Returns false if a file couldn't be written.
+bool WriteTelemetry(const Telemetry& t, const char* prefix)
+{
+    char path[512];
+    FILE* f = NULL;
+    bool ok = true;
+    auto open = [&](const char* table, const char* header)
+    {
+        sprintf_s(path, sizeof(path), "%s_%s.csv", prefix, table);
+        if (fopen_s(&f, path, "w") != 0 || !f) { ok = false; return false; }
+        fprintf(f, "%s\n", header);
+        return true;
+    };
+
+    if (open("bricks", "level,row,col,hits"))
+    {
+        for (size_t layout = 0; layout < t.levels.size(); ++layout)
+            for (int r = 0; r < t.rows; ++r)
+                for (int c = 0; c < t.cols; ++c)
+                    fprintf(f, "%d,%d,%d,%u\n", (int)layout + 1, r, c,
+                        t.brickHits[(layout * t.rows + r) * t.cols + c]);
+        fclose(f);
+    }
+    if (open("levels", "level,cleared,failed,mean_clear_ticks,best_clear_ticks"))
+    {
+        for (size_t i = 0; i < t.levels.size(); ++i)
+        {
+            const LevelStats& l = t.levels[i];
+            fprintf(f, "%d,%u,%u,%.1f,%u\n", (int)i + 1, l.cleared, l.failed,
+                l.cleared ? (double)l.clearTicks / l.cleared : 0.0, l.bestTicks);
+        }
+        fclose(f);
+    }
+    if (open("powerups", "powerup,spawned,caught,missed,expired"))
+    {
+        for (size_t i = 0; i < t.spawned.size(); ++i)
+            fprintf(f, "%s,%u,%u,%u,%u\n", g_powerUps[i].name, t.spawned[i], t.caught[i], t.missed[i], t.expired[i]);
+        fclose(f);
+    }
+    if (open("paddle", "zone,from,to,contacts"))
+    {
+        for (int i = 0; i < PADDLE_ZONES; ++i)
+            fprintf(f, "%d,%.3f,%.3f,%u\n", i, -1.f + 2.f * i / PADDLE_ZONES,
+                -1.f + 2.f * (i + 1) / PADDLE_ZONES, t.paddleZones[i]);
+        fclose(f);
+    }
+    if (open("balls", "lifetime_from_ticks,lifetime_to_ticks,balls"))
+    {
+        for (int i = 0; i < LIFETIME_BUCKETS; ++i)
+            fprintf(f, "%u,%u,%u\n", 1u << i, (2u << i) - 1, t.lifetimes[i]);
+        fclose(f);
+    }
+    return ok;
+}
@@ -0,0 +1,97 @@
+// ============================================================
+// BreakBlocks telemetry
+//
+// Balancing and profiling counters: hits per brick for each level layout,
+// level clear times, power-up spawns/catches/misses/expiries, ball
+// lifetimes and paddle contacts by zone. The simulation records into a
+// game's hooks.telemetry when one is attached (like hooks.brickLog) and
+// never reads it back, so recording can't change a game. A tick runs on
+// one thread, so there is one Telemetry per session rather than per thread;
+// MergeTelemetry adds finished sessions together.
+// ============================================================
+
+#pragma once
+
+#include "Game.h"
+
+static const int PADDLE_ZONES = 8;      // contact position buckets, left to right
+static const int LIFETIME_BUCKETS = 24; // ball lifetimes in ticks, [2^k, 2^(k+1))
+
+struct LevelStats
+{
+    uint32_t cleared = 0;
+    uint32_t failed = 0;     // game over on this level
+    uint64_t clearTicks = 0; // summed over clears
+    uint32_t bestTicks = 0;  // 0 = never cleared
+};
+
+struct Telemetry
+{
+    int rows = 0, cols = 0;          // board the heatmaps are laid out for
+    TaggedVector<uint32_t, MEM_TELEMETRY> brickHits; // [layout][row * cols + col]
+    TaggedVector<LevelStats, MEM_TELEMETRY> levels;  // per layout
+    TaggedVector<uint32_t, MEM_TELEMETRY> spawned, caught, missed, expired; // per power-up type
+    uint32_t paddleZones[PADDLE_ZONES] = {};
+    uint32_t lifetimes[LIFETIME_BUCKETS] = {};
+    uint64_t ticks = 0;
+
+    // Where the session is, for the per-tick bookkeeping
+    TaggedVector<uint64_t, MEM_TELEMETRY> ballLaunch; // tick the ball in each slot went into flight
+    int layout = 0;
+    int epoch = -1;
+    uint64_t levelStart = 0;
+    bool over = false;
+    bool launched = false;
+};
+
+static const uint64_t NOT_IN_FLIGHT = ~0ull;
+
+// Levels past the last LevelDef replay it, so they share its counters
+inline int LevelLayout(const GameState& g)
+{
+    return min(max(g.level, 1), g_levelCount) - 1;
+}
+
+void AttachTelemetry(GameState& g, Telemetry* t);
+
+// A ball's lifetime is recorded when its flight ends: it is lost or
+// removed (TelemetryBallLost), or play stops with it still up (a sticky
+// catch, a cleared level, descent reaching the paddle). Flights start when
+// play does or when a ball is added during play (TelemetryBallAdded), so
+// nothing is counted per ball per tick.
+void RecordLaunchChange(const GameState& g, Telemetry& t);
+void RecordLevelChange(const GameState& g, Telemetry& t);
+void RecordBallLost(Telemetry& t, int slot);
+
+// At the end of every tick
+inline void TelemetryTick(const GameState& g, Telemetry& t)
+{
+    if (g.ballLaunched != t.launched) RecordLaunchChange(g, t);
+    if (g.boardEpoch != t.epoch || g.gameOver != t.over) RecordLevelChange(g, t);
+    t.ticks++;
+}
+
+inline void TelemetryBallAdded(const GameState& g, int slot)
+{
+    Telemetry& t = *g.hooks.telemetry;
+    if (g.ballLaunched && (size_t)slot < t.ballLaunch.size()) t.ballLaunch[slot] = t.ticks;
+}
+
+inline void TelemetryBallLost(const GameState& g, int slot)
+{
+    RecordBallLost(*g.hooks.telemetry, slot);
+}
+
+inline void TelemetryBrickHit(const GameState& g, int brick)
+{
+    g.hooks.telemetry->brickHits[(size_t)LevelLayout(g) * g.hooks.telemetry->rows * g.hooks.telemetry->cols + brick]++;
+}
+
+inline void TelemetryPaddleContact(const GameState& g, float hit)
+{
+    int zone = (int)((hit + 1.f) * (0.5f * PADDLE_ZONES));
+    g.hooks.telemetry->paddleZones[min(max(zone, 0), PADDLE_ZONES - 1)]++;
+}
+
+void MergeTelemetry(Telemetry& into, const Telemetry& from);
+bool WriteTelemetry(const Telemetry& t, const char* prefix);
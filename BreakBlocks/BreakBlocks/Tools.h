@@ -0,0 +1,85 @@
+// ============================================================
+// BreakBlocks tool modes
+//
+// What the command line can run instead of the game: benchmarks, soak
+// runs, audio capture and video export, the planner, the fuzzer, golden
+// traces and the game server. Each returns the process exit code.
+// ============================================================
+
+#pragma once
+
+#include "Game.h"
+
+// GUI subsystem: borrow the launching console, or open one (BreakBlocks.cpp)
+bool OpenConsole();
+void CloseConsole(bool ownConsole);
+
+// ============================================================
+// Benchmarks (BreakBlocks.exe /bench)
+// ============================================================
+
+int RunBenchmarks();
+
+// ============================================================
+// Soak Runs (BreakBlocks.exe /soak [hours])
+// ============================================================
+
+int RunSoak(double hours, const char* telemetryPrefix);
+
+// ============================================================
+// Frame Export
+// ============================================================
+
+struct ExportStats
+{
+    uint64_t frames = 0;
+    double seconds = 0.0;       // wall clock, all stages
+    double stageSeconds[3] = {}; // busy time: simulate, rasterize, encode
+    bool ok = true;
+};
+
+ExportStats ExportReplay(uint32_t seed, double seconds, FILE* out);
+
+// ============================================================
+// Audio Capture (BreakBlocks.exe /audio [seconds])
+// ============================================================
+
+int RunAudioCapture(const char* wavPath, double seconds);
+
+// ============================================================
+// Video Export (BreakBlocks.exe /export [seconds])
+// ============================================================
+
+int RunExport(const char* path, double seconds, uint32_t seed);
+
+// ============================================================
+// Planner (BreakBlocks.exe /plan [rollouts per move])
+// ============================================================
+
+int RunPlanner(int rollouts);
+
+// ============================================================
+// Fuzzing (breakblocks --fuzz [cases] [seed], or libFuzzer)
+// ============================================================
+
+int RunFuzzer(int cases, uint32_t seed);
+
+// ============================================================
+// Golden Traces (breakblocks --golden record | check [corpus])
+// ============================================================
+
+static const char* const GOLDEN_CORPUS = "golden/breakblocks.bbg";
+static const int GOLDEN_SESSIONS = 256;
+static const int GOLDEN_TICKS = 400;
+
+int RunGoldenRecord(const char* path, int sessions, int ticks, uint32_t seed);
+int RunGoldenCheck(const char* path, float tolerance);
+
+#ifdef __linux__
+// ============================================================
+// Game Server (breakblocks --server [port | unix:path])
+// ============================================================
+
+int RunServer(const char* address, const char* telemetryPrefix, const char* scorePath);
+int RunLoopbackTest(int sessions, int ticks);
+#endif // __linux__
@@ -0,0 +1,126 @@
+#include "Game.h"
+#include "BreakBlocksEnv.h"
+
+// ============================================================
+// Vectorized Environment (C API, see BreakBlocksEnv.h)
+// ============================================================
+
+static_assert(BALL_CAP == BB_OBS_BALLS, "observation has one slot per ball");
+static_assert(BRICK_ROWS * BRICK_COLS <= BB_BRICK_BYTES * 8, "brick bitmap too small");
+
+struct BBVecEnv
+{
+    TaggedVector<GameState, MEM_ENV> games;
+    TaggedVector<uint32_t, MEM_ENV> seeds;
+    TaggedVector<uint32_t, MEM_ENV> episodes;
+
+    MEM_TAGGED_NEW(MEM_ENV)
+};
+
+// Game for env 'i': its seed for the first episode, then a fresh stream
+// derived from it for every auto-reset.
+static void ResetEnvGame(BBVecEnv* env, int i)
+{
+    uint32_t seed = env->seeds[i] ^ (env->episodes[i]++ * 2654435761u);
+    InitGameState(env->games[i], seed);
+}
+
+// Writes a game's observation; dimensions are the default board's.
+static inline void WriteObservation(const GameState& g, float* obs, uint8_t* bricks)
+{
+    obs[0] = g.paddle.x;
+    obs[1] = g.paddle.w;
+    for (int b = 0; b < BALL_CAP; ++b)
+    {
+        const Ball& ball = g.ball[b];
+        float* o = obs + 2 + b * 5;
+        o[0] = ball.x;
+        o[1] = ball.y;
+        o[2] = ball.vx;
+        o[3] = ball.vy;
+        o[4] = ball.alive ? 1.f : 0.f;
+    }
+
+    uint64_t bits = 0;
+    for (int i = 0; i < BRICK_ROWS * BRICK_COLS; ++i)
+        bits |= (uint64_t)(BrickHits(g, i) != 0) << i;
+    memcpy(bricks, &bits, BB_BRICK_BYTES); // little-endian: byte i / 8, bit i & 7
+}
+
+extern "C" {
+
+BBVecEnv* bb_vec_create(int count)
+{
+    if (count <= 0) return nullptr;
+    InitPaddleBounceTable();
+
+    BBVecEnv* env = new BBVecEnv;
+    env->games.resize(count);
+    env->seeds.resize(count);
+    env->episodes.assign(count, 0);
+    for (int i = 0; i < count; ++i)
+    {
+        env->seeds[i] = (uint32_t)i + 1;
+        ResetEnvGame(env, i);
+    }
+    return env;
+}
+
+void bb_vec_destroy(BBVecEnv* env)
+{
+    delete env;
+}
+
+int bb_vec_count(const BBVecEnv* env)
+{
+    return env ? (int)env->games.size() : 0;
+}
+
+void bb_vec_layout(int* obsFloats, int* brickBytes)
+{
+    if (obsFloats) *obsFloats = BB_OBS_FLOATS;
+    if (brickBytes) *brickBytes = BB_BRICK_BYTES;
+}
+
+void bb_vec_reset(BBVecEnv* env, const uint32_t* seeds, float* obs, uint8_t* bricks)
+{
+    int count = (int)env->games.size();
+    for (int i = 0; i < count; ++i)
+    {
+        env->seeds[i] = seeds ? seeds[i] : (uint32_t)i + 1;
+        env->episodes[i] = 0;
+        ResetEnvGame(env, i);
+        WriteObservation(env->games[i], obs + i * BB_OBS_FLOATS, bricks + i * BB_BRICK_BYTES);
+    }
+}
+
+// One UpdateGame per env, with the action standing in for the input layer:
+// the paddle moves by action * PADDLE_SPEED and the ball is always launched.
+void bb_vec_step(BBVecEnv* env, const float* actions,
+                 float* obs, uint8_t* bricks, float* rewards, uint8_t* dones)
+{
+    int count = (int)env->games.size();
+    for (int i = 0; i < count; ++i)
+    {
+        GameState& g = env->games[i];
+        int score = g.score, lives = g.lives;
+
+        TickInput in;
+        in.paddleMove = Clamp(actions[i], -1.f, 1.f) * PADDLE_SPEED;
+        in.launch = true;
+        UpdateGame(g, in);
+
+        rewards[i] = (g.score - score) * 0.01f - (float)max(lives - g.lives, 0);
+        dones[i] = g.gameOver ? 1 : 0;
+        if (!g.gameOver)
+            WriteObservation(g, obs + i * BB_OBS_FLOATS, bricks + i * BB_BRICK_BYTES);
+
+        if (dones[i])
+        {
+            ResetEnvGame(env, i);
+            WriteObservation(g, obs + i * BB_OBS_FLOATS, bricks + i * BB_BRICK_BYTES);
+        }
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,121 @@
+"""Thin ctypes binding over the BreakBlocks vectorized environment.
+
+The C side (BreakBlocksEnv.h) writes observations straight into buffers
+owned here, so reset() and step() copy nothing: the arrays they return are
+the same objects every call and are overwritten by the next one.
+
+    env = VecEnv(256)
+    obs, bricks = env.reset(seeds=range(256))
+    obs, bricks, rewards, dones = env.step(actions)   # actions: 256 floats in [-1, 1]
+
+Buffers are numpy arrays when numpy is installed (obs shaped (N, OBS_FLOATS),
+bricks (N, BRICK_BYTES)), flat array.array objects otherwise.
+
+Build the library first:
+    g++ -std=c++14 -O2 -shared -fPIC -DBREAKBLOCKS_LIBRARY *.cpp -o libbreakblocks.so
+"""
+
+import array
+import ctypes
+import os
+import sys
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+
+def _default_library():
+    name = "breakblocks.dll" if sys.platform == "win32" else "libbreakblocks.so"
+    return os.path.join(os.path.dirname(os.path.abspath(__file__)), name)
+
+
+def _load(path):
+    lib = ctypes.CDLL(path)
+    f32, u8, u32 = ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_uint8), ctypes.POINTER(ctypes.c_uint32)
+
+    lib.bb_vec_create.argtypes = [ctypes.c_int]
+    lib.bb_vec_create.restype = ctypes.c_void_p
+    lib.bb_vec_destroy.argtypes = [ctypes.c_void_p]
+    lib.bb_vec_destroy.restype = None
+    lib.bb_vec_layout.argtypes = [ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+    lib.bb_vec_layout.restype = None
+    lib.bb_vec_reset.argtypes = [ctypes.c_void_p, u32, f32, u8]
+    lib.bb_vec_reset.restype = None
+    lib.bb_vec_step.argtypes = [ctypes.c_void_p, f32, f32, u8, f32, u8]
+    lib.bb_vec_step.restype = None
+    return lib
+
+
+def _buffer(typecode, rows, cols):
+    if np is not None:
+        dtype = np.float32 if typecode == "f" else np.uint8
+        return np.zeros((rows, cols) if cols > 1 else rows, dtype)
+    return array.array(typecode, bytes(rows * cols * (4 if typecode == "f" else 1)))
+
+
+def _pointer(buf, ctype):
+    """Pointer into buf's own memory (no copy); buf must stay alive."""
+    return ctypes.cast((ctypes.c_char * 0).from_buffer(buf), ctypes.POINTER(ctype))
+
+
+class VecEnv:
+    def __init__(self, num_envs, library=None):
+        self._lib = _load(library or _default_library())
+        self.num_envs = num_envs
+        self._env = self._lib.bb_vec_create(num_envs)
+        if not self._env:
+            raise ValueError("num_envs must be positive")
+
+        obs_floats, brick_bytes = ctypes.c_int(), ctypes.c_int()
+        self._lib.bb_vec_layout(ctypes.byref(obs_floats), ctypes.byref(brick_bytes))
+        self.obs_floats, self.brick_bytes = obs_floats.value, brick_bytes.value
+
+        self.obs = _buffer("f", num_envs, self.obs_floats)
+        self.bricks = _buffer("B", num_envs, self.brick_bytes)
+        self.rewards = _buffer("f", num_envs, 1)
+        self.dones = _buffer("B", num_envs, 1)
+        self._actions = _buffer("f", num_envs, 1)
+
+        self._obs_p = _pointer(self.obs, ctypes.c_float)
+        self._bricks_p = _pointer(self.bricks, ctypes.c_uint8)
+        self._rewards_p = _pointer(self.rewards, ctypes.c_float)
+        self._dones_p = _pointer(self.dones, ctypes.c_uint8)
+
+    def reset(self, seeds=None):
+        seeds_p = None
+        if seeds is not None:
+            seed_buf = array.array("I", [int(s) & 0xFFFFFFFF for s in seeds])
+            if len(seed_buf) != self.num_envs:
+                raise ValueError("need one seed per env")
+            seeds_p = _pointer(seed_buf, ctypes.c_uint32)
+        self._lib.bb_vec_reset(self._env, seeds_p, self._obs_p, self._bricks_p)
+        return self.obs, self.bricks
+
+    def step(self, actions):
+        """actions: float32 buffer of num_envs entries (passed through without a
+        copy when it is a contiguous float32 numpy array or array('f'))."""
+        if np is not None and isinstance(actions, np.ndarray) and actions.dtype == np.float32 \
+                and actions.flags.c_contiguous and actions.size == self.num_envs:
+            actions_p = actions.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
+        elif isinstance(actions, array.array) and actions.typecode == "f" and len(actions) == self.num_envs:
+            actions_p = _pointer(actions, ctypes.c_float)
+        else:
+            if len(actions) != self.num_envs:
+                raise ValueError("need one action per env")
+            for i, a in enumerate(actions):
+                self._actions[i] = a
+            actions_p = _pointer(self._actions, ctypes.c_float)
+
+        self._lib.bb_vec_step(self._env, actions_p, self._obs_p, self._bricks_p,
+                              self._rewards_p, self._dones_p)
+        return self.obs, self.bricks, self.rewards, self.dones
+
+    def close(self):
+        if self._env:
+            self._lib.bb_vec_destroy(self._env)
+            self._env = None
+
+    def __del__(self):
+        self.close()